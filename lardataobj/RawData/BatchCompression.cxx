@@ -0,0 +1,217 @@
+/**
+ * @file    BatchCompression.cxx
+ * @brief   Compression and uncompression of many channels at once
+ * @see     BatchCompression.h
+ */
+
+#include "lardataobj/RawData/BatchCompression.h"
+#include "lardataobj/RawData/raw.h"
+#include "lardataobj/RawData/Codec.h"
+#include "lardataobj/RawData/WorkerPool.h"
+#include "lardataobj/RawData/ZeroSuppressor.h" // raw::ZeroSuppressedForHuffman()
+
+// framework libraries
+#include "cetlib_except/exception.h"
+
+// C/C++ standard libraries
+#include <algorithm> // std::max()
+#include <atomic>
+#include <cmath> // std::lround()
+#include <cstddef> // std::size_t
+#include <exception> // std::exception_ptr
+#include <mutex>
+#include <thread>
+#include <utility> // std::move()
+
+
+namespace {
+
+  /// Work space of a thread
+  struct Scratch {
+    std::vector<short> buffer; ///< Huffman-encoded or uncompressed samples
+  }; // struct Scratch
+
+
+  /**
+   * @brief Calls `task(i, scratch)` for all i from 0 to n - 1
+   * @param n number of tasks
+   * @param nThreads number of threads to use (0: one per hardware thread)
+   * @param task the callable object to be executed
+   *
+   * The indices are handed to the threads one at a time. Each thread owns a
+   * Scratch object, passed to all its tasks. The calling thread is one of
+   * the threads, and the others are from the WorkerPool.
+   * If tasks throw, no new task is started, and the exception of the task
+   * with the lowest index is rethrown after all threads are done.
+   */
+  template <typename Task>
+  void parallelFor(std::size_t n, unsigned int nThreads, Task task)
+  {
+    if(nThreads == 0) nThreads = std::max(1U, std::thread::hardware_concurrency());
+    if(nThreads > n) nThreads = n;
+
+    std::atomic<std::size_t> next{ 0 };
+    std::atomic<bool> failed{ false };
+    std::mutex errorMutex;
+    std::size_t errorIndex = n;
+    std::exception_ptr error;
+
+    auto const work = [&]()
+      {
+        Scratch scratch;
+        while(!failed){
+          std::size_t const i = next++;
+          if(i >= n) break;
+          try { task(i, scratch); }
+          catch(...){
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if(i < errorIndex){
+              errorIndex = i;
+              error = std::current_exception();
+            }
+            failed = true;
+          }
+        } // while
+      };
+
+    if(nThreads > 1) raw::details::WorkerPool::Instance().Run(nThreads - 1, work);
+    else work();
+
+    if(error) std::rethrow_exception(error);
+  } // parallelFor()
+
+
+  /// Compresses adc like raw::Compress(), Huffman-encoding via scratch;
+  /// the statistics are filled into record, if not `nullptr`
+  void compressChannel(std::vector<short>&     adc,
+                       raw::Compress_t         compress,
+                       unsigned int            zerothreshold,
+                       int                     pedestal,
+                       int                     nearestneighbor,
+                       Scratch&                scratch,
+                       raw::CompressionRecord* record = nullptr)
+  {
+    if(record || ((compress != raw::kHuffman) && (compress != raw::kZeroHuffman))){
+      raw::CodecParameters params;
+      params.zerothreshold = zerothreshold;
+      params.pedestal = pedestal;
+      params.nearestneighbor = nearestneighbor;
+      params.statistics = record;
+      raw::Compress(adc, compress, params);
+      return;
+    }
+
+    if(compress == raw::kZeroHuffman){
+      raw::ZeroSuppression(adc, zerothreshold, pedestal, nearestneighbor);
+      raw::ZeroSuppressedForHuffman(adc);
+    }
+
+    scratch.buffer.resize(raw::HuffmanMaxCompressedSize(adc.size()));
+    std::size_t const nWords
+      = raw::CompressHuffman(adc.data(), adc.size(), scratch.buffer.data());
+    adc.assign(scratch.buffer.begin(), scratch.buffer.begin() + nWords);
+  } // compressChannel()
+
+
+  /// Returns the pedestal of the digit, rounded to an integer
+  int roundedPedestal(raw::RawDigit const& digit)
+    { return static_cast<int>(std::lround(digit.GetPedestal())); }
+
+} // local namespace
+
+
+namespace raw {
+
+  //----------------------------------------------------------------------
+  void CompressAll(std::vector<std::vector<short>>& adcs,
+                   raw::Compress_t                  compress,
+                   unsigned int                     zerothreshold,
+                   int                              nearestneighbor,
+                   unsigned int                     nThreads /* = 1 */)
+  {
+    parallelFor(adcs.size(), nThreads,
+      [&](std::size_t i, Scratch& scratch)
+        {
+          compressChannel
+            (adcs[i], compress, zerothreshold, 0, nearestneighbor, scratch);
+        }
+      );
+  } // CompressAll()
+
+
+  //----------------------------------------------------------------------
+  void UncompressAll(std::vector<std::vector<short>> const& adcs,
+                     std::vector<std::vector<short>>&       uncompressed,
+                     raw::Compress_t                        compress,
+                     unsigned int                           nThreads /* = 1 */)
+  {
+    if(uncompressed.size() != adcs.size()){
+      throw cet::exception("raw")
+        << "raw::UncompressAll(): " << uncompressed.size()
+        << " buffers for " << adcs.size() << " channels\n";
+    }
+    parallelFor(adcs.size(), nThreads,
+      [&](std::size_t i, Scratch&)
+        { raw::Uncompress(adcs[i], uncompressed[i], compress); }
+      );
+  } // UncompressAll()
+
+
+  //----------------------------------------------------------------------
+  std::vector<raw::RawDigit> CompressAll(std::vector<raw::RawDigit> const& digits,
+                                         raw::Compress_t compress,
+                                         unsigned int    zerothreshold,
+                                         int             nearestneighbor,
+                                         unsigned int    nThreads /* = 1 */,
+                                         raw::CompressionStatistics* statistics /* = nullptr */)
+  {
+    std::vector<raw::RawDigit> compressed(digits.size());
+    std::vector<raw::CompressionRecord> records
+      (statistics? digits.size(): 0);
+    parallelFor(digits.size(), nThreads,
+      [&](std::size_t i, Scratch& scratch)
+        {
+          raw::RawDigit const& digit = digits[i];
+          int const pedestal = roundedPedestal(digit);
+
+          RawDigit::ADCvector_t adc;
+          if(digit.Compression() == raw::kNone) adc = digit.ADCs();
+          else{
+            adc.resize(digit.Samples());
+            raw::Uncompress(digit.ADCs(), adc, pedestal, digit.Compression());
+          }
+
+          compressChannel(adc, compress, zerothreshold, pedestal,
+            nearestneighbor, scratch, statistics? &records[i]: nullptr);
+
+          compressed[i] = raw::RawDigit
+            (digit.Channel(), digit.Samples(), std::move(adc), compress);
+          compressed[i].SetPedestal(digit.GetPedestal(), digit.GetSigma());
+        }
+      );
+    if(statistics){
+      for(std::size_t i = 0; i < digits.size(); ++i)
+        statistics->Add(digits[i].Channel(), records[i]);
+    }
+    return compressed;
+  } // CompressAll()
+
+
+  //----------------------------------------------------------------------
+  std::vector<raw::RawDigit::ADCvector_t> UncompressAll
+    (std::vector<raw::RawDigit> const& digits, unsigned int nThreads /* = 1 */)
+  {
+    std::vector<raw::RawDigit::ADCvector_t> uncompressed(digits.size());
+    parallelFor(digits.size(), nThreads,
+      [&](std::size_t i, Scratch&)
+        {
+          raw::RawDigit const& digit = digits[i];
+          uncompressed[i].resize(digit.Samples());
+          raw::Uncompress(digit.ADCs(), uncompressed[i],
+            roundedPedestal(digit), digit.Compression());
+        }
+      );
+    return uncompressed;
+  } // UncompressAll()
+
+} // namespace raw
@@ -0,0 +1,120 @@
+/**
+ * @file    BatchCompression.h
+ * @brief   Compression and uncompression of many channels at once
+ * @see     BatchCompression.cxx raw.h RawDigit.h
+ *
+ * The channels may be spread over a number of threads; each channel is
+ * processed with the same functions as in raw.h, and the results are stored
+ * in the same order as the input, independently of the number of threads.
+ * By default, all the work is done in the calling thread: jobs already run
+ * in parallel by a framework should not ask for more threads than they are
+ * given.
+ */
+
+#ifndef RAWDATA_BATCHCOMPRESSION_H
+#define RAWDATA_BATCHCOMPRESSION_H
+
+// LArSoft libraries
+#include "lardataobj/RawData/RawDigit.h"
+#include "lardataobj/RawData/CompressionStatistics.h"
+#include "larcoreobj/SimpleTypesAndConstants/RawTypes.h" // raw::Compress_t
+
+// C/C++ standard libraries
+#include <vector>
+
+
+namespace raw {
+
+  /**
+   * @brief Compresses the ADC vectors of many channels
+   * @param adcs uncompressed ADC vectors, replaced by the compressed ones
+   * @param compress type of compression to be applied
+   * @param zerothreshold zero suppression threshold
+   * @param nearestneighbor samples kept around each zero-suppressed block
+   * @param nThreads number of threads to use (default: only the calling one;
+   *        0: one per hardware thread)
+   *
+   * Each vector is compressed as by
+   * `raw::Compress(adc, compress, zerothreshold, nearestneighbor)`.
+   *
+   * The channels are handed to the threads one at a time, so that the load
+   * stays balanced when some channels take longer than others; the calling
+   * thread is one of them, and it does all the work when nThreads is 1.
+   * The other threads are not created by each call, but kept in a pool
+   * shared by all the calls and reused.
+   * Each thread reuses its own work space for all its channels.
+   * If the compression of any channel throws an exception, the one of the
+   * channel with the lowest index is rethrown after all threads are done.
+   */
+  void CompressAll(std::vector<std::vector<short>>& adcs,
+                   raw::Compress_t                  compress,
+                   unsigned int                     zerothreshold,
+                   int                              nearestneighbor,
+                   unsigned int                     nThreads = 1);
+
+  /**
+   * @brief Uncompresses the ADC vectors of many channels
+   * @param adcs compressed ADC vectors
+   * @param uncompressed buffers for the uncompressed data of each channel
+   * @param compress type of compression in all the adcs vectors
+   * @param nThreads number of threads to use (default: only the calling one;
+   *        0: one per hardware thread)
+   * @throw cet::exception if there are not as many buffers as ADC vectors
+   *
+   * Each vector is uncompressed as by
+   * `raw::Uncompress(adcs[i], uncompressed[i], compress)`, and the same
+   * requirements on the size of the buffers apply.
+   * Threads are used as in CompressAll().
+   */
+  void UncompressAll(std::vector<std::vector<short>> const& adcs,
+                     std::vector<std::vector<short>>&       uncompressed,
+                     raw::Compress_t                        compress,
+                     unsigned int                           nThreads = 1);
+
+  /**
+   * @brief Returns a compressed copy of many raw digits
+   * @param digits the raw digits to be compressed
+   * @param compress type of compression to be applied
+   * @param zerothreshold zero suppression threshold, from the pedestal
+   * @param nearestneighbor samples kept around each zero-suppressed block
+   * @param nThreads number of threads to use (default: only the calling one;
+   *        0: one per hardware thread)
+   * @param statistics if not `nullptr`, compression statistics are added here
+   * @return the compressed digits, in the same order as the input ones
+   *
+   * Digits which are already compressed are uncompressed first.
+   * Each digit is then compressed as by `raw::Compress(adc, compress,
+   * zerothreshold, pedestal, nearestneighbor)`, with the pedestal of the digit
+   * rounded to the closest integer. Channel, number of samples, pedestal and
+   * its RMS are copied into the new digits.
+   * Threads are used as in CompressAll().
+   * The statistics of each digit are added to statistics with its channel,
+   * in the order of the digits, after all of them are compressed.
+   */
+  std::vector<raw::RawDigit> CompressAll(std::vector<raw::RawDigit> const& digits,
+                                         raw::Compress_t compress,
+                                         unsigned int    zerothreshold,
+                                         int             nearestneighbor,
+                                         unsigned int    nThreads = 1,
+                                         raw::CompressionStatistics* statistics = nullptr);
+
+  /**
+   * @brief Returns the uncompressed ADC vectors of many raw digits
+   * @param digits the raw digits to be uncompressed
+   * @param nThreads number of threads to use (default: only the calling one;
+   *        0: one per hardware thread)
+   * @return the uncompressed ADC vectors, in the same order as the digits
+   *
+   * Each digit is uncompressed as by
+   * `raw::Uncompress(digit.ADCs(), adc, pedestal, digit.Compression())`, with
+   * the pedestal of the digit rounded to the closest integer, into a vector
+   * of `digit.Samples()` samples.
+   * Threads are used as in CompressAll().
+   */
+  std::vector<raw::RawDigit::ADCvector_t> UncompressAll
+    (std::vector<raw::RawDigit> const& digits, unsigned int nThreads = 1);
+
+} // namespace raw
+
+
+#endif // RAWDATA_BATCHCOMPRESSION_H
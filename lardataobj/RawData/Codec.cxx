@@ -0,0 +1,78 @@
+/**
+ * @file    Codec.cxx
+ * @brief   Registry of the raw data compression algorithms
+ * @see     Codec.h
+ *
+ * The built-in codecs are implemented in raw.cxx.
+ */
+
+#include "lardataobj/RawData/Codec.h"
+
+// framework libraries
+#include "cetlib_except/exception.h"
+
+// C/C++ standard libraries
+#include <mutex> // std::lock_guard
+#include <utility> // std::move()
+
+
+namespace raw {
+
+  //----------------------------------------------------------------------
+  CodecRegistry& CodecRegistry::Instance()
+  {
+    static CodecRegistry registry;
+    return registry;
+  } // CodecRegistry::Instance()
+
+
+  //----------------------------------------------------------------------
+  CodecRegistry::CodecRegistry()
+  {
+    for(std::atomic<Codec const*>& codec: fCodecs) codec.store(nullptr);
+    details::RegisterBuiltinCodecs(*this);
+  }
+
+
+  //----------------------------------------------------------------------
+  void CodecRegistry::Register
+    (raw::Compress_t compress, std::unique_ptr<Codec const> codec)
+  {
+    if(!codec){
+      throw cet::exception("raw")
+        << "raw::CodecRegistry: no codec for compression #"
+        << ((int) compress) << "\n";
+    }
+
+    std::size_t const i = compress;
+    if(i >= MaxCompressTypes){
+      throw cet::exception("raw")
+        << "raw::CodecRegistry: compression #" << ((int) compress)
+        << " is out of the supported range (0-" << (MaxCompressTypes - 1)
+        << ")\n";
+    }
+
+    std::lock_guard<std::mutex> lock(fMutex);
+    if(fCodecs[i].load()){
+      throw cet::exception("raw")
+        << "raw::CodecRegistry: a codec for compression #"
+        << ((int) compress) << " is already registered\n";
+    }
+    fOwned.push_back(std::move(codec));
+    fCodecs[i].store(fOwned.back().get(), std::memory_order_release);
+  } // CodecRegistry::Register()
+
+
+  //----------------------------------------------------------------------
+  Codec const& CodecRegistry::Get(raw::Compress_t compress) const
+  {
+    Codec const* codec = Find(compress);
+    if(!codec){
+      throw cet::exception("raw")
+        << "raw::CodecRegistry: no codec registered for compression #"
+        << ((int) compress) << "\n";
+    }
+    return *codec;
+  } // CodecRegistry::Get()
+
+} // namespace raw
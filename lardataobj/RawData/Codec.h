@@ -0,0 +1,189 @@
+/**
+ * @file    Codec.h
+ * @brief   Interface of the raw data compression algorithms, and their registry
+ * @see     Codec.cxx raw.h
+ *
+ * raw::Compress() and raw::Uncompress() find the algorithm for the
+ * compression type (raw::Compress_t, also stored in raw::RawDigit) in the
+ * raw::CodecRegistry. The algorithms of raw.h are registered as built-ins,
+ * and new ones can be added without changing any of the callers.
+ */
+
+#ifndef RAWDATA_CODEC_H
+#define RAWDATA_CODEC_H
+
+// LArSoft libraries
+#include "lardataobj/RawData/raw.h" // raw::HuffmanIndex
+#include "lardataobj/RawData/CompressionStatistics.h"
+#include "larcoreobj/SimpleTypesAndConstants/RawTypes.h" // raw::Compress_t
+
+// Boost libraries
+#include <boost/circular_buffer.hpp>
+
+// C/C++ standard libraries
+#include <array>
+#include <atomic>
+#include <cstddef> // std::size_t
+#include <memory> // std::unique_ptr
+#include <mutex>
+#include <optional>
+#include <vector>
+
+
+namespace raw {
+
+  /**
+   * @brief Settings for the compression of a waveform
+   *
+   * The settings which are not specified select the same algorithms as the
+   * raw::Compress() overloads missing those arguments; for example, zero
+   * suppression without nearestneighbor keeps a single sample after the last
+   * one above threshold in each block.
+   */
+  struct CodecParameters {
+
+    /// Zero suppression threshold
+    unsigned int zerothreshold = 5;
+
+    /// Pedestal the threshold is applied from (unset: 0, no sticky codes)
+    std::optional<int> pedestal;
+
+    /// Number of samples kept around each block of zero-suppressed data
+    std::optional<int> nearestneighbor;
+
+    /// Whether to ignore ADC sticky codes (used only with a pedestal)
+    bool fADCStickyCodeFeature = false;
+
+    /// Waveforms of the neighbouring channels for zero suppression, if any
+    boost::circular_buffer<std::vector<short>> const* neighbors = nullptr;
+
+    /// Filled with the statistics of the compression, if not `nullptr`
+    /// (sizes by raw::Compress(), counts specific to the algorithm by the codec)
+    CompressionRecord* statistics = nullptr;
+
+  }; // struct CodecParameters
+
+
+  /**
+   * @brief Interface of a compression algorithm
+   *
+   * A codec is used concurrently by many threads, and it must not change
+   * its state when encoding or decoding.
+   */
+  class Codec {
+
+  public:
+
+    virtual ~Codec() = default;
+
+    /**
+     * @brief Compresses a waveform
+     * @param adc uncompressed waveform, replaced by the compressed one
+     * @param params compression settings
+     */
+    virtual void Encode
+      (std::vector<short>& adc, CodecParameters const& params) const = 0;
+
+    /**
+     * @brief Uncompresses a waveform
+     * @param adc compressed data
+     * @param uncompressed buffer to be filled with uncompressed data
+     * @param pedestal value of the samples suppressed by the compression
+     * @see raw::Uncompress()
+     */
+    virtual void Decode(std::vector<short> const& adc,
+                        std::vector<short>&       uncompressed,
+                        int                       pedestal) const = 0;
+
+    /**
+     * @brief Uncompresses a window of ticks of a waveform
+     * @param adc compressed data
+     * @param uncompressed filled with the ticks from tickBegin to tickEnd
+     * @param pedestal value of the samples suppressed by the compression
+     * @param tickBegin first tick of the window
+     * @param tickEnd tick after the last one of the window
+     * @param index checkpoints of the data (may be ignored), or `nullptr`
+     * @see the windowed raw::Uncompress()
+     */
+    virtual void DecodeRange(std::vector<short> const& adc,
+                             std::vector<short>&       uncompressed,
+                             int                       pedestal,
+                             std::size_t               tickBegin,
+                             std::size_t               tickEnd,
+                             HuffmanIndex const*       index) const = 0;
+
+  }; // class Codec
+
+
+  /**
+   * @brief Collection of the known compression algorithms
+   *
+   * Codecs are registered with the compression type they implement, which
+   * is the one stored in raw::RawDigit. The algorithms for raw::kNone,
+   * raw::kHuffman, raw::kZeroSuppression and raw::kZeroHuffman are registered
+   * when the registry is first used.
+   *
+   * The registry can be used from many threads. Codecs are never removed or
+   * replaced, so that the references returned stay valid. The codecs are
+   * kept in a table indexed by the compression type, which is looked up
+   * without any lock, since raw::Compress() and raw::Uncompress() look it up
+   * for each waveform; compression types from 0 to `MaxCompressTypes - 1`
+   * can be registered.
+   */
+  class CodecRegistry {
+
+  public:
+
+    /// Number of compression types which can have a codec
+    static constexpr std::size_t MaxCompressTypes = 64;
+
+    /// Returns the registry
+    static CodecRegistry& Instance();
+
+    /**
+     * @brief Adds a codec for the specified compression type
+     * @param compress the compression type implemented by the codec
+     * @param codec the codec
+     * @throw cet::exception if a codec for compress is already registered,
+     *        or if compress is not smaller than `MaxCompressTypes`
+     */
+    void Register(raw::Compress_t compress, std::unique_ptr<Codec const> codec);
+
+    /// Returns the codec for compress, `nullptr` if none is registered
+    Codec const* Find(raw::Compress_t compress) const
+      {
+        std::size_t const i = compress;
+        return (i < MaxCompressTypes)
+          ? fCodecs[i].load(std::memory_order_acquire): nullptr;
+      }
+
+    /// Returns the codec for compress
+    /// @throw cet::exception if none is registered
+    Codec const& Get(raw::Compress_t compress) const;
+
+  private:
+
+    std::mutex fMutex; ///< serializes the registrations
+
+    /// Codec of each compression type, `nullptr` if none
+    std::array<std::atomic<Codec const*>, MaxCompressTypes> fCodecs;
+
+    /// Owners of the registered codecs
+    std::vector<std::unique_ptr<Codec const>> fOwned;
+
+    CodecRegistry();
+
+  }; // class CodecRegistry
+
+
+  namespace details {
+
+    /// Registers the codecs of the compression types of raw.h
+    void RegisterBuiltinCodecs(CodecRegistry& registry);
+
+  } // namespace details
+
+} // namespace raw
+
+
+#endif // RAWDATA_CODEC_H
@@ -0,0 +1,185 @@
+/**
+ * @file    CoherentCompression.cxx
+ * @brief   Compression of channels sharing coherent noise
+ * @see     CoherentCompression.h
+ */
+
+#include "lardataobj/RawData/CoherentCompression.h"
+#include "lardataobj/RawData/EntropyCodec.h"
+#include "lardataobj/RawData/raw.h"
+
+// framework libraries
+#include "cetlib_except/exception.h"
+
+// C/C++ standard libraries
+#include <algorithm> // std::nth_element(), std::min()
+#include <cmath> // std::lround()
+#include <utility> // std::move()
+
+
+namespace {
+
+  /// Returns the median of the waveforms from first to last at each tick
+  std::vector<short> commonMode(std::vector<std::vector<short>> const& adcs,
+                                std::size_t first, std::size_t last,
+                                std::size_t nTicks)
+  {
+    std::vector<short> median(nTicks);
+    std::vector<short> values(last - first);
+    auto const middle = values.begin() + values.size() / 2;
+    for(std::size_t tick = 0; tick < nTicks; ++tick){
+      for(std::size_t i = first; i < last; ++i) values[i - first] = adcs[i][tick];
+      std::nth_element(values.begin(), middle, values.end());
+      median[tick] = *middle;
+    }
+    return median;
+  } // commonMode()
+
+
+  /// Appends the compressed stream to data, and its end to offsets
+  void appendStream(std::vector<short>&     stream,
+                    std::vector<short>&     data,
+                    std::vector<ULong64_t>& offsets)
+  {
+    raw::CompressEntropy(stream);
+    data.insert(data.end(), stream.begin(), stream.end());
+    offsets.push_back(data.size());
+  } // appendStream()
+
+
+  /// Uncompresses a stream of the block
+  void uncompressStream(raw::CompressedDigitBlock const& block,
+                        std::size_t                      stream,
+                        std::vector<short>&              uncompressed)
+  {
+    raw::UncompressEntropy
+      (block.StreamData(stream), block.StreamSize(stream), uncompressed);
+    if(uncompressed.size() != block.Samples()){
+      throw cet::exception("raw")
+        << "raw::UncompressCoherent(): stream #" << stream << " has "
+        << uncompressed.size() << " samples instead of " << block.Samples()
+        << "\n";
+    }
+  } // uncompressStream()
+
+
+  /// Adds the common mode to the differences of a channel from it
+  void addCommonMode(std::vector<short>& adc, std::vector<short> const& common)
+  {
+    // 16-bit arithmetic wraps around both ways, so the sum is exact
+    for(std::size_t tick = 0; tick < adc.size(); ++tick)
+      adc[tick] = static_cast<short>(adc[tick] + common[tick]);
+  } // addCommonMode()
+
+} // local namespace
+
+
+namespace raw {
+
+  //----------------------------------------------------------------------
+  CompressedDigitBlock CompressCoherent(
+    std::vector<raw::ChannelID_t> const&   channels,
+    std::vector<std::vector<short>> const& adcs,
+    unsigned int                           groupSize
+    )
+  {
+    if(groupSize == 0){
+      throw cet::exception("raw")
+        << "raw::CompressCoherent(): groups of channels can't be empty\n";
+    }
+    if(channels.size() != adcs.size()){
+      throw cet::exception("raw")
+        << "raw::CompressCoherent(): " << channels.size() << " channels for "
+        << adcs.size() << " waveforms\n";
+    }
+    std::size_t const nTicks = adcs.empty()? 0: adcs.front().size();
+    for(std::size_t i = 0; i < adcs.size(); ++i){
+      if(adcs[i].size() == nTicks) continue;
+      throw cet::exception("raw")
+        << "raw::CompressCoherent(): channel " << channels[i] << " has "
+        << adcs[i].size() << " samples instead of " << nTicks << "\n";
+    }
+
+    std::vector<short> data;
+    std::vector<ULong64_t> offsets{ 0 };
+    std::vector<short> stream;
+    for(std::size_t first = 0; first < adcs.size(); first += groupSize){
+      std::size_t const last = std::min<std::size_t>(first + groupSize, adcs.size());
+
+      std::vector<short> const common = commonMode(adcs, first, last, nTicks);
+      stream = common;
+      appendStream(stream, data, offsets);
+
+      for(std::size_t i = first; i < last; ++i){
+        stream.resize(nTicks);
+        for(std::size_t tick = 0; tick < nTicks; ++tick)
+          stream[tick] = static_cast<short>(adcs[i][tick] - common[tick]);
+        appendStream(stream, data, offsets);
+      } // for channels
+    } // for groups
+
+    return CompressedDigitBlock
+      (channels, nTicks, groupSize, std::move(data), std::move(offsets));
+  } // CompressCoherent()
+
+
+  //----------------------------------------------------------------------
+  CompressedDigitBlock CompressCoherent
+    (std::vector<raw::RawDigit> const& digits, unsigned int groupSize)
+  {
+    std::vector<raw::ChannelID_t> channels;
+    channels.reserve(digits.size());
+    std::vector<std::vector<short>> adcs(digits.size());
+    for(std::size_t i = 0; i < digits.size(); ++i){
+      raw::RawDigit const& digit = digits[i];
+      channels.push_back(digit.Channel());
+      if(digit.Compression() == raw::kNone){
+        adcs[i] = digit.ADCs();
+        continue;
+      }
+      adcs[i].resize(digit.Samples());
+      raw::Uncompress(digit.ADCs(), adcs[i],
+        static_cast<int>(std::lround(digit.GetPedestal())), digit.Compression());
+    } // for
+    return CompressCoherent(channels, adcs, groupSize);
+  } // CompressCoherent()
+
+
+  //----------------------------------------------------------------------
+  std::vector<std::vector<short>> UncompressCoherent
+    (CompressedDigitBlock const& block)
+  {
+    std::vector<std::vector<short>> adcs(block.NChannels());
+    std::vector<short> common;
+    for(std::size_t group = 0; group < block.NGroups(); ++group){
+      uncompressStream(block, block.CommonModeStream(group), common);
+      std::size_t const first = group * block.GroupSize();
+      std::size_t const last
+        = std::min<std::size_t>(first + block.GroupSize(), block.NChannels());
+      for(std::size_t i = first; i < last; ++i){
+        uncompressStream(block, block.ChannelStream(i), adcs[i]);
+        addCommonMode(adcs[i], common);
+      }
+    } // for groups
+    return adcs;
+  } // UncompressCoherent()
+
+
+  //----------------------------------------------------------------------
+  void UncompressCoherent(CompressedDigitBlock const& block,
+                          std::size_t                 channelIndex,
+                          std::vector<short>&         uncompressed)
+  {
+    if(channelIndex >= block.NChannels()){
+      throw cet::exception("raw")
+        << "raw::UncompressCoherent(): no channel #" << channelIndex
+        << " in a block of " << block.NChannels() << "\n";
+    }
+    std::vector<short> common;
+    uncompressStream(block,
+      block.CommonModeStream(channelIndex / block.GroupSize()), common);
+    uncompressStream(block, block.ChannelStream(channelIndex), uncompressed);
+    addCommonMode(uncompressed, common);
+  } // UncompressCoherent()
+
+} // namespace raw
@@ -0,0 +1,84 @@
+/**
+ * @file    CoherentCompression.h
+ * @brief   Compression of channels sharing coherent noise
+ * @see     CoherentCompression.cxx CompressedDigitBlock.h EntropyCodec.h
+ *
+ * Neighbouring channels pick up the same noise, which per-channel
+ * compression has to encode again for each of them. Here the channels are
+ * split in groups, and each sample is predicted from the previous one in the
+ * same channel and from the change of the median of the group at that tick
+ * (its common mode). The common mode is stored once per group, and each
+ * channel stores its difference from it; all the streams are compressed with
+ * raw::CompressEntropy(), which encodes the differences between consecutive
+ * samples.
+ */
+
+#ifndef RAWDATA_COHERENTCOMPRESSION_H
+#define RAWDATA_COHERENTCOMPRESSION_H
+
+// LArSoft libraries
+#include "lardataobj/RawData/CompressedDigitBlock.h"
+#include "lardataobj/RawData/RawDigit.h"
+#include "larcoreobj/SimpleTypesAndConstants/RawTypes.h" // raw::ChannelID_t
+
+// C/C++ standard libraries
+#include <cstddef> // std::size_t
+#include <vector>
+
+
+namespace raw {
+
+  /**
+   * @brief Compresses many channels together
+   * @param channels the channels, in the order of their waveforms
+   * @param adcs uncompressed waveforms of all the channels
+   * @param groupSize number of consecutive channels sharing a common mode
+   * @return the compressed block
+   * @throw cet::exception if the channels do not all have the same number of
+   *        samples, if there is not a channel for each waveform, or if
+   *        groupSize is 0
+   *
+   * Channels should be sorted so that the ones in the same group share the
+   * same noise (e.g. the ones connected to the same front-end board).
+   * The common mode of a group is the median of the channels at each tick.
+   * Uncompression reproduces the waveforms exactly.
+   */
+  CompressedDigitBlock CompressCoherent(
+    std::vector<raw::ChannelID_t> const&   channels,
+    std::vector<std::vector<short>> const& adcs,
+    unsigned int                           groupSize
+    );
+
+  /**
+   * @brief Compresses the waveforms of raw digits together
+   * @param digits the raw digits to be compressed
+   * @param groupSize number of consecutive channels sharing a common mode
+   * @return the compressed block
+   * @see CompressCoherent()
+   *
+   * Digits which are compressed are uncompressed first.
+   */
+  CompressedDigitBlock CompressCoherent
+    (std::vector<raw::RawDigit> const& digits, unsigned int groupSize);
+
+  /// Returns the uncompressed waveforms of all the channels in the block
+  std::vector<std::vector<short>> UncompressCoherent
+    (CompressedDigitBlock const& block);
+
+  /**
+   * @brief Uncompresses the waveform of a single channel
+   * @param block the compressed data
+   * @param channelIndex index of the channel in block.Channels()
+   * @param uncompressed resized and filled with the waveform
+   *
+   * Only the common mode of the group of the channel is uncompressed besides
+   * the channel data.
+   */
+  void UncompressCoherent(CompressedDigitBlock const& block,
+                          std::size_t                 channelIndex,
+                          std::vector<short>&         uncompressed);
+
+} // namespace raw
+
+
+#endif // RAWDATA_COHERENTCOMPRESSION_H
@@ -0,0 +1,64 @@
+/** ****************************************************************************
+ * @file CompressedDigitBlock.cxx
+ * @brief Waveforms of many channels compressed together
+ * @see  CompressedDigitBlock.h CoherentCompression.h
+ *
+ * ****************************************************************************/
+
+#include "lardataobj/RawData/CompressedDigitBlock.h"
+
+// framework libraries
+#include "cetlib_except/exception.h"
+
+// C/C++ standard libraries
+#include <algorithm> // std::is_sorted()
+#include <utility> // std::move()
+
+
+namespace raw{
+
+  //----------------------------------------------------------------------
+  CompressedDigitBlock::CompressedDigitBlock()
+    : fChannels()
+    , fSamples(0)
+    , fGroupSize(0)
+    , fData()
+    , fOffsets()
+  {}
+
+
+  //----------------------------------------------------------------------
+  CompressedDigitBlock::CompressedDigitBlock(
+    std::vector<raw::ChannelID_t> channels,
+    ULong64_t                     samples,
+    unsigned int                  groupSize,
+    std::vector<short>            data,
+    std::vector<ULong64_t>        offsets
+  )
+    : fChannels(std::move(channels))
+    , fSamples(samples)
+    , fGroupSize(groupSize)
+    , fData(std::move(data))
+    , fOffsets(std::move(offsets))
+  {
+    if((fGroupSize == 0) && !fChannels.empty()){
+      throw cet::exception("CompressedDigitBlock")
+        << "groups of channels can't be empty\n";
+    }
+    size_t const nStreams = NGroups() + NChannels();
+    if(fOffsets.size() != nStreams + 1){
+      throw cet::exception("CompressedDigitBlock")
+        << fOffsets.size() << " offsets for " << nStreams
+        << " streams (expected " << (nStreams + 1) << ")\n";
+    }
+    if((fOffsets.front() != 0) || (fOffsets.back() != fData.size())
+      || !std::is_sorted(fOffsets.begin(), fOffsets.end()))
+    {
+      throw cet::exception("CompressedDigitBlock")
+        << "stream offsets do not match the " << fData.size()
+        << " words of data\n";
+    }
+  } // CompressedDigitBlock::CompressedDigitBlock()
+
+} // namespace raw
+////////////////////////////////////////////////////////////////////////
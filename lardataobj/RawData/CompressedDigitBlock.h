@@ -0,0 +1,141 @@
+/** ****************************************************************************
+ * @file CompressedDigitBlock.h
+ * @brief Waveforms of many channels compressed together
+ * @see  CompressedDigitBlock.cxx CoherentCompression.h
+ *
+ * Compression/uncompression utilities are declared in
+ * lardataobj/RawData/CoherentCompression.h .
+ *
+ * ****************************************************************************/
+
+#ifndef RAWDATA_COMPRESSEDDIGITBLOCK_H
+#define RAWDATA_COMPRESSEDDIGITBLOCK_H
+
+// C/C++ standard libraries
+#include <cstdlib> // size_t
+#include <vector>
+
+// LArSoft libraries
+#include "larcoreobj/SimpleTypesAndConstants/RawTypes.h" // raw::ChannelID_t
+
+// ROOT includes
+#include "RtypesCore.h"
+
+
+namespace raw {
+
+  /**
+   * @brief Waveforms of a block of channels, compressed together
+   *
+   * The block holds channels (for example, a plane) with the same number of
+   * samples, split in groups of GroupSize() consecutive channels (the last
+   * group may be smaller). For each group, the data includes the common mode
+   * of the group at each tick, followed by the difference of each channel
+   * from it; each of these streams is compressed independently, and the
+   * offsets of all of them in Data() are stored, followed by the size of the
+   * data.
+   *
+   * The content is created by raw::CompressCoherent(), and it is used by
+   * raw::UncompressCoherent().
+   */
+  class CompressedDigitBlock {
+
+  public:
+
+    /// Default constructor: an empty block
+    CompressedDigitBlock();
+
+    /**
+     * @brief Constructor: sets all the data
+     * @param channels channels in the block, in the order of their data
+     * @param samples number of samples of each channel
+     * @param groupSize number of channels with a common mode in each group
+     * @param data compressed data
+     * @param offsets start of the data of each stream, then the data size
+     */
+    CompressedDigitBlock(std::vector<raw::ChannelID_t> channels,
+                         ULong64_t                     samples,
+                         unsigned int                  groupSize,
+                         std::vector<short>            data,
+                         std::vector<ULong64_t>        offsets);
+
+    ///@{
+    ///@name Accessors
+
+    /// Number of channels in the block
+    size_t                               NChannels()      const;
+
+    /// The channels in the block, in the order of their data
+    std::vector<raw::ChannelID_t> const& Channels()       const;
+
+    /// Number of samples in the uncompressed data of each channel
+    ULong64_t                            Samples()        const;
+
+    /// Number of channels sharing the same common mode
+    unsigned int                         GroupSize()      const;
+
+    /// Number of groups of channels
+    size_t                               NGroups()        const;
+
+    /// All the compressed data
+    std::vector<short> const&            Data()           const;
+
+    /// Offset of each stream in the data, followed by the data size
+    std::vector<ULong64_t> const&        Offsets()        const;
+
+    /// Index of the stream of the common mode of a group
+    size_t      CommonModeStream(size_t group)          const;
+
+    /// Index of the stream of the channel with the specified index
+    size_t      ChannelStream(size_t channelIndex)      const;
+
+    /// Pointer to the start of the data of a stream
+    short const* StreamData(size_t stream)              const;
+
+    /// Number of words of the data of a stream
+    size_t      StreamSize(size_t stream)               const;
+    ///@}
+
+
+  private:
+    std::vector<raw::ChannelID_t> fChannels; ///< channels in the block
+    ULong64_t              fSamples;   ///< number of ticks of each channel
+    unsigned int           fGroupSize; ///< number of channels in each group
+    std::vector<short>     fData;      ///< compressed data of all the streams
+    std::vector<ULong64_t> fOffsets;   ///< start of each stream, and data size
+
+  }; // class CompressedDigitBlock
+
+
+} // namespace raw
+
+
+//------------------------------------------------------------------------------
+//--- inline implementation
+//---
+
+inline size_t raw::CompressedDigitBlock::NChannels() const
+  { return fChannels.size(); }
+inline std::vector<raw::ChannelID_t> const& raw::CompressedDigitBlock::Channels() const
+  { return fChannels; }
+inline ULong64_t raw::CompressedDigitBlock::Samples() const
+  { return fSamples; }
+inline unsigned int raw::CompressedDigitBlock::GroupSize() const
+  { return fGroupSize; }
+inline size_t raw::CompressedDigitBlock::NGroups() const
+  { return (fGroupSize == 0)? 0: (fChannels.size() + fGroupSize - 1) / fGroupSize; }
+inline std::vector<short> const& raw::CompressedDigitBlock::Data() const
+  { return fData; }
+inline std::vector<ULong64_t> const& raw::CompressedDigitBlock::Offsets() const
+  { return fOffsets; }
+inline size_t raw::CompressedDigitBlock::CommonModeStream(size_t group) const
+  { return group * (fGroupSize + 1); }
+inline size_t raw::CompressedDigitBlock::ChannelStream(size_t channelIndex) const
+  { return CommonModeStream(channelIndex / fGroupSize) + 1 + channelIndex % fGroupSize; }
+inline short const* raw::CompressedDigitBlock::StreamData(size_t stream) const
+  { return fData.data() + fOffsets[stream]; }
+inline size_t raw::CompressedDigitBlock::StreamSize(size_t stream) const
+  { return fOffsets[stream + 1] - fOffsets[stream]; }
+
+
+#endif // RAWDATA_COMPRESSEDDIGITBLOCK_H
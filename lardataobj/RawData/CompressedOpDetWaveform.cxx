@@ -0,0 +1,105 @@
+/**
+ * @file    CompressedOpDetWaveform.cxx
+ * @brief   Optical detector waveform with compressed samples
+ * @see     CompressedOpDetWaveform.h
+ */
+
+#include "lardataobj/RawData/CompressedOpDetWaveform.h"
+#include "lardataobj/RawData/Codec.h"
+#include "lardataobj/RawData/raw.h"
+
+// framework libraries
+#include "cetlib_except/exception.h"
+
+// C/C++ standard libraries
+#include <algorithm> // std::nth_element()
+
+
+namespace {
+
+  /// Returns compression settings with the specified values
+  raw::CodecParameters makeParameters
+    (short baseline, unsigned int zerothreshold, int nearestneighbor)
+  {
+    raw::CodecParameters params;
+    params.zerothreshold = zerothreshold;
+    params.pedestal = baseline;
+    params.nearestneighbor = nearestneighbor;
+    return params;
+  }
+
+} // local namespace
+
+
+namespace raw {
+
+  //----------------------------------------------------------------------
+  CompressedOpDetWaveform::CompressedOpDetWaveform
+    (raw::OpDetWaveform const& waveform,
+     raw::Compress_t           compress,
+     short                     baseline,
+     unsigned int              zerothreshold,
+     int                       nearestneighbor /* = 0 */)
+    : CompressedOpDetWaveform(waveform, compress,
+        makeParameters(baseline, zerothreshold, nearestneighbor))
+    {}
+
+
+  //----------------------------------------------------------------------
+  CompressedOpDetWaveform::CompressedOpDetWaveform
+    (raw::OpDetWaveform const&   waveform,
+     raw::Compress_t             compress,
+     raw::CodecParameters const& params /* = {} */)
+    : fChannel(waveform.ChannelNumber())
+    , fTimeStamp(waveform.TimeStamp())
+    , fSamples(waveform.size())
+    , fBaseline(params.pedestal? *params.pedestal: EstimateBaseline(waveform))
+    , fCompression(compress)
+    , fADC(waveform.begin(), waveform.end())
+  {
+    if(!raw::CodecRegistry::Instance().Find(compress)){
+      throw cet::exception("CompressedOpDetWaveform")
+        << "no algorithm for compression #" << compress << "\n";
+    }
+    if(fADC.empty()) return;
+
+    raw::CodecParameters baselineParams(params);
+    baselineParams.pedestal = fBaseline;
+    raw::Compress(fADC, compress, baselineParams);
+  } // CompressedOpDetWaveform::CompressedOpDetWaveform()
+
+
+  //----------------------------------------------------------------------
+  raw::OpDetWaveform CompressedOpDetWaveform::Uncompress() const
+  {
+    raw::OpDetWaveform waveform(fTimeStamp, fChannel);
+    if(fSamples == 0) return waveform;
+    waveform.resize(fSamples);
+    raw::Uncompress(fADC, waveform, fBaseline, fCompression);
+    return waveform;
+  } // CompressedOpDetWaveform::Uncompress()
+
+
+  //----------------------------------------------------------------------
+  short CompressedOpDetWaveform::EstimateBaseline(std::vector<short> const& adc)
+  {
+    if(adc.empty()) return 0;
+    std::vector<short> samples(adc);
+    auto const median = samples.begin() + samples.size() / 2;
+    std::nth_element(samples.begin(), median, samples.end());
+    return *median;
+  } // CompressedOpDetWaveform::EstimateBaseline()
+
+
+  //----------------------------------------------------------------------
+  raw::OpDetWaveform const& CompressedOpDetWaveformView::Waveform() const
+  {
+    std::call_once(fOnce, [this]()
+      {
+        fWaveform = fCompressed->Uncompress();
+        fDone = true;
+      });
+    return fWaveform;
+  } // CompressedOpDetWaveformView::Waveform()
+
+} // namespace raw
@@ -0,0 +1,189 @@
+/**
+ * @file    CompressedOpDetWaveform.h
+ * @brief   Optical detector waveform with compressed samples
+ * @see     CompressedOpDetWaveform.cxx OpDetWaveform.h raw.h
+ *
+ * Optical detector waveforms are at their baseline most of the time, so they
+ * compress well with the algorithms used for the TPC raw digits (raw.h).
+ * raw::CompressedOpDetWaveform stores a raw::OpDetWaveform compressed with
+ * them, and raw::CompressedOpDetWaveformView uncompresses it on first access.
+ */
+
+#ifndef RAWDATA_COMPRESSEDOPDETWAVEFORM_H
+#define RAWDATA_COMPRESSEDOPDETWAVEFORM_H
+
+// LArSoft libraries
+#include "lardataobj/RawData/OpDetWaveform.h"
+#include "lardataobj/RawData/Codec.h" // raw::CodecParameters
+#include "larcoreobj/SimpleTypesAndConstants/RawTypes.h" // raw::Compress_t
+
+// ROOT includes
+#include "RtypesCore.h"
+
+// C/C++ standard libraries
+#include <atomic>
+#include <cstdlib> // size_t
+#include <limits>
+#include <mutex> // std::once_flag
+#include <vector>
+
+
+namespace raw {
+
+  /**
+   * @brief Waveform from an optical detector channel, with compressed samples
+   *
+   * The samples of a raw::OpDetWaveform are compressed with one of the
+   * algorithms of raw::Compress(), using the baseline of the waveform as
+   * pedestal: zero suppression keeps the samples farther than a threshold
+   * from the baseline, on either side, and the suppressed samples are
+   * restored at the baseline. Huffman encoding is lossless.
+   *
+   *     raw::CompressedOpDetWaveform const compressed
+   *       (waveform, raw::kZeroHuffman, baseline, 10, 5);
+   *     raw::OpDetWaveform const restored = compressed.Uncompress();
+   *
+   * Settings can also be given as raw::CodecParameters, in which case the
+   * baseline is estimated from the samples unless a pedestal is specified.
+   * Channel and time stamp are the ones of the original waveform.
+   */
+  class CompressedOpDetWaveform {
+
+  public:
+
+    /// Default constructor: an empty waveform
+    CompressedOpDetWaveform() = default;
+
+    /**
+     * @brief Constructor: compresses the samples of waveform
+     * @param waveform the waveform to be compressed
+     * @param compress type of compression
+     * @param baseline baseline of the waveform (ADC counts)
+     * @param zerothreshold samples farther from baseline are kept by zero
+     *        suppression
+     * @param nearestneighbor samples kept around each zero-suppressed block
+     * @throw cet::exception if there is no algorithm for compress
+     */
+    CompressedOpDetWaveform(raw::OpDetWaveform const& waveform,
+                            raw::Compress_t           compress,
+                            short                     baseline,
+                            unsigned int              zerothreshold,
+                            int                       nearestneighbor = 0);
+
+    /**
+     * @brief Constructor: compresses the samples of waveform
+     * @param waveform the waveform to be compressed
+     * @param compress type of compression
+     * @param params compression settings; the pedestal is the baseline
+     * @throw cet::exception if there is no algorithm for compress
+     *
+     * If no pedestal is set in params, the baseline is estimated with
+     * EstimateBaseline(). The other settings are as for raw::Compress().
+     */
+    CompressedOpDetWaveform(raw::OpDetWaveform const&   waveform,
+                            raw::Compress_t             compress,
+                            raw::CodecParameters const& params = {});
+
+    ///@{
+    ///@name Accessors
+
+    /// Channel the waveform was read from
+    raw::Channel_t            ChannelNumber() const { return fChannel; }
+
+    /// Time stamp of the first sample
+    raw::TimeStamp_t          TimeStamp()     const { return fTimeStamp; }
+
+    /// Number of samples of the uncompressed waveform
+    ULong64_t                 Samples()       const { return fSamples; }
+
+    /// Baseline the compression was relative to (ADC counts)
+    short                     Baseline()      const { return fBaseline; }
+
+    /// Compression algorithm used to store the samples
+    raw::Compress_t           Compression()   const { return fCompression; }
+
+    /// The compressed samples
+    std::vector<short> const& ADCs()          const { return fADC; }
+
+    /// Number of words of compressed data
+    size_t                    NADC()          const { return fADC.size(); }
+    ///@}
+
+    /**
+     * @brief Returns the uncompressed waveform
+     * @throw cet::exception if the compression type is not supported
+     *
+     * Samples removed by zero suppression are at the baseline.
+     */
+    raw::OpDetWaveform Uncompress() const;
+
+    /// Returns the median of the samples, an estimate of the baseline of a
+    /// waveform which is at baseline most of the time (0 if empty)
+    static short EstimateBaseline(std::vector<short> const& adc);
+
+  private:
+
+    raw::Channel_t   fChannel   = std::numeric_limits<raw::Channel_t>::max();
+    raw::TimeStamp_t fTimeStamp = std::numeric_limits<raw::TimeStamp_t>::max();
+    ULong64_t        fSamples   = 0;           ///< number of uncompressed samples
+    short            fBaseline  = 0;           ///< baseline of the waveform
+    raw::Compress_t  fCompression = raw::kNone; ///< type of compression
+    std::vector<short> fADC;                   ///< compressed samples
+
+  }; // class CompressedOpDetWaveform
+
+
+  /**
+   * @brief A compressed optical waveform, uncompressed on first access
+   *
+   * The view refers to a raw::CompressedOpDetWaveform, which must outlive it,
+   * and it uncompresses the samples the first time they are requested, like
+   * raw::RawDigitView does for raw digits: concurrent requests uncompress
+   * only once, and if the uncompression throws, the next call tries again.
+   *
+   * Views can't be copied nor moved; collections of them can be kept e.g. in
+   * a `std::deque`:
+   *
+   *     std::deque<raw::CompressedOpDetWaveformView>
+   *       views(waveforms.begin(), waveforms.end());
+   *
+   */
+  class CompressedOpDetWaveformView {
+
+  public:
+
+    /// Constructor: refers to waveform, and uncompresses nothing yet
+    CompressedOpDetWaveformView(raw::CompressedOpDetWaveform const& waveform)
+      : fCompressed(&waveform)
+      {}
+
+    CompressedOpDetWaveformView(CompressedOpDetWaveformView const&) = delete;
+    CompressedOpDetWaveformView& operator=
+      (CompressedOpDetWaveformView const&) = delete;
+
+    /// The compressed waveform
+    raw::CompressedOpDetWaveform const& Compressed() const
+      { return *fCompressed; }
+
+    /**
+     * @brief Returns the uncompressed waveform
+     * @throw cet::exception if the compression type is not supported
+     * @see raw::CompressedOpDetWaveform::Uncompress()
+     */
+    raw::OpDetWaveform const& Waveform() const;
+
+    /// Returns whether the waveform has been uncompressed already
+    bool IsUncompressed() const { return fDone.load(); }
+
+  private:
+    raw::CompressedOpDetWaveform const* fCompressed; ///< the compressed waveform
+    mutable std::once_flag fOnce;          ///< to uncompress only once
+    mutable raw::OpDetWaveform fWaveform;  ///< the uncompressed waveform
+    mutable std::atomic<bool> fDone{ false }; ///< set after the uncompression
+
+  }; // class CompressedOpDetWaveformView
+
+} // namespace raw
+
+
+#endif // RAWDATA_COMPRESSEDOPDETWAVEFORM_H
@@ -0,0 +1,69 @@
+/**
+ * @file    CompressionStatistics.cxx
+ * @brief   Statistics of the compression of raw data, per channel and plane
+ * @see     CompressionStatistics.h
+ */
+
+#include "lardataobj/RawData/CompressionStatistics.h"
+
+
+namespace raw {
+
+  //----------------------------------------------------------------------
+  void CompressionTotals::Add(CompressionRecord const& record)
+  {
+    ++waveforms;
+    ticks          += record.ticks;
+    words          += record.words;
+    huffmanEscapes += record.huffmanEscapes;
+    zsBlocks       += record.zsBlocks;
+    zsKeptTicks    += record.zsKeptTicks;
+  } // CompressionTotals::Add(CompressionRecord)
+
+
+  //----------------------------------------------------------------------
+  void CompressionTotals::Add(CompressionTotals const& other)
+  {
+    waveforms      += other.waveforms;
+    ticks          += other.ticks;
+    words          += other.words;
+    huffmanEscapes += other.huffmanEscapes;
+    zsBlocks       += other.zsBlocks;
+    zsKeptTicks    += other.zsKeptTicks;
+  } // CompressionTotals::Add(CompressionTotals)
+
+
+  //----------------------------------------------------------------------
+  void CompressionStatistics::Add
+    (raw::ChannelID_t channel, CompressionRecord const& record)
+  {
+    fChannels[channel].Add(record);
+  }
+
+
+  //----------------------------------------------------------------------
+  void CompressionStatistics::Merge(CompressionStatistics const& other)
+  {
+    for(auto const& [ channel, totals ]: other.fChannels)
+      fChannels[channel].Add(totals);
+  }
+
+
+  //----------------------------------------------------------------------
+  CompressionTotals CompressionStatistics::Channel
+    (raw::ChannelID_t channel) const
+  {
+    auto const iChannel = fChannels.find(channel);
+    return (iChannel == fChannels.end())? CompressionTotals{}: iChannel->second;
+  }
+
+
+  //----------------------------------------------------------------------
+  CompressionTotals CompressionStatistics::Total() const
+  {
+    CompressionTotals total;
+    for(auto const& channel: fChannels) total.Add(channel.second);
+    return total;
+  }
+
+} // namespace raw
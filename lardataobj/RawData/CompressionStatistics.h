@@ -0,0 +1,161 @@
+/**
+ * @file    CompressionStatistics.h
+ * @brief   Statistics of the compression of raw data, per channel and plane
+ * @see     CompressionStatistics.cxx Codec.h raw.h
+ *
+ * The compression of a waveform can fill a raw::CompressionRecord (see
+ * `raw::CodecParameters::statistics`), which the caller then adds to a
+ * raw::CompressionStatistics with the channel of the waveform:
+ *
+ *     raw::CompressionStatistics stats;
+ *     raw::CompressionRecord record;
+ *     raw::CodecParameters params;
+ *     params.statistics = &record;
+ *     for(auto& [ channel, adc ]: waveforms){
+ *       raw::Compress(adc, raw::kZeroHuffman, params);
+ *       stats.Add(channel, record);
+ *     }
+ *     auto const planes = stats.ByPlane
+ *       ([&geom](raw::ChannelID_t channel){ return geom.ChannelToWire(channel).front().planeID(); });
+ *
+ * Nothing is recorded when no record is requested.
+ */
+
+#ifndef RAWDATA_COMPRESSIONSTATISTICS_H
+#define RAWDATA_COMPRESSIONSTATISTICS_H
+
+// LArSoft libraries
+#include "larcoreobj/SimpleTypesAndConstants/RawTypes.h" // raw::ChannelID_t
+
+// C/C++ standard libraries
+#include <cstddef> // std::size_t
+#include <map>
+#include <type_traits> // std::decay_t, std::invoke_result_t
+
+
+namespace raw {
+
+  /**
+   * @brief Statistics of the compression of a single waveform
+   *
+   * The sizes are filled by raw::Compress() for any compression type; the
+   * other counts only by the algorithms they apply to, and they are 0
+   * otherwise. In raw::kZeroHuffman data, Huffman escapes include the ones
+   * in the header of the zero-suppressed data.
+   */
+  struct CompressionRecord {
+
+    std::size_t ticks = 0; ///< samples of the uncompressed waveform
+    std::size_t words = 0; ///< words of the compressed data
+
+    /// Samples stored as they are by Huffman encoding, because the
+    /// difference from the previous one is too large for a code
+    std::size_t huffmanEscapes = 0;
+
+    std::size_t zsBlocks = 0;    ///< blocks kept by zero suppression
+    std::size_t zsKeptTicks = 0; ///< samples kept by zero suppression
+
+    /// Compressed size over uncompressed size (1 for an empty waveform)
+    double Ratio() const
+      { return (ticks == 0)? 1.0: double(words) / double(ticks); }
+
+  }; // struct CompressionRecord
+
+
+  /// Sums of the statistics of the compression of many waveforms
+  struct CompressionTotals {
+
+    std::size_t waveforms = 0;      ///< number of waveforms
+    std::size_t ticks = 0;          ///< samples of the uncompressed waveforms
+    std::size_t words = 0;          ///< words of the compressed data
+    std::size_t huffmanEscapes = 0; ///< samples escaped by Huffman encoding
+    std::size_t zsBlocks = 0;       ///< blocks kept by zero suppression
+    std::size_t zsKeptTicks = 0;    ///< samples kept by zero suppression
+
+    /// Adds the statistics of a waveform
+    void Add(CompressionRecord const& record);
+
+    /// Adds the statistics of other waveforms
+    void Add(CompressionTotals const& other);
+
+    /// Compressed size over uncompressed size (1 if there are no samples)
+    double Ratio() const
+      { return (ticks == 0)? 1.0: double(words) / double(ticks); }
+
+  }; // struct CompressionTotals
+
+
+  /**
+   * @brief Accumulates compression statistics per channel
+   *
+   * Statistics are added one waveform at a time with Add(), and they are
+   * summed per channel. Sums over groups of channels, like the planes, are
+   * obtained with ByPlane() and a function assigning each channel to its
+   * group, which is usually provided by the geometry.
+   *
+   * An object is not thread-safe: each thread should fill its own, and
+   * they can then be combined with Merge().
+   */
+  class CompressionStatistics {
+
+  public:
+
+    using Channels_t = std::map<raw::ChannelID_t, CompressionTotals>;
+
+    /// Adds the statistics of a waveform of the specified channel
+    void Add(raw::ChannelID_t channel, CompressionRecord const& record);
+
+    /// Adds all the statistics collected by other
+    void Merge(CompressionStatistics const& other);
+
+    /// Removes all the statistics
+    void Clear() { fChannels.clear(); }
+
+    /// Whether no statistics have been added
+    bool empty() const { return fChannels.empty(); }
+
+    /// Statistics of each channel
+    Channels_t const& Channels() const { return fChannels; }
+
+    /// Statistics of the channel (empty if it has none)
+    CompressionTotals Channel(raw::ChannelID_t channel) const;
+
+    /// Sum of the statistics of all the channels
+    CompressionTotals Total() const;
+
+    /**
+     * @brief Sums the statistics of the channels of each plane
+     * @tparam PlaneOf type of function returning the plane of a channel
+     * @param planeOf function returning the plane of a channel
+     * @return map from each plane to the sum of its channels
+     *
+     * The plane can be of any type usable as key of `std::map`, like
+     * `geo::PlaneID`; `planeOf` is called once per channel.
+     */
+    template <typename PlaneOf>
+    auto ByPlane(PlaneOf&& planeOf) const;
+
+  private:
+
+    Channels_t fChannels; ///< statistics of each channel
+
+  }; // class CompressionStatistics
+
+} // namespace raw
+
+
+//------------------------------------------------------------------------------
+//--- template implementation
+//---
+template <typename PlaneOf>
+auto raw::CompressionStatistics::ByPlane(PlaneOf&& planeOf) const {
+  using Plane_t
+    = std::decay_t<std::invoke_result_t<PlaneOf&, raw::ChannelID_t>>;
+  std::map<Plane_t, CompressionTotals> planes;
+  for(auto const& [ channel, totals ]: fChannels)
+    planes[planeOf(channel)].Add(totals);
+  return planes;
+} // raw::CompressionStatistics::ByPlane()
+
+
+#endif // RAWDATA_COMPRESSIONSTATISTICS_H
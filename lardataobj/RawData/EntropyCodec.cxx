@@ -0,0 +1,426 @@
+/**
+ * @file    EntropyCodec.cxx
+ * @brief   Canonical Huffman coding of waveforms with a fitted model
+ * @see     EntropyCodec.h
+ */
+
+#include "lardataobj/RawData/EntropyCodec.h"
+
+// framework libraries
+#include "cetlib_except/exception.h"
+
+// C/C++ standard libraries
+#include <algorithm> // std::max_element(), std::min()
+#include <cstdint> // std::uint64_t, std::uint16_t
+#include <functional> // std::greater<>
+#include <queue> // std::priority_queue
+#include <utility> // std::pair, std::move()
+
+
+namespace {
+
+  /// Number of header words before the code lengths
+  constexpr std::size_t HeaderSize = 4;
+
+  /// Index of the symbol of a null difference
+  constexpr std::size_t ZeroSymbol = raw::EntropyModel::MaxDelta + 1;
+
+  using Counts_t = std::array<std::size_t, raw::EntropyModel::NSymbols>;
+  using Codes_t = std::array<std::uint16_t, raw::EntropyModel::NSymbols>;
+
+
+  /// Adds the symbols of the differences in adc to counts
+  void countSymbols(std::vector<short> const& adc, Counts_t& counts)
+  {
+    for(std::size_t i = 1; i < adc.size(); ++i)
+      ++counts[raw::EntropyModel::Symbol(adc[i] - adc[i-1])];
+  } // countSymbols()
+
+
+  /// Returns the Huffman code lengths for the counts (0 for unused symbols)
+  raw::EntropyModel::CodeLengths_t huffmanLengths(Counts_t const& counts)
+  {
+    constexpr std::size_t NSymbols = raw::EntropyModel::NSymbols;
+
+    // the first NSymbols nodes are the leaves
+    std::vector<std::size_t> parents(NSymbols, 0);
+    using Node_t = std::pair<std::size_t, std::size_t>; // weight, node
+    std::priority_queue<Node_t, std::vector<Node_t>, std::greater<Node_t>> queue;
+    for(std::size_t s = 0; s < NSymbols; ++s)
+      if(counts[s] > 0) queue.emplace(counts[s], s);
+
+    raw::EntropyModel::CodeLengths_t lengths;
+    lengths.fill(0);
+    if(queue.size() == 1){
+      lengths[queue.top().second] = 1;
+      return lengths;
+    }
+
+    while(queue.size() > 1){
+      Node_t const a = queue.top();
+      queue.pop();
+      Node_t const b = queue.top();
+      queue.pop();
+      std::size_t const node = parents.size();
+      parents.push_back(0);
+      parents[a.second] = parents[b.second] = node;
+      queue.emplace(a.first + b.first, node);
+    } // while
+
+    std::size_t const root = parents.size() - 1;
+    for(std::size_t s = 0; s < NSymbols; ++s){
+      if(counts[s] == 0) continue;
+      unsigned int depth = 0;
+      for(std::size_t node = s; node != root; node = parents[node]) ++depth;
+      lengths[s] = depth;
+    }
+    return lengths;
+  } // huffmanLengths()
+
+
+  /// Returns the canonical codes for the code lengths
+  Codes_t canonicalCodes(raw::EntropyModel::CodeLengths_t const& lengths)
+  {
+    constexpr unsigned int MaxLength = raw::EntropyModel::MaxCodeLength;
+
+    std::array<unsigned int, MaxLength + 1> nCodes;
+    nCodes.fill(0);
+    for(unsigned char length: lengths) ++nCodes[length];
+    nCodes[0] = 0;
+
+    std::array<unsigned int, MaxLength + 1> nextCode;
+    unsigned int code = 0;
+    for(unsigned int length = 1; length <= MaxLength; ++length){
+      code = (code + nCodes[length - 1]) << 1;
+      nextCode[length] = code;
+    }
+
+    Codes_t codes;
+    codes.fill(0);
+    for(std::size_t s = 0; s < lengths.size(); ++s)
+      if(lengths[s] > 0) codes[s] = nextCode[lengths[s]]++;
+    return codes;
+  } // canonicalCodes()
+
+
+  /// Throws an exception unless the code lengths describe a valid prefix code
+  void checkLengths(raw::EntropyModel::CodeLengths_t const& lengths)
+  {
+    constexpr unsigned int MaxLength = raw::EntropyModel::MaxCodeLength;
+    if(lengths[raw::EntropyModel::EscapeSymbol] == 0){
+      throw cet::exception("raw")
+        << "raw::EntropyModel: the escape symbol has no code\n";
+    }
+    std::size_t kraft = 0; // in units of 2^-MaxLength
+    for(unsigned char length: lengths){
+      if(length > MaxLength){
+        throw cet::exception("raw")
+          << "raw::EntropyModel: code length " << ((int) length)
+          << " exceeds the maximum of " << MaxLength << "\n";
+      }
+      if(length > 0) kraft += std::size_t(1) << (MaxLength - length);
+    }
+    if(kraft > (std::size_t(1) << MaxLength)){
+      throw cet::exception("raw")
+        << "raw::EntropyModel: code lengths do not describe a prefix code\n";
+    }
+  } // checkLengths()
+
+
+  /// Writes codes most significant bit first into 16-bit words
+  class BitWriter {
+  public:
+    explicit BitWriter(short* out): fOut(out) {}
+
+    /// Writes the nBits (up to 16) least significant bits of code
+    void Write(unsigned int code, unsigned int nBits)
+      {
+        fBuffer = (fBuffer << nBits) | code;
+        fNBits += nBits;
+        if(fNBits >= 16){
+          fNBits -= 16;
+          *fOut++ = static_cast<short>(fBuffer >> fNBits);
+        }
+      }
+
+    /// Writes the pending bits, and returns the end of the written words
+    short* Flush()
+      {
+        if(fNBits > 0) *fOut++ = static_cast<short>(fBuffer << (16 - fNBits));
+        fNBits = 0;
+        return fOut;
+      }
+
+  private:
+    short* fOut;
+    std::uint64_t fBuffer = 0;
+    unsigned int fNBits = 0;
+  }; // class BitWriter
+
+} // local namespace
+
+
+namespace raw {
+
+  //----------------------------------------------------------------------
+  EntropyModel::EntropyModel(std::vector<short> const& adc)
+  {
+    Counts_t counts;
+    counts.fill(0);
+    countSymbols(adc, counts);
+    BuildCode(counts);
+  } // EntropyModel::EntropyModel()
+
+
+  //----------------------------------------------------------------------
+  EntropyModel::EntropyModel(std::vector<std::vector<short>> const& adcs)
+  {
+    Counts_t counts;
+    counts.fill(0);
+    for(std::vector<short> const& adc: adcs) countSymbols(adc, counts);
+    BuildCode(counts);
+  } // EntropyModel::EntropyModel()
+
+
+  //----------------------------------------------------------------------
+  EntropyModel::EntropyModel(CodeLengths_t const& lengths)
+    : fLengths(lengths)
+  {
+    checkLengths(fLengths);
+  }
+
+
+  //----------------------------------------------------------------------
+  // The escape symbol always gets a code, so that waveforms other than the
+  // ones the model was built from can be encoded. Code lengths are limited
+  // by halving the counts until the longest code is short enough.
+  void EntropyModel::BuildCode(std::array<std::size_t, NSymbols> counts)
+  {
+    counts[EscapeSymbol] = std::max(counts[EscapeSymbol], std::size_t(1));
+    while(true){
+      fLengths = huffmanLengths(counts);
+      if(*std::max_element(fLengths.begin(), fLengths.end()) <= MaxCodeLength)
+        break;
+      for(std::size_t& count: counts) if(count > 0) count = (count + 1) / 2;
+    } // while
+  } // EntropyModel::BuildCode()
+
+
+  //----------------------------------------------------------------------
+  void CompressEntropy(std::vector<short>& adc)
+  {
+    CompressEntropy(adc, EntropyModel(adc));
+  }
+
+
+  //----------------------------------------------------------------------
+  void CompressEntropy(std::vector<short>& adc, EntropyModel const& model)
+  {
+    std::size_t const nTicks = adc.size();
+    if(nTicks == 0) return;
+    if(nTicks > 0xFFFFFFFFULL){
+      throw cet::exception("raw")
+        << "raw::CompressEntropy(): " << nTicks << " samples are too many\n";
+    }
+
+    EntropyModel::CodeLengths_t const& lengths = model.CodeLengths();
+    Codes_t const codes = canonicalCodes(lengths);
+
+    std::size_t first = EntropyModel::NSymbols, last = 0;
+    for(std::size_t s = 1; s < EntropyModel::NSymbols; ++s){
+      if(lengths[s] == 0) continue;
+      first = std::min(first, s);
+      last = s;
+    }
+    if(first > last){ // only escapes
+      first = 1;
+      last = 0;
+    }
+
+    std::size_t const nLengthWords = (last + 5 - first) / 4; // with escape
+    constexpr unsigned int EscapeBits
+      = EntropyModel::MaxCodeLength + 16;
+    std::vector<short> compressed
+      (HeaderSize + nLengthWords + ((nTicks - 1) * EscapeBits + 15) / 16);
+
+    short* out = compressed.data();
+    *out++ = static_cast<short>(nTicks & 0xFFFF);
+    *out++ = static_cast<short>((nTicks >> 16) & 0xFFFF);
+    *out++ = adc[0];
+    *out++ = static_cast<short>((first << 8) | last);
+
+    BitWriter lengthWriter(out);
+    lengthWriter.Write(lengths[EntropyModel::EscapeSymbol], 4);
+    for(std::size_t s = first; s <= last; ++s) lengthWriter.Write(lengths[s], 4);
+    out = lengthWriter.Flush();
+
+    unsigned int const escapeCode = codes[EntropyModel::EscapeSymbol];
+    unsigned int const escapeLength = lengths[EntropyModel::EscapeSymbol];
+    BitWriter writer(out);
+    for(std::size_t i = 1; i < nTicks; ++i){
+      std::size_t const symbol = EntropyModel::Symbol(adc[i] - adc[i-1]);
+      if((symbol != EntropyModel::EscapeSymbol) && (lengths[symbol] > 0))
+        writer.Write(codes[symbol], lengths[symbol]);
+      else{
+        writer.Write(escapeCode, escapeLength);
+        writer.Write(static_cast<std::uint16_t>(adc[i]), 16);
+      }
+    } // for
+    out = writer.Flush();
+
+    compressed.resize(out - compressed.data());
+    adc = std::move(compressed);
+  } // CompressEntropy()
+
+
+  //----------------------------------------------------------------------
+  // The decoding table is indexed by the next maxLength bits of the data:
+  // each entry holds the symbol (upper bits) and the length of its code
+  // (lowest 4 bits), with a length of 0 for bit patterns which are not codes.
+  void UncompressEntropy(std::vector<short> const& adc,
+                         std::vector<short>&       uncompressed)
+  {
+    UncompressEntropy(adc.data(), adc.size(), uncompressed);
+  }
+
+
+  //----------------------------------------------------------------------
+  void UncompressEntropy(short const*        adc,
+                         std::size_t         nWords,
+                         std::vector<short>& uncompressed)
+  {
+    if(nWords == 0){
+      uncompressed.clear();
+      return;
+    }
+    if(nWords < HeaderSize + 1){
+      throw cet::exception("raw")
+        << "raw::UncompressEntropy(): truncated header (" << nWords
+        << " words)\n";
+    }
+
+    std::size_t const nTicks = std::size_t(std::uint16_t(adc[0]))
+      | (std::size_t(std::uint16_t(adc[1])) << 16);
+    std::size_t const first = std::uint16_t(adc[3]) >> 8;
+    std::size_t const last = std::uint16_t(adc[3]) & 0xFF;
+    if((first == 0) || (last >= EntropyModel::NSymbols) || (last + 1 < first)){
+      throw cet::exception("raw")
+        << "raw::UncompressEntropy(): invalid symbol range\n";
+    }
+
+    // code lengths
+    std::size_t const nLengthWords = (last + 5 - first) / 4; // with escape
+    if(nWords < HeaderSize + nLengthWords){
+      throw cet::exception("raw")
+        << "raw::UncompressEntropy(): truncated header (" << nWords
+        << " words)\n";
+    }
+    EntropyModel::CodeLengths_t lengths;
+    lengths.fill(0);
+    auto const nibble = [&adc](std::size_t i)
+      { return (std::uint16_t(adc[HeaderSize + i / 4]) >> (12 - 4 * (i % 4))) & 0xF; };
+    lengths[EntropyModel::EscapeSymbol] = nibble(0);
+    for(std::size_t s = first; s <= last; ++s) lengths[s] = nibble(s - first + 1);
+    checkLengths(lengths);
+
+    unsigned int const maxLength
+      = *std::max_element(lengths.begin(), lengths.end());
+    Codes_t const codes = canonicalCodes(lengths);
+    std::vector<std::uint16_t> table(std::size_t(1) << maxLength, 0);
+    for(std::size_t s = 0; s < EntropyModel::NSymbols; ++s){
+      unsigned int const length = lengths[s];
+      if(length == 0) continue;
+      std::size_t const begin = std::size_t(codes[s]) << (maxLength - length);
+      std::size_t const end = begin + (std::size_t(1) << (maxLength - length));
+      std::fill(table.begin() + begin, table.begin() + end, (s << 4) | length);
+    }
+
+    // each sample after the first takes at least one bit
+    std::size_t const dataBegin = HeaderSize + nLengthWords;
+    if(nTicks - 1 > (nWords - dataBegin) * 16){
+      throw cet::exception("raw")
+        << "raw::UncompressEntropy(): data truncated (" << nWords
+        << " words for " << nTicks << " samples)\n";
+    }
+
+    uncompressed.resize(nTicks);
+    short* out = uncompressed.data();
+    short current = adc[2];
+    out[0] = current;
+
+    std::size_t nextWord = dataBegin;
+    std::uint64_t bits = 0; // the next unused bits, aligned to the left
+    int nBits = 0;
+    for(std::size_t i = 1; i < nTicks; ++i){
+      if(nBits < int(EntropyModel::MaxCodeLength + 16)){
+        while(nBits <= 48){
+          std::uint64_t const word
+            = (nextWord < nWords)? std::uint16_t(adc[nextWord]): 0;
+          ++nextWord;
+          bits |= word << (48 - nBits);
+          nBits += 16;
+        } // while
+      }
+
+      unsigned int const entry = table[bits >> (64 - maxLength)];
+      unsigned int const length = entry & 0xF;
+      bits <<= length;
+      nBits -= length;
+
+      std::size_t const symbol = entry >> 4;
+      if(symbol == EntropyModel::EscapeSymbol){
+        // invalid codes have escape symbol and null length
+        if(length == 0){
+          throw cet::exception("raw")
+            << "raw::UncompressEntropy(): invalid code at sample #" << i << "\n";
+        }
+        current = static_cast<short>(bits >> 48);
+        bits <<= 16;
+        nBits -= 16;
+      }
+      else current = static_cast<short>(current + int(symbol) - int(ZeroSymbol));
+      out[i] = current;
+    } // for
+
+    std::size_t const usedBits = (nextWord - dataBegin) * 16 - nBits;
+    if(usedBits > (nWords - dataBegin) * 16){
+      throw cet::exception("raw")
+        << "raw::UncompressEntropy(): data truncated (" << nWords
+        << " words for " << nTicks << " samples)\n";
+    }
+  } // UncompressEntropy()
+
+
+  //----------------------------------------------------------------------
+  void EntropyCodec::Encode
+    (std::vector<short>& adc, CodecParameters const&) const
+  {
+    CompressEntropy(adc);
+  }
+
+
+  //----------------------------------------------------------------------
+  void EntropyCodec::Decode(std::vector<short> const& adc,
+                            std::vector<short>&       uncompressed,
+                            int) const
+  {
+    UncompressEntropy(adc, uncompressed);
+  }
+
+
+  //----------------------------------------------------------------------
+  void EntropyCodec::DecodeRange(std::vector<short> const& adc,
+                                 std::vector<short>&       uncompressed,
+                                 int,
+                                 std::size_t               tickBegin,
+                                 std::size_t               tickEnd,
+                                 HuffmanIndex const*) const
+  {
+    UncompressEntropy(adc, uncompressed);
+    std::size_t const end = std::min(tickEnd, uncompressed.size());
+    std::size_t const begin = std::min(tickBegin, end);
+    uncompressed.erase(uncompressed.begin() + end, uncompressed.end());
+    uncompressed.erase(uncompressed.begin(), uncompressed.begin() + begin);
+  } // EntropyCodec::DecodeRange()
+
+} // namespace raw
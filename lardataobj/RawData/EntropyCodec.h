@@ -0,0 +1,166 @@
+/**
+ * @file    EntropyCodec.h
+ * @brief   Canonical Huffman coding of waveforms with a fitted model
+ * @see     EntropyCodec.cxx raw.h Codec.h
+ *
+ * The differences between consecutive samples are encoded with a canonical
+ * Huffman code built from their distribution, either in the waveform itself
+ * or in a set of waveforms (e.g. a whole plane). Unlike raw::CompressHuffman(),
+ * which uses a fixed code for differences between -3 and +3, narrow
+ * distributions are encoded in less than two bits per sample, and larger
+ * differences are still encoded in a few bits, as long as they are frequent.
+ *
+ * Compressed data layout (16-bit words):
+ *
+ * * number of samples, low and high 16 bits (2 words)
+ * * first sample, as is
+ * * range of the coded differences: first symbol index (high byte) and last
+ *   one (low byte); symbol index `i` represents a difference of `i - 64`
+ * * code lengths (4 bits each, most significant first) of the escape symbol
+ *   and of all the symbols in the range; 0 marks unused symbols
+ * * the codes of the differences, most significant bit first; an escape code
+ *   is followed by the 16 bits of the sample
+ */
+
+#ifndef RAWDATA_ENTROPYCODEC_H
+#define RAWDATA_ENTROPYCODEC_H
+
+// LArSoft libraries
+#include "lardataobj/RawData/Codec.h"
+
+// C/C++ standard libraries
+#include <array>
+#include <cstddef> // std::size_t
+#include <vector>
+
+
+namespace raw {
+
+  /**
+   * @brief Code lengths of the differences between consecutive samples
+   *
+   * The model assigns a code to the differences between -63 and +63 which
+   * occur in the waveforms it is built from, and to an escape symbol used
+   * for all the others. Code lengths are limited to MaxCodeLength bits.
+   */
+  class EntropyModel {
+
+  public:
+
+    /// Largest difference with its own code
+    static constexpr int MaxDelta = 63;
+
+    /// Number of symbols: escape, then differences from -MaxDelta to MaxDelta
+    static constexpr std::size_t NSymbols = 2 * MaxDelta + 2;
+
+    /// Longest code length
+    static constexpr unsigned int MaxCodeLength = 12;
+
+    /// Index of the escape symbol
+    static constexpr std::size_t EscapeSymbol = 0;
+
+    /// Code lengths of all the symbols (0: not coded)
+    using CodeLengths_t = std::array<unsigned char, NSymbols>;
+
+    /// Builds the model from the differences in a single waveform
+    explicit EntropyModel(std::vector<short> const& adc);
+
+    /// Builds the model from the differences in all the waveforms
+    explicit EntropyModel(std::vector<std::vector<short>> const& adcs);
+
+    /// Builds a model with the specified code lengths (0: escaped)
+    explicit EntropyModel(CodeLengths_t const& lengths);
+
+    /// Returns the index of the symbol for the difference delta
+    static std::size_t Symbol(int delta)
+      {
+        return ((delta < -MaxDelta) || (delta > MaxDelta))
+          ? EscapeSymbol: std::size_t(delta + MaxDelta + 1);
+      }
+
+    /// Returns the code length of a symbol (0: escaped)
+    unsigned int CodeLength(std::size_t symbol) const
+      { return fLengths[symbol]; }
+
+    /// Returns the code lengths of all the symbols
+    CodeLengths_t const& CodeLengths() const { return fLengths; }
+
+  private:
+
+    CodeLengths_t fLengths; ///< code length of each symbol
+
+    /// Computes the code lengths from the number of occurrences of symbols
+    void BuildCode(std::array<std::size_t, NSymbols> counts);
+
+  }; // class EntropyModel
+
+
+  /**
+   * @brief Compresses a waveform with a code fitted to it
+   * @param adc uncompressed samples, replaced by the compressed data
+   *
+   * The model, stored with the data, takes a few words.
+   */
+  void CompressEntropy(std::vector<short>& adc);
+
+  /**
+   * @brief Compresses a waveform with the specified model
+   * @param adc uncompressed samples, replaced by the compressed data
+   * @param model code of the differences
+   *
+   * Differences without a code in the model are escaped, so that any model
+   * can be used for any waveform: a model built from a whole plane gives
+   * codes based on more data than a single channel.
+   */
+  void CompressEntropy(std::vector<short>& adc, EntropyModel const& model);
+
+  /**
+   * @brief Uncompresses data from raw::CompressEntropy()
+   * @param adc compressed data
+   * @param uncompressed resized and filled with the uncompressed samples
+   * @throw cet::exception if the data is corrupted or truncated
+   *
+   * Each code is decoded with a single table look-up.
+   */
+  void UncompressEntropy(std::vector<short> const& adc,
+                         std::vector<short>&       uncompressed);
+
+  /// Like UncompressEntropy(), from nWords words of data starting at adc
+  void UncompressEntropy(short const*        adc,
+                         std::size_t         nWords,
+                         std::vector<short>& uncompressed);
+
+
+  /**
+   * @brief Codec of raw::CompressEntropy()
+   *
+   * Each waveform is compressed with its own model; the pedestal is not used.
+   * No raw::Compress_t value is reserved for this compression yet, and the
+   * codec must be registered in raw::CodecRegistry by the experiments using
+   * it, with the type they store in their raw::RawDigit.
+   */
+  class EntropyCodec: public Codec {
+
+  public:
+
+    void Encode
+      (std::vector<short>& adc, CodecParameters const& params) const override;
+
+    void Decode(std::vector<short> const& adc,
+                std::vector<short>&       uncompressed,
+                int                       pedestal) const override;
+
+    /// Decodes the whole waveform, and keeps only the window (index ignored)
+    void DecodeRange(std::vector<short> const& adc,
+                     std::vector<short>&       uncompressed,
+                     int                       pedestal,
+                     std::size_t               tickBegin,
+                     std::size_t               tickEnd,
+                     HuffmanIndex const*       index) const override;
+
+  }; // class EntropyCodec
+
+} // namespace raw
+
+
+#endif // RAWDATA_ENTROPYCODEC_H
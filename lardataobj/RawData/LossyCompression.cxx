@@ -0,0 +1,285 @@
+/**
+ * @file    LossyCompression.cxx
+ * @brief   Compression with a bounded error on the noise samples
+ * @see     LossyCompression.h
+ */
+
+#include "lardataobj/RawData/LossyCompression.h"
+#include "lardataobj/RawData/EntropyCodec.h"
+
+// framework libraries
+#include "cetlib_except/exception.h"
+
+// C/C++ standard libraries
+#include <algorithm> // std::nth_element(), std::min()
+#include <cmath> // std::sqrt()
+#include <cstdint> // std::uint16_t
+#include <cstdlib> // std::abs()
+#include <limits>
+#include <utility> // std::move()
+
+
+namespace {
+
+  /// Largest supported maximum error
+  constexpr unsigned int MaxMaxError = 16383;
+
+  /// Returns the median of the samples
+  int median(std::vector<short> adc)
+  {
+    if(adc.empty()) return 0;
+    auto const middle = adc.begin() + adc.size() / 2;
+    std::nth_element(adc.begin(), middle, adc.end());
+    return *middle;
+  } // median()
+
+
+  /// Returns which samples are to be kept exact
+  std::vector<bool> exactSamples
+    (std::vector<short> const& adc, unsigned int maxError, raw::CodecParameters const& params)
+  {
+    int const pedestal = params.pedestal? *params.pedestal: median(adc);
+    int const threshold = params.zerothreshold;
+    std::size_t const nn = std::max(params.nearestneighbor.value_or(0), 0);
+    int const low = std::numeric_limits<short>::min() + int(maxError);
+    int const high = std::numeric_limits<short>::max() - int(maxError);
+
+    std::size_t const nTicks = adc.size();
+    std::vector<bool> exact(nTicks, false);
+    std::size_t nextFree = 0; // first tick not yet marked
+    for(std::size_t tick = 0; tick < nTicks; ++tick){
+      int const value = adc[tick];
+      if((std::abs(value - pedestal) <= threshold) && (value >= low) && (value <= high))
+        continue;
+      std::size_t const first = std::max(nextFree, (tick > nn)? tick - nn: 0);
+      nextFree = std::min(tick + nn + 1, nTicks);
+      for(std::size_t i = first; i < nextFree; ++i) exact[i] = true;
+    } // for
+    return exact;
+  } // exactSamples()
+
+
+  /// Returns the quotient of value by step, rounded to the closest integer
+  int roundedQuotient(int value, int step)
+  {
+    int const shifted = value + step / 2;
+    return (shifted >= 0)? shifted / step: -((step - 1 - shifted) / step);
+  } // roundedQuotient()
+
+
+  /// Writes a 32-bit value into two words
+  void writeLong(std::vector<short>& out, std::size_t value)
+  {
+    out.push_back(static_cast<short>(value & 0xFFFF));
+    out.push_back(static_cast<short>((value >> 16) & 0xFFFF));
+  } // writeLong()
+
+
+  /// Reads a 32-bit value from two words
+  std::size_t readLong(std::vector<short> const& in, std::size_t index)
+  {
+    return std::size_t(std::uint16_t(in[index]))
+      | (std::size_t(std::uint16_t(in[index + 1])) << 16);
+  } // readLong()
+
+
+  /// Adds to report the error of a reconstructed sample
+  void addError(raw::LossyErrorReport& report, int original, int reconstructed)
+  {
+    unsigned int const error = std::abs(reconstructed - original);
+    if(error == 0) return;
+    ++report.nChanged;
+    report.maxAbsError = std::max(report.maxAbsError, error);
+    report.rmsError += double(error) * error; // sum of squares until the end
+  } // addError()
+
+
+  /// Turns the sum of squared errors into their RMS
+  void finishReport(raw::LossyErrorReport& report)
+  {
+    report.rmsError = (report.nSamples > 0)
+      ? std::sqrt(report.rmsError / report.nSamples): 0.;
+  } // finishReport()
+
+} // local namespace
+
+
+namespace raw {
+
+  //----------------------------------------------------------------------
+  LossyErrorReport CompressBoundedError(std::vector<short>&    adc,
+                                        unsigned int           maxError,
+                                        CodecParameters const& params)
+  {
+    if(maxError > MaxMaxError){
+      throw cet::exception("raw")
+        << "raw::CompressBoundedError(): maximum error " << maxError
+        << " is larger than the supported " << MaxMaxError << "\n";
+    }
+
+    LossyErrorReport report;
+    std::size_t const nTicks = adc.size();
+    report.nSamples = nTicks;
+    if(nTicks == 0) return report;
+
+    std::vector<bool> const exact = exactSamples(adc, maxError, params);
+
+    // runs of quantized and exact samples, starting with quantized ones
+    std::vector<std::size_t> runs;
+    bool runExact = false;
+    std::size_t runStart = 0;
+    for(std::size_t tick = 0; tick < nTicks; ++tick){
+      if(exact[tick] == runExact) continue;
+      runs.push_back(tick - runStart);
+      runStart = tick;
+      runExact = exact[tick];
+    }
+    runs.push_back(nTicks - runStart);
+
+    // quotients, stored as the differences of consecutive samples of codes
+    int const step = 2 * maxError + 1;
+    std::vector<short> codes(nTicks);
+    codes[0] = adc[0];
+    int previous = adc[0]; // the first sample is always exact
+    for(std::size_t tick = 1; tick < nTicks; ++tick){
+      int const value = adc[tick];
+      int quotient;
+      if(exact[tick]){
+        quotient = value - previous; // 16-bit wrap-around is undone on decoding
+        previous = value;
+        ++report.nExact;
+      }
+      else{
+        quotient = roundedQuotient(value - previous, step);
+        previous += quotient * step;
+        addError(report, value, previous);
+      }
+      codes[tick] = static_cast<short>(codes[tick - 1] + quotient);
+    } // for
+    if(exact[0]) ++report.nExact;
+    finishReport(report);
+
+    raw::CompressEntropy(codes);
+
+    std::vector<short> compressed;
+    compressed.reserve(3 + 2 * runs.size() + codes.size());
+    compressed.push_back(static_cast<short>(maxError));
+    writeLong(compressed, runs.size());
+    for(std::size_t run: runs) writeLong(compressed, run);
+    compressed.insert(compressed.end(), codes.begin(), codes.end());
+    adc = std::move(compressed);
+    return report;
+  } // CompressBoundedError()
+
+
+  //----------------------------------------------------------------------
+  void UncompressBoundedError(std::vector<short> const& adc,
+                              std::vector<short>&       uncompressed)
+  {
+    if(adc.empty()){
+      uncompressed.clear();
+      return;
+    }
+    std::size_t const nRuns = (adc.size() >= 3)? readLong(adc, 1): 0;
+    std::size_t const codeStart = 3 + 2 * nRuns;
+    if((nRuns == 0) || (codeStart > adc.size())){
+      throw cet::exception("raw")
+        << "raw::UncompressBoundedError(): truncated header\n";
+    }
+    int const step = 2 * std::uint16_t(adc[0]) + 1;
+
+    raw::UncompressEntropy
+      (adc.data() + codeStart, adc.size() - codeStart, uncompressed);
+    std::size_t const nTicks = uncompressed.size();
+
+    // turn the codes into samples in place, run by run
+    short lastCode = uncompressed.empty()? 0: uncompressed[0];
+    int previous = lastCode;
+    std::size_t tick = 1;
+    std::size_t runEnd = 0;
+    for(std::size_t run = 0; run < nRuns; ++run){
+      runEnd += readLong(adc, 3 + 2 * run);
+      if(runEnd > nTicks){
+        throw cet::exception("raw")
+          << "raw::UncompressBoundedError(): runs exceed the " << nTicks
+          << " samples\n";
+      }
+      int const runStep = (run % 2 == 0)? step: 1;
+      for(; tick < runEnd; ++tick){
+        short const code = uncompressed[tick];
+        previous = static_cast<short>(previous + static_cast<short>(code - lastCode) * runStep);
+        lastCode = code;
+        uncompressed[tick] = previous;
+      } // for ticks
+    } // for runs
+    if(runEnd != nTicks){
+      throw cet::exception("raw")
+        << "raw::UncompressBoundedError(): runs cover " << runEnd << " of the "
+        << nTicks << " samples\n";
+    }
+  } // UncompressBoundedError()
+
+
+  //----------------------------------------------------------------------
+  LossyErrorReport CompareWaveforms(std::vector<short> const& original,
+                                    std::vector<short> const& reconstructed)
+  {
+    if(original.size() != reconstructed.size()){
+      throw cet::exception("raw")
+        << "raw::CompareWaveforms(): waveforms have " << original.size()
+        << " and " << reconstructed.size() << " samples\n";
+    }
+    LossyErrorReport report;
+    report.nSamples = original.size();
+    for(std::size_t tick = 0; tick < original.size(); ++tick)
+      addError(report, original[tick], reconstructed[tick]);
+    finishReport(report);
+    return report;
+  } // CompareWaveforms()
+
+
+  //----------------------------------------------------------------------
+  BoundedErrorCodec::BoundedErrorCodec(unsigned int maxError)
+    : fMaxError(maxError)
+  {
+    if(fMaxError > MaxMaxError){
+      throw cet::exception("raw")
+        << "raw::BoundedErrorCodec: maximum error " << fMaxError
+        << " is larger than the supported " << MaxMaxError << "\n";
+    }
+  }
+
+
+  //----------------------------------------------------------------------
+  void BoundedErrorCodec::Encode
+    (std::vector<short>& adc, CodecParameters const& params) const
+  {
+    CompressBoundedError(adc, fMaxError, params);
+  }
+
+
+  //----------------------------------------------------------------------
+  void BoundedErrorCodec::Decode(std::vector<short> const& adc,
+                                 std::vector<short>&       uncompressed,
+                                 int) const
+  {
+    UncompressBoundedError(adc, uncompressed);
+  }
+
+
+  //----------------------------------------------------------------------
+  void BoundedErrorCodec::DecodeRange(std::vector<short> const& adc,
+                                      std::vector<short>&       uncompressed,
+                                      int,
+                                      std::size_t               tickBegin,
+                                      std::size_t               tickEnd,
+                                      HuffmanIndex const*) const
+  {
+    UncompressBoundedError(adc, uncompressed);
+    std::size_t const end = std::min(tickEnd, uncompressed.size());
+    std::size_t const begin = std::min(tickBegin, end);
+    uncompressed.erase(uncompressed.begin() + end, uncompressed.end());
+    uncompressed.erase(uncompressed.begin(), uncompressed.begin() + begin);
+  } // BoundedErrorCodec::DecodeRange()
+
+} // namespace raw
@@ -0,0 +1,123 @@
+/**
+ * @file    LossyCompression.h
+ * @brief   Compression with a bounded error on the noise samples
+ * @see     LossyCompression.cxx EntropyCodec.h
+ *
+ * Samples close to the pedestal are quantized, with an error on each of
+ * them not larger than a configured value, while the regions above
+ * threshold (and their neighbourhood) are kept exact.
+ * Each sample is predicted by the previous reconstructed one, and the
+ * difference is divided by the quantization step (`2 maxError + 1`, or 1
+ * for the exact samples); the quotients are then compressed with
+ * raw::CompressEntropy().
+ *
+ * Compressed data layout (16-bit words):
+ *
+ * * maximum error
+ * * number of runs of samples (low and high 16 bits), alternating quantized
+ *   and exact ones, starting with quantized (the first run may be empty)
+ * * length of each run (low and high 16 bits)
+ * * the quotients, as the differences between consecutive samples of the
+ *   data compressed by raw::CompressEntropy()
+ */
+
+#ifndef RAWDATA_LOSSYCOMPRESSION_H
+#define RAWDATA_LOSSYCOMPRESSION_H
+
+// LArSoft libraries
+#include "lardataobj/RawData/Codec.h"
+
+// C/C++ standard libraries
+#include <cstddef> // std::size_t
+#include <vector>
+
+
+namespace raw {
+
+  /// Differences between the original and the uncompressed waveform
+  struct LossyErrorReport {
+
+    std::size_t nSamples = 0; ///< number of samples
+    std::size_t nExact = 0; ///< samples in the regions kept exact
+    std::size_t nChanged = 0; ///< samples changed by the compression
+    unsigned int maxAbsError = 0; ///< largest absolute error
+    double rmsError = 0.; ///< RMS of the error over all samples
+
+  }; // struct LossyErrorReport
+
+
+  /**
+   * @brief Compresses a waveform with a bounded error
+   * @param adc uncompressed samples, replaced by the compressed data
+   * @param maxError largest absolute error allowed on each sample
+   * @param params threshold, pedestal and neighbourhood of exact regions
+   * @return the errors introduced by the compression
+   * @throw cet::exception if maxError is larger than 16383
+   *
+   * Samples further than `params.zerothreshold` from the pedestal are kept
+   * exact, together with `params.nearestneighbor` samples (if set) on each
+   * side. If no pedestal is specified, the median of the waveform is used.
+   * Samples which are closer than maxError to the limits of the `short`
+   * range are kept exact too. With a maxError of 0 the compression is
+   * lossless.
+   */
+  LossyErrorReport CompressBoundedError(std::vector<short>&    adc,
+                                        unsigned int           maxError,
+                                        CodecParameters const& params);
+
+  /**
+   * @brief Uncompresses data from raw::CompressBoundedError()
+   * @param adc compressed data
+   * @param uncompressed resized and filled with the uncompressed samples
+   * @throw cet::exception if the data is corrupted or truncated
+   */
+  void UncompressBoundedError(std::vector<short> const& adc,
+                              std::vector<short>&       uncompressed);
+
+  /// Returns the differences of reconstructed from original samples
+  /// @throw cet::exception if the waveforms have different sizes
+  LossyErrorReport CompareWaveforms(std::vector<short> const& original,
+                                    std::vector<short> const& reconstructed);
+
+
+  /**
+   * @brief Codec of raw::CompressBoundedError()
+   *
+   * The codec must be registered in raw::CodecRegistry by the experiments
+   * using it, with the raw::Compress_t they store in their raw::RawDigit.
+   */
+  class BoundedErrorCodec: public Codec {
+
+  public:
+
+    /// Constructor: sets the largest error on each sample
+    explicit BoundedErrorCodec(unsigned int maxError);
+
+    /// Returns the largest error on each sample
+    unsigned int MaxError() const { return fMaxError; }
+
+    void Encode
+      (std::vector<short>& adc, CodecParameters const& params) const override;
+
+    void Decode(std::vector<short> const& adc,
+                std::vector<short>&       uncompressed,
+                int                       pedestal) const override;
+
+    /// Decodes the whole waveform, and keeps only the window (index ignored)
+    void DecodeRange(std::vector<short> const& adc,
+                     std::vector<short>&       uncompressed,
+                     int                       pedestal,
+                     std::size_t               tickBegin,
+                     std::size_t               tickEnd,
+                     HuffmanIndex const*       index) const override;
+
+  private:
+
+    unsigned int fMaxError; ///< largest error on each sample
+
+  }; // class BoundedErrorCodec
+
+} // namespace raw
+
+
+#endif // RAWDATA_LOSSYCOMPRESSION_H
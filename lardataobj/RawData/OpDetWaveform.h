@@ -10,6 +10,7 @@
 #ifndef OpDetWaveform_h
 #define OpDetWaveform_h
 
+#include <cstdint> // uint16_t
 #include <vector>
 #include <functional> // so we can redefine less<> below
 #include <limits>
@@ -0,0 +1,125 @@
+/**
+ * @file    OpDetWaveformIndex.cxx
+ * @brief   Index of optical waveforms by channel and time
+ * @see     OpDetWaveformIndex.h
+ */
+
+#include "lardataobj/RawData/OpDetWaveformIndex.h"
+
+// C/C++ standard libraries
+#include <algorithm> // std::sort(), std::max(), std::lower_bound(), ...
+#include <tuple> // std::tie()
+#include <utility> // std::pair
+
+
+namespace raw {
+
+  //----------------------------------------------------------------------
+  OpDetWaveformIndex::OpDetWaveformIndex
+    (std::vector<raw::OpDetWaveform> const& waveforms, double tickPeriod)
+    : fWaveforms(&waveforms)
+    , fTickPeriod(tickPeriod)
+  {
+    fEntries.reserve(waveforms.size());
+    for(std::size_t i = 0; i < waveforms.size(); ++i){
+      raw::OpDetWaveform const& waveform = waveforms[i];
+      raw::TimeStamp_t const start = waveform.TimeStamp();
+      raw::TimeStamp_t const end = start + waveform.size() * tickPeriod;
+      fEntries.push_back({ waveform.ChannelNumber(), start, end, end, i });
+    }
+
+    std::sort(fEntries.begin(), fEntries.end(),
+      [](Entry const& a, Entry const& b)
+        {
+          return std::tie(a.channel, a.start, a.index)
+            < std::tie(b.channel, b.start, b.index);
+        });
+
+    for(std::size_t i = 1; i < fEntries.size(); ++i){
+      if(fEntries[i].channel != fEntries[i-1].channel) continue;
+      fEntries[i].maxEnd = std::max(fEntries[i].end, fEntries[i-1].maxEnd);
+    }
+  } // OpDetWaveformIndex::OpDetWaveformIndex()
+
+
+  //----------------------------------------------------------------------
+  std::vector<raw::Channel_t> OpDetWaveformIndex::Channels() const
+  {
+    std::vector<raw::Channel_t> channels;
+    for(Entry const& entry: fEntries)
+      if(channels.empty() || (channels.back() != entry.channel))
+        channels.push_back(entry.channel);
+    return channels;
+  } // OpDetWaveformIndex::Channels()
+
+
+  //----------------------------------------------------------------------
+  std::vector<std::size_t> OpDetWaveformIndex::OverlappingIndices
+    (raw::Channel_t channel, raw::TimeStamp_t start, raw::TimeStamp_t end) const
+  {
+    std::vector<std::size_t> indices;
+    forEachOverlapping(channel, start, end,
+      [&indices](Entry const& entry){ indices.push_back(entry.index); });
+    return indices;
+  } // OpDetWaveformIndex::OverlappingIndices()
+
+
+  //----------------------------------------------------------------------
+  std::vector<raw::OpDetWaveform const*> OpDetWaveformIndex::Overlapping
+    (raw::Channel_t channel, raw::TimeStamp_t start, raw::TimeStamp_t end) const
+  {
+    std::vector<raw::OpDetWaveform const*> waveforms;
+    forEachOverlapping(channel, start, end,
+      [this, &waveforms](Entry const& entry)
+        { waveforms.push_back(&(*fWaveforms)[entry.index]); }
+      );
+    return waveforms;
+  } // OpDetWaveformIndex::Overlapping()
+
+
+  //----------------------------------------------------------------------
+  std::vector<raw::OpDetWaveform const*> OpDetWaveformIndex::Waveforms
+    (raw::Channel_t channel) const
+  {
+    auto const [ begin, end ] = channelRange(channel);
+    std::vector<raw::OpDetWaveform const*> waveforms;
+    waveforms.reserve(end - begin);
+    for(auto iEntry = begin; iEntry != end; ++iEntry)
+      waveforms.push_back(&(*fWaveforms)[iEntry->index]);
+    return waveforms;
+  } // OpDetWaveformIndex::Waveforms()
+
+
+  //----------------------------------------------------------------------
+  template <typename F>
+  void OpDetWaveformIndex::forEachOverlapping(raw::Channel_t channel,
+    raw::TimeStamp_t start, raw::TimeStamp_t end, F&& f) const
+  {
+    if(!(start < end)) return;
+    auto const [ channelBegin, channelEnd ] = channelRange(channel);
+
+    // waveforms starting at or after the end of the window are excluded...
+    auto const last = std::partition_point(channelBegin, channelEnd,
+      [end](Entry const& entry){ return entry.start < end; });
+    // ... and so are the ones before the first which may end after its start
+    auto const first = std::partition_point(channelBegin, last,
+      [start](Entry const& entry){ return entry.maxEnd <= start; });
+
+    for(auto iEntry = first; iEntry != last; ++iEntry)
+      if(iEntry->end > start) f(*iEntry);
+  } // OpDetWaveformIndex::forEachOverlapping()
+
+
+  //----------------------------------------------------------------------
+  auto OpDetWaveformIndex::channelRange(raw::Channel_t channel) const
+    -> std::pair<Iter_t, Iter_t>
+  {
+    auto const begin = std::lower_bound(fEntries.begin(), fEntries.end(),
+      channel, [](Entry const& entry, raw::Channel_t channel)
+        { return entry.channel < channel; });
+    auto const end = std::partition_point(begin, fEntries.end(),
+      [channel](Entry const& entry){ return entry.channel == channel; });
+    return { begin, end };
+  } // OpDetWaveformIndex::channelRange()
+
+} // namespace raw
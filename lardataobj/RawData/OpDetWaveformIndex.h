@@ -0,0 +1,120 @@
+/**
+ * @file    OpDetWaveformIndex.h
+ * @brief   Index of optical waveforms by channel and time
+ * @see     OpDetWaveformIndex.cxx OpDetWaveform.h
+ */
+
+#ifndef RAWDATA_OPDETWAVEFORMINDEX_H
+#define RAWDATA_OPDETWAVEFORMINDEX_H
+
+// LArSoft libraries
+#include "lardataobj/RawData/OpDetWaveform.h"
+
+// C/C++ standard libraries
+#include <cstddef> // std::size_t
+#include <utility> // std::pair
+#include <vector>
+
+
+namespace raw {
+
+  /**
+   * @brief Finds the optical waveforms of a channel overlapping a time window
+   *
+   * The waveform `w` covers the times from `w.TimeStamp()` to
+   * `w.TimeStamp() + w.size() * tickPeriod`, end excluded, where the period
+   * of the ticks is the same for all the waveforms, in the same unit as the
+   * time stamps. The index is built once from a collection of waveforms,
+   * which must outlive it and not change while it is in use:
+   *
+   *     raw::OpDetWaveformIndex const index(waveforms, 0.002); // 2 ns ticks
+   *     for(raw::OpDetWaveform const* waveform: index.Overlapping(channel, t0, t1))
+   *       // ...
+   *
+   * The waveforms of each channel are sorted by start time, together with
+   * the latest end time of each waveform and all the ones before it;
+   * a query finds with binary searches the waveforms of the channel
+   * starting before the end of the window and the first one which may end
+   * after its start, in logarithmic time, and checks the waveforms in
+   * between. When the waveforms of a channel do not contain each other,
+   * as in readout windows, all of those overlap the window.
+   *
+   * Waveforms are returned sorted by start time, the ones with the same time
+   * in the order of the collection.
+   */
+  class OpDetWaveformIndex {
+
+  public:
+
+    /**
+     * @brief Constructor: indexes the waveforms of a collection
+     * @param waveforms the collection of waveforms
+     * @param tickPeriod duration of a sample, in the unit of the time stamps
+     */
+    OpDetWaveformIndex
+      (std::vector<raw::OpDetWaveform> const& waveforms, double tickPeriod);
+
+    /// Number of indexed waveforms
+    std::size_t size() const { return fEntries.size(); }
+
+    /// Duration of a sample, in the unit of the time stamps
+    double TickPeriod() const { return fTickPeriod; }
+
+    /// Sorted list of the channels with waveforms
+    std::vector<raw::Channel_t> Channels() const;
+
+    /**
+     * @brief Returns the position in the collection of the matching waveforms
+     * @param channel channel of the waveforms
+     * @param start start of the time window
+     * @param end end of the time window (excluded)
+     * @return indices of the waveforms of channel overlapping the window
+     */
+    std::vector<std::size_t> OverlappingIndices
+      (raw::Channel_t channel, raw::TimeStamp_t start, raw::TimeStamp_t end) const;
+
+    /**
+     * @brief Returns the waveforms of channel overlapping a time window
+     * @param channel channel of the waveforms
+     * @param start start of the time window
+     * @param end end of the time window (excluded)
+     * @return pointers to the waveforms in the collection
+     */
+    std::vector<raw::OpDetWaveform const*> Overlapping
+      (raw::Channel_t channel, raw::TimeStamp_t start, raw::TimeStamp_t end) const;
+
+    /// Returns all the waveforms of channel, sorted by time
+    std::vector<raw::OpDetWaveform const*> Waveforms
+      (raw::Channel_t channel) const;
+
+  private:
+
+    /// Time interval of a waveform
+    struct Entry {
+      raw::Channel_t   channel; ///< channel of the waveform
+      raw::TimeStamp_t start;   ///< time of the first sample
+      raw::TimeStamp_t end;     ///< time after the last sample
+      raw::TimeStamp_t maxEnd;  ///< latest end of this and earlier waveforms
+      std::size_t      index;   ///< position in the collection
+    }; // struct Entry
+
+    using Iter_t = std::vector<Entry>::const_iterator;
+
+    std::vector<raw::OpDetWaveform> const* fWaveforms; ///< the collection
+    double fTickPeriod; ///< duration of a sample
+    std::vector<Entry> fEntries; ///< sorted by channel, then start time
+
+    /// Calls f(entry) for each entry of channel overlapping [start, end)
+    template <typename F>
+    void forEachOverlapping(raw::Channel_t channel,
+      raw::TimeStamp_t start, raw::TimeStamp_t end, F&& f) const;
+
+    /// Returns the range of entries of channel
+    std::pair<Iter_t, Iter_t> channelRange(raw::Channel_t channel) const;
+
+  }; // class OpDetWaveformIndex
+
+} // namespace raw
+
+
+#endif // RAWDATA_OPDETWAVEFORMINDEX_H
@@ -28,6 +28,7 @@
 
 // LArSoft libraries
 #include "larcoreobj/SimpleTypesAndConstants/RawTypes.h" // raw::Compress_t, raw::Channel_t
+#include "lardataobj/RawData/SampleSpan.h"
 
 // ROOT includes
 #include "RtypesCore.h"
@@ -141,6 +142,21 @@ namespace raw {
     /// ADC vector element number i; no decompression is applied
     short           ADC(int i)    const;
 
+    /**
+     * @brief View of the (compressed) ADC count vector
+     *
+     * Unlike ADC(), access to the samples of the view is not checked
+     * (except in debug builds, see raw::SampleSpan), and loops on it can be
+     * vectorized by the compiler:
+     *
+     *     double sum = 0.;
+     *     for(short adc: digit.ADCSpan()) sum += adc;
+     *
+     * The view covers the words of the ADC vector as stored: they are the
+     * samples only if Compression() is raw::kNone.
+     */
+    SampleSpan      ADCSpan()     const;
+
     /// DAQ channel this raw data was read from
     ChannelID_t     Channel()     const;
 
@@ -206,6 +222,7 @@ namespace raw {
 
 inline size_t          raw::RawDigit::NADC()        const { return fADC.size();  }
 inline short           raw::RawDigit::ADC(int i)    const { return fADC.at(i);   }
+inline raw::SampleSpan  raw::RawDigit::ADCSpan()    const { return { fADC.data(), fADC.size() }; }
 inline const raw::RawDigit::ADCvector_t&
                        raw::RawDigit::ADCs()        const { return fADC;         }
 inline raw::ChannelID_t
@@ -0,0 +1,148 @@
+/** ****************************************************************************
+ * @file RawDigitBlock.cxx
+ * @brief Raw digits of many channels in contiguous storage
+ * @see  RawDigitBlock.h
+ *
+ * ****************************************************************************/
+
+#include "lardataobj/RawData/RawDigitBlock.h"
+
+// framework libraries
+#include "cetlib_except/exception.h"
+
+// C/C++ standard libraries
+#include <algorithm> // std::is_sorted()
+#include <utility> // std::move()
+
+
+namespace raw{
+
+  //----------------------------------------------------------------------
+  RawDigitBlock::RawDigitBlock()
+    : fChannels()
+    , fSamples()
+    , fPedestals()
+    , fSigmas()
+    , fCompressions()
+    , fADCs()
+    , fOffsets(1, 0)
+  {}
+
+
+  //----------------------------------------------------------------------
+  RawDigitBlock::RawDigitBlock(
+    std::vector<raw::ChannelID_t> channels,
+    std::vector<ULong64_t>        samples,
+    std::vector<float>            pedestals,
+    std::vector<float>            sigmas,
+    std::vector<raw::Compress_t>  compressions,
+    std::vector<short>            adcs,
+    std::vector<ULong64_t>        offsets
+  )
+    : fChannels(std::move(channels))
+    , fSamples(std::move(samples))
+    , fPedestals(std::move(pedestals))
+    , fSigmas(std::move(sigmas))
+    , fCompressions(std::move(compressions))
+    , fADCs(std::move(adcs))
+    , fOffsets(std::move(offsets))
+  {
+    size_t const nDigits = fChannels.size();
+    if((fSamples.size() != nDigits) || (fPedestals.size() != nDigits)
+      || (fSigmas.size() != nDigits) || (fCompressions.size() != nDigits))
+    {
+      throw cet::exception("RawDigitBlock")
+        << "properties of " << nDigits << " digits have different sizes ("
+        << fSamples.size() << " samples, " << fPedestals.size()
+        << " pedestals, " << fSigmas.size() << " sigmas, "
+        << fCompressions.size() << " compressions)\n";
+    }
+    if(fOffsets.size() != nDigits + 1){
+      throw cet::exception("RawDigitBlock")
+        << fOffsets.size() << " offsets for " << nDigits
+        << " digits (expected " << (nDigits + 1) << ")\n";
+    }
+    if((fOffsets.front() != 0) || (fOffsets.back() != fADCs.size())
+      || !std::is_sorted(fOffsets.begin(), fOffsets.end()))
+    {
+      throw cet::exception("RawDigitBlock")
+        << "digit offsets do not match the " << fADCs.size()
+        << " ADC counts\n";
+    }
+  } // RawDigitBlock::RawDigitBlock()
+
+
+  //----------------------------------------------------------------------
+  RawDigitBlock::RawDigitBlock(std::vector<raw::RawDigit> const& digits)
+    : RawDigitBlock()
+  {
+    size_t nADCs = 0;
+    for(raw::RawDigit const& digit: digits) nADCs += digit.NADC();
+    Reserve(digits.size(), nADCs);
+    for(raw::RawDigit const& digit: digits) AddDigit(digit);
+  } // RawDigitBlock::RawDigitBlock(digits)
+
+
+  //----------------------------------------------------------------------
+  void RawDigitBlock::Reserve(size_t nDigits, size_t nADCs)
+  {
+    fChannels.reserve(nDigits);
+    fSamples.reserve(nDigits);
+    fPedestals.reserve(nDigits);
+    fSigmas.reserve(nDigits);
+    fCompressions.reserve(nDigits);
+    fOffsets.reserve(nDigits + 1);
+    fADCs.reserve(nADCs);
+  } // RawDigitBlock::Reserve()
+
+
+  //----------------------------------------------------------------------
+  void RawDigitBlock::AddDigit(raw::ChannelID_t channel,
+                               ULong64_t        samples,
+                               short const*     adcs,
+                               size_t           nADCs,
+                               raw::Compress_t  compression /* = raw::kNone */,
+                               float            pedestal /* = 0. */,
+                               float            sigma /* = 0. */)
+  {
+    fChannels.push_back(channel);
+    fSamples.push_back(samples);
+    fPedestals.push_back(pedestal);
+    fSigmas.push_back(sigma);
+    fCompressions.push_back(compression);
+    fADCs.insert(fADCs.end(), adcs, adcs + nADCs);
+    fOffsets.push_back(fADCs.size());
+  } // RawDigitBlock::AddDigit()
+
+
+  //----------------------------------------------------------------------
+  void RawDigitBlock::AddDigit(raw::RawDigit const& digit)
+  {
+    AddDigit(digit.Channel(), digit.Samples(), digit.ADCs().data(),
+      digit.NADC(), digit.Compression(), digit.GetPedestal(), digit.GetSigma());
+  } // RawDigitBlock::AddDigit(RawDigit)
+
+
+  //----------------------------------------------------------------------
+  raw::RawDigit RawDigitBlock::MakeRawDigit(size_t i) const
+  {
+    raw::RawDigitRef const digit = Digit(i);
+    raw::SampleSpan const adcs = digit.ADCs();
+    raw::RawDigit copy(digit.Channel(), digit.Samples(),
+      raw::RawDigit::ADCvector_t(adcs.begin(), adcs.end()), digit.Compression());
+    copy.SetPedestal(digit.GetPedestal(), digit.GetSigma());
+    return copy;
+  } // RawDigitBlock::MakeRawDigit()
+
+
+  //----------------------------------------------------------------------
+  std::vector<raw::RawDigit> RawDigitBlock::MakeRawDigits() const
+  {
+    std::vector<raw::RawDigit> digits;
+    digits.reserve(NDigits());
+    for(size_t i = 0; i < NDigits(); ++i) digits.push_back(MakeRawDigit(i));
+    return digits;
+  } // RawDigitBlock::MakeRawDigits()
+
+} // namespace raw
+////////////////////////////////////////////////////////////////////////
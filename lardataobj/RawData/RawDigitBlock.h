@@ -0,0 +1,296 @@
+/** ****************************************************************************
+ * @file RawDigitBlock.h
+ * @brief Raw digits of many channels in contiguous storage
+ * @see  RawDigitBlock.cxx RawDigit.h
+ *
+ * ****************************************************************************/
+
+#ifndef RAWDATA_RAWDIGITBLOCK_H
+#define RAWDATA_RAWDIGITBLOCK_H
+
+// C/C++ standard libraries
+#include <cstddef> // std::ptrdiff_t
+#include <cstdlib> // size_t
+#include <iterator> // std::forward_iterator_tag
+#include <vector>
+
+// LArSoft libraries
+#include "lardataobj/RawData/RawDigit.h"
+#include "lardataobj/RawData/SampleSpan.h"
+#include "larcoreobj/SimpleTypesAndConstants/RawTypes.h" // raw::Compress_t, raw::ChannelID_t
+
+// ROOT includes
+#include "RtypesCore.h"
+
+
+namespace raw {
+
+  class RawDigitBlock;
+
+  /**
+   * @brief View of a digit in a raw::RawDigitBlock, with the interface of
+   *        raw::RawDigit
+   *
+   * The view points into the block, which must outlive it.
+   * The only difference from raw::RawDigit is that ADCs() returns a
+   * raw::SampleSpan rather than a reference to a vector; code which needs a
+   * vector can use `RawDigitBlock::MakeRawDigit()`.
+   */
+  class RawDigitRef {
+
+  public:
+    /// Constructor: points to the digit with the specified index in block
+    RawDigitRef(RawDigitBlock const& block, size_t index)
+      : fBlock(&block), fIndex(index)
+      {}
+
+    ///@{
+    ///@name Accessors, as in raw::RawDigit
+
+    /// The compressed ADC counts
+    SampleSpan      ADCs()        const;
+
+    /// Number of elements in the compressed ADC sample vector
+    size_t          NADC()        const;
+
+    /// ADC vector element number i; no decompression is applied
+    short           ADC(int i)    const;
+
+    /// DAQ channel this raw data was read from
+    ChannelID_t     Channel()     const;
+
+    /// Number of samples in the uncompressed ADC data
+    ULong64_t       Samples()     const;
+
+    /// Pedestal level (ADC counts)
+    float           GetPedestal() const;
+
+    /// RMS of the pedestal level
+    float           GetSigma()    const;
+
+    /// Compression algorithm used to store the ADC counts
+    raw::Compress_t Compression() const;
+    ///@}
+
+    /// Index of the digit in the block
+    size_t          Index()       const { return fIndex; }
+
+  private:
+    RawDigitBlock const* fBlock; ///< the block the digit is in
+    size_t               fIndex; ///< index of the digit in the block
+
+  }; // class RawDigitRef
+
+
+  /**
+   * @brief Raw digits of many channels in contiguous storage
+   *
+   * This data product holds the same information as a collection of
+   * raw::RawDigit, with the (compressed) ADC counts of all the digits in a
+   * single buffer, one digit after the other, and each of the other
+   * properties of the digits in its own array. The ADC counts of digit `i`
+   * are the ones from `Offsets()[i]` to `Offsets()[i + 1]`.
+   *
+   * Each digit can be accessed through a raw::RawDigitRef, which has the
+   * same interface as raw::RawDigit:
+   *
+   *     for(raw::RawDigitRef digit: block){
+   *       raw::ChannelID_t const channel = digit.Channel();
+   *       raw::SampleSpan const adcs = digit.ADCs();
+   *       // ...
+   *     }
+   *
+   * A block is filled with AddDigit(), or it is created from a collection of
+   * raw::RawDigit.
+   */
+  class RawDigitBlock {
+
+  public:
+
+    /// Iterator to the digits in the block, as raw::RawDigitRef
+    class const_iterator {
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = RawDigitRef;
+      using difference_type = std::ptrdiff_t;
+      using pointer = void;
+      using reference = RawDigitRef;
+
+      const_iterator(RawDigitBlock const& block, size_t index)
+        : fBlock(&block), fIndex(index)
+        {}
+
+      RawDigitRef operator*() const { return { *fBlock, fIndex }; }
+      const_iterator& operator++() { ++fIndex; return *this; }
+      const_iterator operator++(int)
+        { const_iterator const old = *this; ++fIndex; return old; }
+      bool operator==(const_iterator const& other) const
+        { return (fIndex == other.fIndex) && (fBlock == other.fBlock); }
+      bool operator!=(const_iterator const& other) const
+        { return !(*this == other); }
+
+    private:
+      RawDigitBlock const* fBlock;
+      size_t               fIndex;
+    }; // class const_iterator
+
+
+    /// Default constructor: an empty block
+    RawDigitBlock();
+
+    /**
+     * @brief Constructor: sets all the data
+     * @param channels channel of each digit
+     * @param samples number of uncompressed samples of each digit
+     * @param pedestals pedestal of each digit
+     * @param sigmas RMS of the pedestal of each digit
+     * @param compressions compression of the ADC counts of each digit
+     * @param adcs (compressed) ADC counts of all the digits
+     * @param offsets start of the ADC counts of each digit, then their size
+     * @throw cet::exception if the sizes of the arrays do not match
+     */
+    RawDigitBlock(std::vector<raw::ChannelID_t> channels,
+                  std::vector<ULong64_t>        samples,
+                  std::vector<float>            pedestals,
+                  std::vector<float>            sigmas,
+                  std::vector<raw::Compress_t>  compressions,
+                  std::vector<short>            adcs,
+                  std::vector<ULong64_t>        offsets);
+
+    /// Constructor: copies the content of the digits, in the same order
+    explicit RawDigitBlock(std::vector<raw::RawDigit> const& digits);
+
+    /// Prepares room for nDigits digits, with nADCs ADC counts in total
+    void Reserve(size_t nDigits, size_t nADCs);
+
+    /**
+     * @brief Adds a digit at the end of the block
+     * @param channel ID of the channel the digits were acquired from
+     * @param samples number of ADC samples in the uncompressed collection
+     * @param adcs pointer to the (compressed) ADC counts
+     * @param nADCs number of (compressed) ADC counts
+     * @param compression compression algorithm used in adcs
+     * @param pedestal pedestal level
+     * @param sigma RMS of the pedestal level
+     */
+    void AddDigit(raw::ChannelID_t channel,
+                  ULong64_t        samples,
+                  short const*     adcs,
+                  size_t           nADCs,
+                  raw::Compress_t  compression = raw::kNone,
+                  float            pedestal = 0.,
+                  float            sigma = 0.);
+
+    /// Adds a copy of digit at the end of the block
+    void AddDigit(raw::RawDigit const& digit);
+
+    ///@{
+    ///@name Accessors
+
+    /// Number of digits in the block
+    size_t                               NDigits()           const;
+
+    /// Whether the block has no digit
+    bool                                 empty()             const;
+
+    /// View of the digit with the specified index
+    RawDigitRef                          Digit(size_t i)     const;
+    RawDigitRef                          operator[](size_t i) const;
+
+    const_iterator                       begin()             const;
+    const_iterator                       end()               const;
+
+    /// Channel of each digit
+    std::vector<raw::ChannelID_t> const& Channels()          const;
+
+    /// Number of uncompressed samples of each digit
+    std::vector<ULong64_t> const&        SampleCounts()      const;
+
+    /// Pedestal of each digit
+    std::vector<float> const&            Pedestals()         const;
+
+    /// RMS of the pedestal of each digit
+    std::vector<float> const&            Sigmas()            const;
+
+    /// Compression of each digit
+    std::vector<raw::Compress_t> const&  Compressions()      const;
+
+    /// ADC counts of all the digits
+    std::vector<short> const&            ADCData()           const;
+
+    /// Start of the ADC counts of each digit, followed by their total size
+    std::vector<ULong64_t> const&        Offsets()           const;
+    ///@}
+
+    /// Returns a raw::RawDigit with a copy of the digit with index i
+    raw::RawDigit MakeRawDigit(size_t i) const;
+
+    /// Returns a copy of all the digits as raw::RawDigit
+    std::vector<raw::RawDigit> MakeRawDigits() const;
+
+
+  private:
+    std::vector<raw::ChannelID_t> fChannels;     ///< channel of each digit
+    std::vector<ULong64_t>        fSamples;      ///< number of ticks of each digit
+    std::vector<float>            fPedestals;    ///< pedestal of each digit
+    std::vector<float>            fSigmas;       ///< pedestal RMS of each digit
+    std::vector<raw::Compress_t>  fCompressions; ///< compression of each digit
+    std::vector<short>            fADCs;         ///< ADC counts of all the digits
+    std::vector<ULong64_t>        fOffsets;      ///< start of each digit, and size
+
+  }; // class RawDigitBlock
+
+
+} // namespace raw
+
+
+//------------------------------------------------------------------------------
+//--- inline implementation
+//---
+
+inline size_t raw::RawDigitBlock::NDigits() const
+  { return fChannels.size(); }
+inline bool raw::RawDigitBlock::empty() const
+  { return fChannels.empty(); }
+inline raw::RawDigitRef raw::RawDigitBlock::Digit(size_t i) const
+  { return { *this, i }; }
+inline raw::RawDigitRef raw::RawDigitBlock::operator[](size_t i) const
+  { return Digit(i); }
+inline raw::RawDigitBlock::const_iterator raw::RawDigitBlock::begin() const
+  { return { *this, 0 }; }
+inline raw::RawDigitBlock::const_iterator raw::RawDigitBlock::end() const
+  { return { *this, NDigits() }; }
+inline std::vector<raw::ChannelID_t> const& raw::RawDigitBlock::Channels() const
+  { return fChannels; }
+inline std::vector<ULong64_t> const& raw::RawDigitBlock::SampleCounts() const
+  { return fSamples; }
+inline std::vector<float> const& raw::RawDigitBlock::Pedestals() const
+  { return fPedestals; }
+inline std::vector<float> const& raw::RawDigitBlock::Sigmas() const
+  { return fSigmas; }
+inline std::vector<raw::Compress_t> const& raw::RawDigitBlock::Compressions() const
+  { return fCompressions; }
+inline std::vector<short> const& raw::RawDigitBlock::ADCData() const
+  { return fADCs; }
+inline std::vector<ULong64_t> const& raw::RawDigitBlock::Offsets() const
+  { return fOffsets; }
+
+inline raw::SampleSpan raw::RawDigitRef::ADCs() const
+  { return { fBlock->ADCData().data() + fBlock->Offsets()[fIndex], NADC() }; }
+inline size_t raw::RawDigitRef::NADC() const
+  { return fBlock->Offsets()[fIndex + 1] - fBlock->Offsets()[fIndex]; }
+inline short raw::RawDigitRef::ADC(int i) const
+  { return ADCs().at(i); }
+inline raw::ChannelID_t raw::RawDigitRef::Channel() const
+  { return fBlock->Channels()[fIndex]; }
+inline ULong64_t raw::RawDigitRef::Samples() const
+  { return fBlock->SampleCounts()[fIndex]; }
+inline float raw::RawDigitRef::GetPedestal() const
+  { return fBlock->Pedestals()[fIndex]; }
+inline float raw::RawDigitRef::GetSigma() const
+  { return fBlock->Sigmas()[fIndex]; }
+inline raw::Compress_t raw::RawDigitRef::Compression() const
+  { return fBlock->Compressions()[fIndex]; }
+
+
+#endif // RAWDATA_RAWDIGITBLOCK_H
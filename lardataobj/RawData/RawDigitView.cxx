@@ -0,0 +1,38 @@
+/**
+ * @file    RawDigitView.cxx
+ * @brief   Raw digit with its uncompressed samples, uncompressed on demand
+ * @see     RawDigitView.h
+ */
+
+#include "lardataobj/RawData/RawDigitView.h"
+#include "lardataobj/RawData/raw.h"
+
+// C/C++ standard libraries
+#include <cmath> // std::lround()
+#include <utility> // std::move()
+
+
+namespace raw {
+
+  //----------------------------------------------------------------------
+  SampleSpan RawDigitView::Uncompressed() const
+  {
+    if(fDigit->Compression() == raw::kNone)
+      return { fDigit->ADCs().data(), fDigit->ADCs().size() };
+    std::call_once(fOnce, &RawDigitView::uncompress, this);
+    return { fUncompressed.data(), fUncompressed.size() };
+  } // RawDigitView::Uncompressed()
+
+
+  //----------------------------------------------------------------------
+  void RawDigitView::uncompress() const
+  {
+    std::vector<short> uncompressed(fDigit->Samples());
+    raw::Uncompress(fDigit->ADCs(), uncompressed,
+      static_cast<int>(std::lround(fDigit->GetPedestal())),
+      fDigit->Compression());
+    fUncompressed = std::move(uncompressed);
+    fDone = true;
+  } // RawDigitView::uncompress()
+
+} // namespace raw
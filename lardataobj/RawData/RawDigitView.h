@@ -0,0 +1,83 @@
+/**
+ * @file    RawDigitView.h
+ * @brief   Raw digit with its uncompressed samples, uncompressed on demand
+ * @see     RawDigitView.cxx RawDigit.h raw.h
+ */
+
+#ifndef RAWDATA_RAWDIGITVIEW_H
+#define RAWDATA_RAWDIGITVIEW_H
+
+// LArSoft libraries
+#include "lardataobj/RawData/RawDigit.h"
+#include "lardataobj/RawData/SampleSpan.h"
+
+// C/C++ standard libraries
+#include <atomic>
+#include <mutex> // std::once_flag
+#include <vector>
+
+
+namespace raw {
+
+  /**
+   * @brief A raw digit, with its samples uncompressed on first access
+   *
+   * The view refers to a raw::RawDigit, which must outlive it, and it
+   * uncompresses its samples the first time they are requested; the
+   * following requests return the same samples. Uncompressed digits
+   * (raw::kNone) are not copied.
+   *
+   * Uncompressed() can be called concurrently from many threads: only one of
+   * them uncompresses the data, while the others wait for it. If the
+   * uncompression throws an exception, the next call tries again.
+   *
+   * The view is not part of the data product, and it is not persisted.
+   * Algorithms sharing the same digits should share the same views too, e.g.
+   *
+   *     std::deque<raw::RawDigitView> views(digits.begin(), digits.end());
+   *
+   * (views can't be copied nor moved, so they can't be stored in a
+   * `std::vector`).
+   */
+  class RawDigitView {
+
+  public:
+
+    /// Constructor: refers to digit, and uncompresses nothing yet
+    RawDigitView(raw::RawDigit const& digit): fDigit(&digit) {}
+
+    RawDigitView(RawDigitView const&) = delete;
+    RawDigitView& operator=(RawDigitView const&) = delete;
+
+    /// The digit
+    raw::RawDigit const& Digit() const { return *fDigit; }
+
+    /**
+     * @brief Returns the uncompressed samples of the digit
+     * @return `Digit().Samples()` samples
+     * @throw cet::exception if the compression of the digit is not supported
+     *
+     * The samples suppressed by zero suppression are at the pedestal of the
+     * digit, rounded to the closest integer.
+     */
+    SampleSpan Uncompressed() const;
+
+    /// Returns whether the samples are available without uncompression
+    bool IsUncompressed() const
+      { return (fDigit->Compression() == raw::kNone) || fDone.load(); }
+
+  private:
+    raw::RawDigit const* fDigit;     ///< the digit
+    mutable std::once_flag fOnce;    ///< to uncompress only once
+    mutable std::vector<short> fUncompressed; ///< the uncompressed samples
+    mutable std::atomic<bool> fDone{ false }; ///< set after the uncompression
+
+    /// Fills fUncompressed
+    void uncompress() const;
+
+  }; // class RawDigitView
+
+} // namespace raw
+
+
+#endif // RAWDATA_RAWDIGITVIEW_H
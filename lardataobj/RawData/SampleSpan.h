@@ -0,0 +1,80 @@
+/**
+ * @file    SampleSpan.h
+ * @brief   Non-owning view of a contiguous sequence of ADC samples
+ * @see     RawDigit.h RawDigitBlock.h
+ */
+
+#ifndef RAWDATA_SAMPLESPAN_H
+#define RAWDATA_SAMPLESPAN_H
+
+// C/C++ standard libraries
+#include <cassert>
+#include <cstddef> // std::size_t
+#include <stdexcept> // std::out_of_range
+#include <string>
+
+
+namespace raw {
+
+  /**
+   * @brief Read-only view of contiguous ADC samples
+   *
+   * This is a minimal replacement for `std::span<short const>`: it points to
+   * samples owned by someone else (e.g. a raw::RawDigitBlock), which must
+   * outlive it. Access with `at()` is always checked, while `operator[]` is
+   * checked by an assertion only in debug builds (without `NDEBUG`), so that
+   * loops on the samples are as fast as on a plain array otherwise.
+   */
+  class SampleSpan {
+
+  public:
+    using value_type = short;
+    using size_type = std::size_t;
+    using const_iterator = short const*;
+    using iterator = const_iterator;
+
+    /// Default constructor: an empty span
+    SampleSpan() = default;
+
+    /// Constructor: points to size samples starting at data
+    SampleSpan(short const* data, std::size_t size)
+      : fData(data), fSize(size)
+      {}
+
+    /// Pointer to the first sample
+    short const* data() const { return fData; }
+
+    /// Number of samples
+    std::size_t size() const { return fSize; }
+
+    /// Whether there are no samples
+    bool empty() const { return fSize == 0; }
+
+    const_iterator begin() const { return fData; }
+    const_iterator end() const { return fData + fSize; }
+
+    /// Sample i (checked only in debug builds)
+    short operator[](std::size_t i) const
+      { assert(i < fSize); return fData[i]; }
+
+    /// Sample i
+    /// @throw std::out_of_range if there is no sample i
+    short at(std::size_t i) const
+      {
+        if(i >= fSize){
+          throw std::out_of_range("raw::SampleSpan::at(" + std::to_string(i)
+            + "): only " + std::to_string(fSize) + " samples");
+        }
+        return fData[i];
+      }
+
+  private:
+    short const* fData = nullptr; ///< first sample
+    std::size_t  fSize = 0;       ///< number of samples
+
+  }; // class SampleSpan
+
+} // namespace raw
+
+
+#endif // RAWDATA_SAMPLESPAN_H
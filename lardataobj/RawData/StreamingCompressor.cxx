@@ -0,0 +1,311 @@
+/**
+ * @file    StreamingCompressor.cxx
+ * @brief   Compression of waveforms received a fragment at a time
+ * @see     StreamingCompressor.h
+ */
+
+#include "lardataobj/RawData/StreamingCompressor.h"
+#include "lardataobj/RawData/ZeroSuppressor.h" // raw::PackZeroSuppressed()
+#include "lardataobj/RawData/raw.h"
+
+// framework libraries
+#include "cetlib_except/exception.h"
+
+// C/C++ standard libraries
+#include <algorithm> // std::max()
+#include <cassert>
+
+
+namespace {
+
+  /// Length of the Huffman codes for differences from -3 to +3
+  /// (see raw::CompressHuffman())
+  constexpr unsigned int HuffmanCodeLength[7] = { 8, 6, 4, 2, 3, 5, 7 };
+
+  /// Returns the word for a value escaped from Huffman encoding
+  /// (same as raw::CompressHuffman())
+  short huffmanEscape(short value)
+  {
+    return (value > 0)
+      ? value: static_cast<short>(((-value) & 0xffff) | 0x4000);
+  }
+
+} // local namespace
+
+
+namespace raw {
+
+  //----------------------------------------------------------------------
+  StreamingCompressor::StreamingCompressor
+    (raw::Compress_t compress, CodecParameters const& params)
+    : fCompress(compress)
+    , fThreshold(params.zerothreshold)
+    , fPedestal(params.pedestal.value_or(0))
+    , fNearestNeighbor(params.nearestneighbor.value_or(0))
+    , fStickyCodes(params.pedestal && params.fADCStickyCodeFeature)
+    , fNeighborhood(params.pedestal || params.nearestneighbor)
+  {
+    switch(fCompress){
+      case raw::kNone:
+      case raw::kHuffman:
+      case raw::kZeroSuppression:
+      case raw::kZeroHuffman:
+        break;
+      default:
+        throw cet::exception("raw")
+          << "raw::StreamingCompressor does not support compression #"
+          << fCompress << "\n";
+    } // switch
+    if(params.neighbors){
+      throw cet::exception("raw")
+        << "raw::StreamingCompressor does not support zero suppression"
+           " with neighbouring channels\n";
+    }
+  } // StreamingCompressor::StreamingCompressor()
+
+
+  //----------------------------------------------------------------------
+  void StreamingCompressor::Push(short const* adc, std::size_t n)
+  {
+    fNTicks += n;
+    if(fCompress == raw::kNone){
+      fOutput.insert(fOutput.end(), adc, adc + n);
+      return;
+    }
+    fBuffer.insert(fBuffer.end(), adc, adc + n);
+    process(false);
+    trimBuffer();
+  } // StreamingCompressor::Push()
+
+
+  //----------------------------------------------------------------------
+  std::size_t StreamingCompressor::TakeOutput(std::vector<short>& out)
+  {
+    std::size_t const n = fOutput.size();
+    out.insert(out.end(), fOutput.begin(), fOutput.end());
+    fOutput.clear();
+    return n;
+  } // StreamingCompressor::TakeOutput()
+
+
+  //----------------------------------------------------------------------
+  std::size_t StreamingCompressor::Finish(std::vector<short>& out)
+  {
+    process(true);
+
+    if(fCompress == raw::kHuffman){
+      // the last word is always written, like raw::CompressHuffman() does
+      if(fNTicks > 0) fOutput.push_back(static_cast<short>(fWord));
+    }
+    else if(fCompress != raw::kNone){
+      std::vector<short> suppressed;
+      PackZeroSuppressed(suppressed, fNTicks, fBlockBegin.data(),
+        fBlockSize.data(), fBlockBegin.size(), fData.data(), fData.size(),
+        (fCompress == raw::kZeroHuffman)
+          ? ZeroHuffmanMaxShortTicks: ZeroSuppressionMaxShortTicks);
+      if(fCompress == raw::kZeroHuffman) raw::CompressHuffman(suppressed);
+      fOutput.insert(fOutput.end(), suppressed.begin(), suppressed.end());
+    }
+
+    std::size_t const n = TakeOutput(out);
+    reset();
+    return n;
+  } // StreamingCompressor::Finish()
+
+
+  //----------------------------------------------------------------------
+  bool StreamingCompressor::overThreshold(std::size_t tick) const
+  {
+    return ADCStickyCodeCheck(sample(tick), fPedestal, fStickyCodes)
+      > static_cast<int>(fThreshold);
+  } // StreamingCompressor::overThreshold()
+
+
+  //----------------------------------------------------------------------
+  // Huffman encoding may need the 3 samples after the current one, and the
+  // end of a zero-suppressed block with neighbourhood the next 2; the
+  // other ticks are processed as soon as they arrive.
+  void StreamingCompressor::process(bool finishing)
+  {
+    switch(fCompress){
+      case raw::kHuffman:
+        if((fNext == 0) && (fNTicks > 0)){
+          fOutput.push_back(sample(0)); // the first sample is written as is
+          fNext = 1;
+        }
+        while((fNext < fNTicks) && (finishing || (fNext + 3 < fNTicks)))
+          fNext = encodeTick(fNext) + 1;
+        break;
+      case raw::kZeroSuppression:
+      case raw::kZeroHuffman:
+        if(!fNeighborhood){
+          while(fNext < fNTicks) suppressTick(fNext++);
+          break;
+        }
+        while((fNext < fNTicks) && (finishing || (fNext + 2 < fNTicks)))
+          suppressNeighborhoodTick(fNext++);
+        break;
+      default:
+        break;
+    } // switch
+  } // StreamingCompressor::process()
+
+
+  //----------------------------------------------------------------------
+  // blocks are runs of samples above threshold, plus the first sample
+  // below threshold after each of them (see raw::ZeroSuppressor::Suppress())
+  void StreamingCompressor::suppressTick(std::size_t tick)
+  {
+    if(overThreshold(tick)){
+      if(!fInBlock){
+        fBlockBegin.push_back(tick);
+        fBlockSize.push_back(0);
+        fInBlock = true;
+      }
+      extendBlock(1);
+    }
+    else if(fInBlock){
+      extendBlock(1);
+      fInBlock = false;
+    }
+  } // StreamingCompressor::suppressTick()
+
+
+  //----------------------------------------------------------------------
+  // This is the algorithm of raw::ZeroSuppressor, one tick at a time.
+  // Like there, samples are always added right after the current end of the
+  // block, which may lag behind the tick being processed.
+  void StreamingCompressor::suppressNeighborhoodTick(std::size_t tick)
+  {
+    int const i = tick;
+    int const nn = fNearestNeighbor;
+    if(!fInBlock){
+      if(!overThreshold(tick)) return;
+      if(fBlockBegin.empty()
+        || (i - nn > fBlockBegin.back() + fBlockSize.back() + 1))
+      {
+        fBlockBegin.push_back(std::max(i - nn, 0));
+        fBlockSize.push_back(0);
+      } // otherwise the previous block is extended
+      extendBlock(i - fBlockBegin.back() + 1 - fBlockSize.back());
+      fInBlock = true;
+    }
+    else if(overThreshold(tick)){
+      extendBlock(1);
+      fEndOfBlockCheck = 0;
+    }
+    else if(fEndOfBlockCheck < nn){
+      extendBlock(1);
+      ++fEndOfBlockCheck;
+    }
+    else if((tick + 2 < fNTicks)
+      && !overThreshold(tick + 1) && !overThreshold(tick + 2))
+    {
+      fEndOfBlockCheck = 0;
+      fInBlock = false;
+    }
+  } // StreamingCompressor::suppressNeighborhoodTick()
+
+
+  //----------------------------------------------------------------------
+  void StreamingCompressor::extendBlock(int n)
+  {
+    std::size_t const end = fBlockBegin.back() + fBlockSize.back();
+    for(int i = 0; i < n; ++i) fData.push_back(sample(end + i));
+    fBlockSize.back() += n;
+  } // StreamingCompressor::extendBlock()
+
+
+  //----------------------------------------------------------------------
+  // same encoding as raw::CompressHuffman()
+  std::size_t StreamingCompressor::encodeTick(std::size_t tick)
+  {
+    short const diff = sample(tick) - sample(tick - 1);
+    unsigned int const index = diff + 3;
+
+    if(index < 7U){
+      unsigned int length = HuffmanCodeLength[index];
+      if(diff == 0 && tick + 3 < fNTicks && sample(tick + 1) == sample(tick)
+        && sample(tick + 2) == sample(tick) && sample(tick + 3) == sample(tick))
+      {
+        length = 1U;
+        tick += 3;
+      }
+      if(fFreeBit < length){
+        fOutput.push_back(static_cast<short>(fWord));
+        fWord = 0x8000U;
+        fFreeBit = 15U;
+      }
+      fFreeBit -= length;
+      fWord |= 1U << fFreeBit;
+    }
+    else{
+      if(fFreeBit != 15U) fOutput.push_back(static_cast<short>(fWord));
+      fWord = 0x8000U;
+      fFreeBit = 15U;
+      fOutput.push_back(huffmanEscape(sample(tick)));
+    }
+    return tick;
+  } // StreamingCompressor::encodeTick()
+
+
+  //----------------------------------------------------------------------
+  std::size_t StreamingCompressor::firstNeeded() const
+  {
+    switch(fCompress){
+      case raw::kHuffman:
+        return (fNext > 0)? fNext - 1: 0; // the previous sample is needed
+      case raw::kZeroSuppression:
+      case raw::kZeroHuffman:
+        break;
+      default:
+        return fNTicks;
+    } // switch
+
+    if(fInBlock) // samples are added from the end of the block
+      return fBlockBegin.back() + fBlockSize.back();
+    if(!fNeighborhood) return fNext;
+
+    // a new block may start nearestneighbor ticks before the next tick...
+    std::size_t const nn = std::max(fNearestNeighbor, 0);
+    std::size_t const first = (fNext > nn)? fNext - nn: 0;
+    if(fBlockBegin.empty()) return first;
+
+    // ... or it may be merged with the previous one, appending from its end
+    // (a new block can't start before the tick after that end)
+    std::size_t const lastEnd = fBlockBegin.back() + fBlockSize.back();
+    return (first <= lastEnd + 1)? lastEnd: first;
+  } // StreamingCompressor::firstNeeded()
+
+
+  //----------------------------------------------------------------------
+  // samples are removed only when they are at least half of the buffer,
+  // so that each one is moved a bounded number of times on average
+  void StreamingCompressor::trimBuffer()
+  {
+    assert(firstNeeded() >= fBufferStart);
+    std::size_t const drop = firstNeeded() - fBufferStart;
+    if((drop == 0) || (drop < fBuffer.size() / 2)) return;
+    fBuffer.erase(fBuffer.begin(), fBuffer.begin() + drop);
+    fBufferStart += drop;
+  } // StreamingCompressor::trimBuffer()
+
+
+  //----------------------------------------------------------------------
+  void StreamingCompressor::reset()
+  {
+    fNTicks = 0;
+    fNext = 0;
+    fBuffer.clear();
+    fBufferStart = 0;
+    fOutput.clear();
+    fBlockBegin.clear();
+    fBlockSize.clear();
+    fData.clear();
+    fInBlock = false;
+    fEndOfBlockCheck = 0;
+    fWord = 0x8000U;
+    fFreeBit = 15U;
+  } // StreamingCompressor::reset()
+
+} // namespace raw
@@ -0,0 +1,169 @@
+/**
+ * @file    StreamingCompressor.h
+ * @brief   Compression of waveforms received a fragment at a time
+ * @see     StreamingCompressor.cxx raw.h ZeroSuppressor.h
+ *
+ * In continuous readout the samples of a channel arrive in fragments, and
+ * the whole waveform may never be available at once. raw::StreamingCompressor
+ * compresses the samples as they arrive, looking ahead by at most a few ticks,
+ * and produces the same data as raw::Compress() on the whole waveform.
+ */
+
+#ifndef RAWDATA_STREAMINGCOMPRESSOR_H
+#define RAWDATA_STREAMINGCOMPRESSOR_H
+
+// LArSoft libraries
+#include "lardataobj/RawData/Codec.h"
+#include "larcoreobj/SimpleTypesAndConstants/RawTypes.h" // raw::Compress_t
+
+// C/C++ standard libraries
+#include <cstddef> // std::size_t
+#include <vector>
+
+
+namespace raw {
+
+  /**
+   * @brief Compresses a waveform pushed a fragment at a time
+   *
+   * The samples are given with Push() in order, in fragments of any size;
+   * Finish() completes the compressed waveform, which is the same as the one
+   * of `raw::Compress()` on all the samples with the same parameters.
+   * The compressor is then ready for a new waveform.
+   *
+   *     raw::StreamingCompressor compressor(raw::kHuffman);
+   *     std::vector<short> compressed;
+   *     for(auto const& fragment: fragments){
+   *       compressor.Push(fragment);
+   *       compressor.TakeOutput(compressed);
+   *     }
+   *     compressor.Finish(compressed);
+   *
+   * Supported compression types are raw::kNone, raw::kHuffman,
+   * raw::kZeroSuppression and raw::kZeroHuffman; zero suppression with
+   * neighbouring channels is not supported.
+   *
+   * Huffman-encoded (and uncompressed) data is produced while the samples
+   * arrive, and only the last few samples are held back.
+   * Zero-suppressed data starts with the list of blocks, so it is produced
+   * only by Finish(); until then, the compressor keeps the samples of the
+   * blocks and the ones which may still join a block (a few more than
+   * `nearestneighbor`), so that its memory is proportional to the
+   * suppressed waveform rather than to the readout length.
+   */
+  class StreamingCompressor {
+
+  public:
+
+    /**
+     * @brief Constructor: sets compression type and parameters
+     * @param compress type of compression
+     * @param params parameters of the compression, as for raw::Compress()
+     * @throw cet::exception if the compression type is not supported, or if
+     *        neighbouring channels are requested
+     */
+    explicit StreamingCompressor
+      (raw::Compress_t compress, CodecParameters const& params = {});
+
+    /// Returns the type of compression
+    raw::Compress_t Compression() const { return fCompress; }
+
+    /// Adds n samples at the end of the waveform
+    void Push(short const* adc, std::size_t n);
+
+    /// Adds samples at the end of the waveform
+    void Push(std::vector<short> const& adc) { Push(adc.data(), adc.size()); }
+
+    /**
+     * @brief Moves the compressed data produced so far at the end of out
+     * @param out where the data is appended
+     * @return the number of words appended
+     *
+     * The data taken is final and it is not produced again.
+     */
+    std::size_t TakeOutput(std::vector<short>& out);
+
+    /**
+     * @brief Completes the compression of the waveform
+     * @param out where the rest of the compressed data is appended
+     * @return the number of words appended
+     * @throw cet::exception if the waveform is too long for its format
+     *
+     * The compressor is then reset for a new waveform.
+     */
+    std::size_t Finish(std::vector<short>& out);
+
+    /// Completes the compression and returns the data not taken yet
+    std::vector<short> Finish()
+      { std::vector<short> out; Finish(out); return out; }
+
+    /// Returns the number of samples pushed so far
+    std::size_t NTicks() const { return fNTicks; }
+
+    /// Returns the number of samples currently held by the compressor
+    std::size_t NBuffered() const { return fBuffer.size(); }
+
+  private:
+
+    raw::Compress_t fCompress; ///< type of compression
+    unsigned int fThreshold;   ///< zero suppression threshold
+    int  fPedestal;            ///< pedestal for zero suppression
+    int  fNearestNeighbor;     ///< samples kept around each block
+    bool fStickyCodes;         ///< whether to ignore ADC sticky codes
+    bool fNeighborhood;        ///< whether blocks are padded with neighbours
+
+    std::size_t fNTicks = 0;   ///< samples pushed so far
+    std::size_t fNext = 0;     ///< next tick to be processed
+    std::vector<short> fBuffer; ///< samples still needed
+    std::size_t fBufferStart = 0; ///< tick of the first sample in fBuffer
+    std::vector<short> fOutput; ///< compressed data not taken yet
+
+    // zero suppression state
+    std::vector<int>   fBlockBegin; ///< first tick of each block
+    std::vector<int>   fBlockSize;  ///< number of ticks in each block
+    std::vector<short> fData;       ///< samples of all the blocks
+    bool fInBlock = false;          ///< whether the last block is still open
+    int  fEndOfBlockCheck = 0;      ///< samples added after the block
+
+    // Huffman encoding state
+    unsigned int fWord = 0x8000U;   ///< word being filled
+    unsigned int fFreeBit = 15U;    ///< the next code ends below this bit
+
+    /// Returns the sample at the specified tick, which must be buffered
+    short sample(std::size_t tick) const
+      { return fBuffer[tick - fBufferStart]; }
+
+    /// Returns whether the sample at tick is above the threshold
+    bool overThreshold(std::size_t tick) const;
+
+    /// Processes all the ticks which have enough look-ahead
+    /// (or all of them, if finishing)
+    void process(bool finishing);
+
+    /// Zero suppression of a tick (simple blocks)
+    void suppressTick(std::size_t tick);
+
+    /// Zero suppression of a tick (blocks with neighbourhood)
+    void suppressNeighborhoodTick(std::size_t tick);
+
+    /// Adds the next n samples to the last block
+    void extendBlock(int n);
+
+    /// Huffman-encodes the sample at tick; returns the last tick encoded
+    std::size_t encodeTick(std::size_t tick);
+
+    /// Returns the first tick still needed in the buffer
+    std::size_t firstNeeded() const;
+
+    /// Removes from the buffer the samples not needed any more
+    void trimBuffer();
+
+    /// Prepares for a new waveform
+    void reset();
+
+  }; // class StreamingCompressor
+
+} // namespace raw
+
+
+#endif // RAWDATA_STREAMINGCOMPRESSOR_H
@@ -0,0 +1,80 @@
+/**
+ * @file    WorkerPool.cxx
+ * @brief   Threads shared by the compression functions which run in parallel
+ * @see     WorkerPool.h
+ */
+
+#include "lardataobj/RawData/WorkerPool.h"
+
+// C/C++ standard libraries
+#include <algorithm> // std::remove_if()
+
+
+namespace raw {
+
+  namespace details {
+
+    //--------------------------------------------------------------------
+    WorkerPool& WorkerPool::Instance()
+    {
+      static WorkerPool pool;
+      return pool;
+    } // WorkerPool::Instance()
+
+
+    //--------------------------------------------------------------------
+    WorkerPool::~WorkerPool()
+    {
+      {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fStop = true;
+      }
+      fWakeUp.notify_all();
+      for(std::thread& thread: fThreads) thread.join();
+    } // WorkerPool::~WorkerPool()
+
+
+    //--------------------------------------------------------------------
+    void WorkerPool::Run(unsigned int nHelpers, std::function<void()> const& work)
+    {
+      unsigned int pending = nHelpers;
+      {
+        std::lock_guard<std::mutex> lock(fMutex);
+        while(fThreads.size() < nHelpers)
+          fThreads.emplace_back([this](){ workerLoop(); });
+        for(unsigned int i = 0; i < nHelpers; ++i)
+          fJobs.push_back({ &work, &pending });
+      }
+      fWakeUp.notify_all();
+
+      work();
+
+      // the copies not started yet would find nothing left to do
+      std::unique_lock<std::mutex> lock(fMutex);
+      auto const iFirstOwn = std::remove_if(fJobs.begin(), fJobs.end(),
+        [&pending](Job const& job){ return job.pending == &pending; });
+      pending -= fJobs.end() - iFirstOwn;
+      fJobs.erase(iFirstOwn, fJobs.end());
+      fDone.wait(lock, [&pending](){ return pending == 0; });
+    } // WorkerPool::Run()
+
+
+    //--------------------------------------------------------------------
+    void WorkerPool::workerLoop()
+    {
+      std::unique_lock<std::mutex> lock(fMutex);
+      while(true){
+        fWakeUp.wait(lock, [this](){ return fStop || !fJobs.empty(); });
+        if(fJobs.empty()) return; // stopping
+        Job const job = fJobs.front();
+        fJobs.pop_front();
+        lock.unlock();
+        (*job.work)();
+        lock.lock();
+        if(--*job.pending == 0) fDone.notify_all();
+      } // while
+    } // WorkerPool::workerLoop()
+
+  } // namespace details
+
+} // namespace raw
@@ -0,0 +1,77 @@
+/**
+ * @file    WorkerPool.h
+ * @brief   Threads shared by the compression functions which run in parallel
+ * @see     WorkerPool.cxx BatchCompression.h raw.h
+ *
+ * This is an implementation detail of the library, not meant for the users.
+ */
+
+#ifndef RAWDATA_WORKERPOOL_H
+#define RAWDATA_WORKERPOOL_H
+
+// C/C++ standard libraries
+#include <condition_variable>
+#include <deque>
+#include <functional> // std::function
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace raw {
+
+  namespace details {
+
+    /**
+     * @brief Threads kept between calls, to help the callers with their work
+     *
+     * A caller hands its work to some of the threads and does it itself too;
+     * the threads which get to it after all is done return at once. The pool
+     * is shared by all the callers, which can use it at the same time, and it
+     * grows to the largest number of threads requested. The threads are
+     * stopped at the end of the program.
+     */
+    class WorkerPool {
+
+    public:
+      /// Returns the pool
+      static WorkerPool& Instance();
+
+      ~WorkerPool();
+
+      /**
+       * @brief Runs work in the calling thread and in up to nHelpers workers
+       * @param nHelpers number of workers to hand work to
+       * @param work the callable object to run (must not throw)
+       *
+       * The call returns when all the copies of work are done. Workers which
+       * have not started it by the time the calling thread is done don't.
+       */
+      void Run(unsigned int nHelpers, std::function<void()> const& work);
+
+    private:
+      /// A copy of work for a worker, and the number of pending copies
+      struct Job {
+        std::function<void()> const* work;
+        unsigned int*                pending;
+      }; // struct Job
+
+      std::mutex fMutex; ///< protects all the following data
+      std::condition_variable fWakeUp; ///< workers wait for jobs with this
+      std::condition_variable fDone;   ///< callers wait for their jobs with this
+      std::deque<Job> fJobs; ///< jobs not started yet
+      std::vector<std::thread> fThreads; ///< the workers
+      bool fStop = false; ///< whether the workers should quit
+
+      WorkerPool() = default;
+
+      /// Loop of a worker: runs jobs until the pool is stopped
+      void workerLoop();
+
+    }; // class WorkerPool
+
+  } // namespace details
+
+} // namespace raw
+
+#endif // RAWDATA_WORKERPOOL_H
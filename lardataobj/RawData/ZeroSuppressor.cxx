@@ -0,0 +1,546 @@
+/**
+ * @file    ZeroSuppressor.cxx
+ * @brief   Zero suppression with reusable work space
+ * @see     ZeroSuppressor.h raw.h
+ */
+
+#include "lardataobj/RawData/ZeroSuppressor.h"
+#include "lardataobj/RawData/raw.h" // raw::ADCStickyCodeCheck()
+
+#include "cetlib_except/exception.h"
+
+// C/C++ standard libraries
+#include <algorithm> // std::min(), std::max(), std::copy_n(), std::fill_n()
+#include <cstdlib> // std::abs()
+#include <limits>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#  include <immintrin.h>
+#endif
+
+
+namespace {
+
+  /// Returns whether bit i of mask is set
+  inline bool testBit(std::uint64_t const* mask, int i)
+    { return (mask[i >> 6] >> (i & 63)) & 1U; }
+
+  /// Returns the first tick from i on with its bit set, or n if none
+  int nextSet(std::uint64_t const* mask, int i, int n)
+  {
+    if(i >= n) return n;
+    int word = i >> 6;
+    std::uint64_t bits = mask[word] & (~std::uint64_t(0) << (i & 63));
+    int const nWords = (n + 63) >> 6;
+    while(bits == 0U){
+      if(++word >= nWords) return n;
+      bits = mask[word];
+    }
+    return std::min((word << 6) + __builtin_ctzll(bits), n);
+  } // nextSet()
+
+  /// Returns the first tick from i on with its bit not set, or n if none
+  int nextClear(std::uint64_t const* mask, int i, int n)
+  {
+    if(i >= n) return n;
+    int word = i >> 6;
+    std::uint64_t bits = ~mask[word] & (~std::uint64_t(0) << (i & 63));
+    int const nWords = (n + 63) >> 6;
+    while(bits == 0U){
+      if(++word >= nWords) return n;
+      bits = ~mask[word];
+    }
+    return std::min((word << 6) + __builtin_ctzll(bits), n);
+  } // nextClear()
+
+} // local namespace
+
+
+namespace raw {
+
+  //----------------------------------------------------------
+  // The vectorized comparisons are equivalent to
+  // ADCStickyCodeCheck(adc, pedestal, sticky) > threshold, that is
+  // adc > pedestal + threshold || adc < pedestal - threshold, with the
+  // exception of sticky codes within 64 counts from the pedestal.
+  // The limits are clamped into the range of short, which does not change
+  // the result; pedestals very close to that range are left to the scalar
+  // code, as well as the samples at the end of the waveform.
+  void AddOverThresholdMask(short const*   adc,
+                            std::size_t    nTicks,
+                            int            pedestal,
+                            unsigned int   zerothreshold,
+                            bool           fADCStickyCodeFeature,
+                            std::uint64_t* mask,
+                            bool           vectorized /* = true */)
+  {
+    const int zerothresholdsigned = zerothreshold;
+
+    std::size_t i = 0;
+
+#if defined(__AVX2__) || defined(__SSE2__)
+    constexpr int maxShort = std::numeric_limits<short>::max();
+    constexpr int minShort = std::numeric_limits<short>::min();
+    if(vectorized && zerothresholdsigned >= 0 && std::abs(pedestal) < maxShort - 64){
+      short const hi = std::min(pedestal + zerothresholdsigned, maxShort);
+      short const lo = std::max(pedestal - zerothresholdsigned, minShort);
+      // sticky codes only matter when the threshold is within 64 counts
+      bool const sticky = fADCStickyCodeFeature && (zerothresholdsigned < 63);
+      short const nearHi = pedestal + 64, nearLo = pedestal - 64;
+      short const lsbMask = onemask;
+
+#  if defined(__AVX2__)
+      __m256i const vhi = _mm256_set1_epi16(hi), vlo = _mm256_set1_epi16(lo);
+      __m256i const vnearHi = _mm256_set1_epi16(nearHi);
+      __m256i const vnearLo = _mm256_set1_epi16(nearLo);
+      __m256i const vlsbMask = _mm256_set1_epi16(lsbMask);
+      __m256i const vzero = _mm256_setzero_si256();
+      auto const over = [&](__m256i v)
+        {
+          __m256i res = _mm256_or_si256
+            (_mm256_cmpgt_epi16(v, vhi), _mm256_cmpgt_epi16(vlo, v));
+          if(sticky){
+            __m256i const lsbs = _mm256_and_si256(v, vlsbMask);
+            __m256i const stuck = _mm256_and_si256(
+              _mm256_or_si256
+                (_mm256_cmpeq_epi16(lsbs, vzero), _mm256_cmpeq_epi16(lsbs, vlsbMask)),
+              _mm256_and_si256
+                (_mm256_cmpgt_epi16(v, vnearLo), _mm256_cmpgt_epi16(vnearHi, v))
+              );
+            res = _mm256_andnot_si256(stuck, res);
+          }
+          return res;
+        };
+      for(; i + 32 <= nTicks; i += 32){
+        __m256i const c0 = over(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(adc + i)));
+        __m256i const c1 = over(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(adc + i + 16)));
+        // packing works within 128-bit lanes: restore the order of the samples
+        __m256i const packed
+          = _mm256_permute4x64_epi64(_mm256_packs_epi16(c0, c1), 0xD8);
+        std::uint32_t const bits = _mm256_movemask_epi8(packed);
+        mask[i >> 6] |= std::uint64_t(bits) << (i & 63);
+      } // for
+#  else // SSE2
+      __m128i const vhi = _mm_set1_epi16(hi), vlo = _mm_set1_epi16(lo);
+      __m128i const vnearHi = _mm_set1_epi16(nearHi);
+      __m128i const vnearLo = _mm_set1_epi16(nearLo);
+      __m128i const vlsbMask = _mm_set1_epi16(lsbMask);
+      __m128i const vzero = _mm_setzero_si128();
+      auto const over = [&](__m128i v)
+        {
+          __m128i res
+            = _mm_or_si128(_mm_cmpgt_epi16(v, vhi), _mm_cmplt_epi16(v, vlo));
+          if(sticky){
+            __m128i const lsbs = _mm_and_si128(v, vlsbMask);
+            __m128i const stuck = _mm_and_si128(
+              _mm_or_si128
+                (_mm_cmpeq_epi16(lsbs, vzero), _mm_cmpeq_epi16(lsbs, vlsbMask)),
+              _mm_and_si128
+                (_mm_cmpgt_epi16(v, vnearLo), _mm_cmplt_epi16(v, vnearHi))
+              );
+            res = _mm_andnot_si128(stuck, res);
+          }
+          return res;
+        };
+      for(; i + 16 <= nTicks; i += 16){
+        __m128i const c0 = over(_mm_loadu_si128(reinterpret_cast<__m128i const*>(adc + i)));
+        __m128i const c1 = over(_mm_loadu_si128(reinterpret_cast<__m128i const*>(adc + i + 8)));
+        std::uint32_t const bits = _mm_movemask_epi8(_mm_packs_epi16(c0, c1));
+        mask[i >> 6] |= std::uint64_t(bits) << (i & 63);
+      } // for
+#  endif // AVX2 / SSE2
+    } // if vectorizable
+#else
+    (void) vectorized; // only the scalar code is available
+#endif // vector instructions
+
+    for(; i < nTicks; ++i){
+      if(ADCStickyCodeCheck(adc[i], pedestal, fADCStickyCodeFeature) > zerothresholdsigned)
+        mask[i >> 6] |= std::uint64_t(1) << (i & 63);
+    } // for
+
+  } // AddOverThresholdMask()
+
+
+  //----------------------------------------------------------
+  void ZeroSuppressor::prepare(std::size_t nTicks)
+  {
+    // vectors are only grown, and never shrunk
+    if(fData.size() < nTicks) fData.resize(nTicks);
+    std::size_t const maxblocks = nTicks/2 + 1;
+    if(fBlockBegin.size() < maxblocks){
+      fBlockBegin.resize(maxblocks);
+      fBlockSize.resize(maxblocks);
+    }
+    std::size_t const nWords = (nTicks + 63) / 64;
+    if(fMask.size() < nWords){
+      fMask.resize(nWords);
+      fEndMask.resize(nWords);
+    }
+    std::fill_n(fMask.begin(), nWords, 0U);
+    std::fill_n(fEndMask.begin(), nWords, 0U);
+  } // ZeroSuppressor::prepare()
+
+
+  //----------------------------------------------------------
+  void PackZeroSuppressed(std::vector<short>& adc,
+                          std::size_t         adcsize,
+                          int const*          blockBegin,
+                          int const*          blockSize,
+                          int                 nblocks,
+                          short const*        data,
+                          std::size_t         datasize,
+                          std::size_t         maxShortTicks /* = ZeroSuppressionMaxShortTicks */)
+  {
+    if(adcsize <= std::min(maxShortTicks, ZeroSuppressionMaxShortTicks)){
+      adc.resize(2+nblocks+nblocks+datasize);
+
+      adc[0] = adcsize; //fill first entry in adc with length of uncompressed vector
+      adc[1] = nblocks;
+      std::copy_n(blockBegin, nblocks, adc.begin() + 2);
+      std::copy_n(blockSize, nblocks, adc.begin() + 2 + nblocks);
+      std::copy_n(data, datasize, adc.begin() + 2 + 2*nblocks);
+      return;
+    }
+
+    if(adcsize > ZeroSuppressionMaxLongTicks){
+      throw cet::exception("raw")
+        << "raw::ZeroSuppressor can't store waveforms with " << adcsize
+        << " ticks (at most " << ZeroSuppressionMaxLongTicks << ")\n";
+    }
+
+    adc.resize(6+4*nblocks+datasize);
+
+    auto out = adc.begin();
+    auto const write = [&out](int value)
+      { *out++ = value & 0x3fff; *out++ = value >> 14; };
+    *out++ = ZeroSuppressionLongMarker;
+    *out++ = ZeroSuppressionLongVersion;
+    write(adcsize);
+    write(nblocks);
+    for(int i = 0; i < nblocks; ++i) write(blockBegin[i]);
+    for(int i = 0; i < nblocks; ++i) write(blockSize[i]);
+    std::copy_n(data, datasize, out);
+
+  } // PackZeroSuppressed()
+
+
+  //----------------------------------------------------------
+  void ZeroSuppressedForHuffman(std::vector<short>& adc)
+  {
+    if(adc.empty() || (adc[0] == ZeroSuppressionLongMarker)) return;
+    std::size_t const adcsize = adc[0];
+    if(adcsize <= ZeroHuffmanMaxShortTicks) return;
+
+    int const nblocks = adc[1];
+    std::vector<int> const blockBegin(adc.begin() + 2, adc.begin() + 2 + nblocks);
+    std::vector<int> const blockSize
+      (adc.begin() + 2 + nblocks, adc.begin() + 2 + 2*nblocks);
+    std::vector<short> const data(adc.begin() + 2 + 2*nblocks, adc.end());
+    PackZeroSuppressed(adc, adcsize, blockBegin.data(), blockSize.data(),
+      nblocks, data.data(), data.size(), ZeroHuffmanMaxShortTicks);
+  } // ZeroSuppressedForHuffman()
+
+
+  //----------------------------------------------------------
+  void ZeroSuppressor::pack
+    (std::vector<short>& adc, int adcsize, int nblocks, int datasize) const
+  {
+    PackZeroSuppressed(adc, adcsize, fBlockBegin.data(), fBlockSize.data(),
+      nblocks, fData.data(), datasize);
+  } // ZeroSuppressor::pack()
+
+
+  //----------------------------------------------------------
+  // blocks are runs of samples above threshold, plus the first sample
+  // below threshold after each of them
+  void ZeroSuppressor::Suppress(std::vector<short>& adc,
+                                unsigned int        zerothreshold)
+  {
+    const int adcsize = adc.size();
+
+    prepare(adcsize);
+    std::uint64_t const* mask = fMask.data();
+    AddOverThresholdMask
+      (adc.data(), adcsize, 0, zerothreshold, false, fMask.data(), fVectorized);
+
+    int nblocks = 0;
+    int datasize = 0;
+
+    int i = 0;
+    while((i = nextSet(mask, i, adcsize)) < adcsize){
+      const int end = std::min(nextClear(mask, i, adcsize) + 1, adcsize);
+      fBlockBegin[nblocks] = i;
+      fBlockSize[nblocks] = end - i;
+      std::copy(adc.begin() + i, adc.begin() + end, fData.begin() + datasize);
+      datasize += end - i;
+      ++nblocks;
+      i = end;
+    } // while
+
+    pack(adc, adcsize, nblocks, datasize);
+
+  } // ZeroSuppressor::Suppress(threshold)
+
+
+  //----------------------------------------------------------
+  // Blocks start nearestneighbor ticks before a sample above threshold, and
+  // are merged with the previous block if that is close enough; a block
+  // ends nearestneighbor ticks after the last sample above threshold,
+  // as soon as the next two samples are not marked in endMask.
+  // The samples are collected while the blocks are found: a block always
+  // covers the ticks from its beginning to its current size, so the samples
+  // to be added are always the ones right after the current end of the block.
+  void ZeroSuppressor::suppressNeighborhood(short const*         adc,
+                                            int                  adcsize,
+                                            int                  nearestneighbor,
+                                            std::uint64_t const* endMask,
+                                            std::vector<short>&  suppressed)
+  {
+    std::uint64_t const* mask = fMask.data();
+    int*   const blockbegin = fBlockBegin.data();
+    int*   const blocksize  = fBlockSize.data();
+    short* const data       = fData.data();
+
+    int nblocks = 0;
+    int datasize = 0;
+    bool inblock = false;
+    int endofblockcheck = 0;
+
+    // adds the next n samples to the current block
+    auto const extendBlock = [&](int n)
+      {
+        std::copy_n(adc + blockbegin[nblocks] + blocksize[nblocks], n,
+          data + datasize);
+        blocksize[nblocks] += n;
+        datasize += n;
+      };
+
+    int i = 0;
+    while(i < adcsize){
+
+      if(!inblock){
+        i = nextSet(mask, i, adcsize);
+        if(i >= adcsize) break;
+
+        if(nblocks > 0
+          && i - nearestneighbor <= blockbegin[nblocks-1] + blocksize[nblocks-1] + 1)
+        {
+          --nblocks; // merge with the previous block
+        }
+        else{
+          blockbegin[nblocks] = std::max(i - nearestneighbor, 0);
+          blocksize[nblocks] = 0;
+        }
+        extendBlock(i - blockbegin[nblocks] + 1 - blocksize[nblocks]);
+        inblock = true;
+        ++i;
+      }
+      else if(testBit(mask, i)){
+        // the whole run of samples above threshold
+        const int end = nextClear(mask, i, adcsize);
+        extendBlock(end - i);
+        endofblockcheck = 0;
+        i = end;
+      }
+      else if(endofblockcheck < nearestneighbor){
+        // samples after the block, up to nearestneighbor of them
+        const int end = std::min
+          (nextSet(mask, i, adcsize), i + nearestneighbor - endofblockcheck);
+        extendBlock(end - i);
+        endofblockcheck += end - i;
+        i = end;
+      }
+      else{
+        //block has ended, unless the end of adc vector is near
+        if(i+2 < adcsize && !testBit(endMask, i+1) && !testBit(endMask, i+2)){
+          endofblockcheck = 0;
+          inblock = false;
+          ++nblocks;
+        }
+        ++i;
+      }
+    } // while
+
+    if(inblock) ++nblocks; // we reached the end of the adc vector with the block still going
+
+    pack(suppressed, adcsize, nblocks, datasize);
+
+  } // ZeroSuppressor::suppressNeighborhood()
+
+
+  //----------------------------------------------------------
+  void ZeroSuppressor::Suppress(std::vector<short>& adc,
+                                unsigned int        zerothreshold,
+                                int                 nearestneighbor)
+  {
+    prepare(adc.size());
+    AddOverThresholdMask
+      (adc.data(), adc.size(), 0, zerothreshold, false, fMask.data(), fVectorized);
+    suppressNeighborhood
+      (adc.data(), adc.size(), nearestneighbor, fMask.data(), adc);
+  } // ZeroSuppressor::Suppress(threshold, neighbor)
+
+
+  //----------------------------------------------------------
+  void ZeroSuppressor::Suppress(std::vector<short>& adc,
+                                unsigned int        zerothreshold,
+                                int                 pedestal,
+                                int                 nearestneighbor,
+                                bool                fADCStickyCodeFeature)
+  {
+    prepare(adc.size());
+    AddOverThresholdMask(adc.data(), adc.size(),
+      pedestal, zerothreshold, fADCStickyCodeFeature, fMask.data(), fVectorized);
+    suppressNeighborhood
+      (adc.data(), adc.size(), nearestneighbor, fMask.data(), adc);
+  } // ZeroSuppressor::Suppress(threshold, pedestal, neighbor)
+
+
+  //----------------------------------------------------------
+  // blocks are driven by the samples above threshold in any of the
+  // neighbouring channels, while only this channel is checked at the end
+  // of a block
+  void ZeroSuppressor::Suppress(Neighbors_t const&  adcvec_neighbors,
+                                std::vector<short>& adc,
+                                unsigned int        zerothreshold,
+                                int                 nearestneighbor)
+  {
+    prepare(adc.size());
+    for(std::vector<short> const& adcvec_current: adcvec_neighbors){
+      AddOverThresholdMask(adcvec_current.data(), adc.size(),
+        0, zerothreshold, false, fMask.data(), fVectorized);
+    }
+    AddOverThresholdMask(adc.data(), adc.size(),
+      0, zerothreshold, false, fEndMask.data(), fVectorized);
+    suppressNeighborhood
+      (adc.data(), adc.size(), nearestneighbor, fEndMask.data(), adc);
+  } // ZeroSuppressor::Suppress(neighbors, threshold, neighbor)
+
+
+  //----------------------------------------------------------
+  // the sticky code check is applied only to this channel
+  void ZeroSuppressor::Suppress(Neighbors_t const&  adcvec_neighbors,
+                                std::vector<short>& adc,
+                                unsigned int        zerothreshold,
+                                int                 pedestal,
+                                int                 nearestneighbor,
+                                bool                fADCStickyCodeFeature)
+  {
+    prepare(adc.size());
+    AddOverThresholdMask(adc.data(), adc.size(),
+      pedestal, zerothreshold, fADCStickyCodeFeature, fEndMask.data(), fVectorized);
+    std::copy_n(fEndMask.begin(), (adc.size() + 63) / 64, fMask.begin());
+    for(std::vector<short> const& adcvec_current: adcvec_neighbors){
+      AddOverThresholdMask(adcvec_current.data(), adc.size(),
+        pedestal, zerothreshold, false, fMask.data(), fVectorized);
+    }
+    suppressNeighborhood
+      (adc.data(), adc.size(), nearestneighbor, fEndMask.data(), adc);
+  } // ZeroSuppressor::Suppress(neighbors, threshold, pedestal, neighbor)
+
+
+  //----------------------------------------------------------
+  // The union of the masks of the channels in each window is computed with
+  // the van Herk/Gil-Werman algorithm: channels are split in groups as large
+  // as the window, and the running unions from the start and to the end of
+  // each group are computed. Each window spans at most two groups, and its
+  // union is the one from its first channel to the end of its group, plus
+  // the one from the start of the next group to its last channel.
+  void ZeroSuppressor::suppressPlane(short const*                     adcs,
+                                     std::size_t                      nChannels,
+                                     std::size_t                      nTicks,
+                                     unsigned int                     zerothreshold,
+                                     int                              pedestal,
+                                     int                              neighboringchannels,
+                                     int                              nearestneighbor,
+                                     bool                             fADCStickyCodeFeature,
+                                     std::vector<std::vector<short>>& suppressed)
+  {
+    suppressed.resize(nChannels);
+    if(nChannels == 0) return;
+
+    std::size_t const nWords = (nTicks + 63) / 64;
+    std::size_t const halfWindow = std::max(neighboringchannels, 0);
+    std::size_t const window = 2 * halfWindow + 1;
+    std::size_t const nPadded = nChannels + 2 * halfWindow;
+
+    // masks of all channels; channel c is at position c + halfWindow
+    fChannelMasks.assign(nPadded * nWords, 0U);
+    for(std::size_t c = 0; c < nChannels; ++c){
+      AddOverThresholdMask(adcs + c * nTicks, nTicks, pedestal, zerothreshold,
+        false, fChannelMasks.data() + (c + halfWindow) * nWords, fVectorized);
+    }
+
+    fGroupHead.resize(nPadded * nWords);
+    fGroupTail.resize(nPadded * nWords);
+    for(std::size_t p = 0; p < nPadded; ++p){
+      std::uint64_t const* mask = fChannelMasks.data() + p * nWords;
+      std::uint64_t* head = fGroupHead.data() + p * nWords;
+      if(p % window == 0) std::copy_n(mask, nWords, head);
+      else{
+        std::uint64_t const* prev = head - nWords;
+        for(std::size_t w = 0; w < nWords; ++w) head[w] = prev[w] | mask[w];
+      }
+    } // for head
+    for(std::size_t p = nPadded; p-- > 0;){
+      std::uint64_t const* mask = fChannelMasks.data() + p * nWords;
+      std::uint64_t* tail = fGroupTail.data() + p * nWords;
+      if((p % window == window - 1) || (p == nPadded - 1))
+        std::copy_n(mask, nWords, tail);
+      else{
+        std::uint64_t const* next = tail + nWords;
+        for(std::size_t w = 0; w < nWords; ++w) tail[w] = next[w] | mask[w];
+      }
+    } // for tail
+
+    for(std::size_t c = 0; c < nChannels; ++c){
+      prepare(nTicks);
+
+      // window of channel c spans positions from c to c + window - 1
+      std::uint64_t const* tail = fGroupTail.data() + c * nWords;
+      std::uint64_t const* head = fGroupHead.data() + (c + window - 1) * nWords;
+      for(std::size_t w = 0; w < nWords; ++w) fMask[w] = tail[w] | head[w];
+
+      short const* adc = adcs + c * nTicks;
+      AddOverThresholdMask(adc, nTicks, pedestal, zerothreshold,
+        fADCStickyCodeFeature, fEndMask.data(), fVectorized);
+
+      suppressNeighborhood
+        (adc, nTicks, nearestneighbor, fEndMask.data(), suppressed[c]);
+    } // for channels
+
+  } // ZeroSuppressor::suppressPlane()
+
+
+  //----------------------------------------------------------
+  void ZeroSuppressor::SuppressPlane(short const*                     adcs,
+                                     std::size_t                      nChannels,
+                                     std::size_t                      nTicks,
+                                     unsigned int                     zerothreshold,
+                                     int                              neighboringchannels,
+                                     int                              nearestneighbor,
+                                     std::vector<std::vector<short>>& suppressed)
+  {
+    suppressPlane(adcs, nChannels, nTicks, zerothreshold, 0,
+      neighboringchannels, nearestneighbor, false, suppressed);
+  } // ZeroSuppressor::SuppressPlane()
+
+
+  //----------------------------------------------------------
+  void ZeroSuppressor::SuppressPlane(short const*                     adcs,
+                                     std::size_t                      nChannels,
+                                     std::size_t                      nTicks,
+                                     unsigned int                     zerothreshold,
+                                     int                              pedestal,
+                                     int                              neighboringchannels,
+                                     int                              nearestneighbor,
+                                     std::vector<std::vector<short>>& suppressed,
+                                     bool                             fADCStickyCodeFeature)
+  {
+    suppressPlane(adcs, nChannels, nTicks, zerothreshold, pedestal,
+      neighboringchannels, nearestneighbor, fADCStickyCodeFeature, suppressed);
+  } // ZeroSuppressor::SuppressPlane(pedestal)
+
+
+} // namespace raw
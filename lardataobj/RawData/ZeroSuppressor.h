@@ -0,0 +1,315 @@
+/**
+ * @file    ZeroSuppressor.h
+ * @brief   Zero suppression with reusable work space
+ * @see     ZeroSuppressor.cxx raw.h
+ *
+ * The zero suppression free functions declared in raw.h are wrappers
+ * around a (thread-local) raw::ZeroSuppressor object.
+ */
+
+#ifndef RAWDATA_ZEROSUPPRESSOR_H
+#define RAWDATA_ZEROSUPPRESSOR_H
+
+// LArSoft libraries
+#include "lardataobj/RawData/raw.h" // raw::ZeroSuppressionMaxShortTicks
+
+// C/C++ standard libraries
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <vector>
+
+// Boost libraries
+#include <boost/circular_buffer.hpp>
+
+
+namespace raw {
+
+  /**
+   * @brief Marks the samples farther from the pedestal than a threshold
+   * @param adc pointer to the first sample of the waveform
+   * @param nTicks number of samples in the waveform
+   * @param pedestal pedestal level of the waveform
+   * @param zerothreshold samples farther than this from pedestal are marked
+   * @param fADCStickyCodeFeature whether to ignore ADC sticky codes
+   * @param mask bit mask to add the marked samples to
+   * @see raw::ADCStickyCodeCheck()
+   *
+   * Sample `i` is marked by setting bit `i % 64` of `mask[i / 64]` if
+   * `raw::ADCStickyCodeCheck(adc[i], pedestal, fADCStickyCodeFeature)` is
+   * larger than zerothreshold. The bits of samples not marked are left
+   * unchanged, so that the masks of many waveforms can be combined;
+   * mask must have room for at least `(nTicks + 63) / 64` words.
+   *
+   * The comparisons are vectorized with AVX2 or SSE2 instructions, depending
+   * on the compilation target, with a scalar fallback; if vectorized is
+   * `false`, the scalar code is used for all the samples.
+   */
+  void AddOverThresholdMask(short const*   adc,
+                            std::size_t    nTicks,
+                            int            pedestal,
+                            unsigned int   zerothreshold,
+                            bool           fADCStickyCodeFeature,
+                            std::uint64_t* mask,
+                            bool           vectorized = true);
+
+
+  /**
+   * @brief Writes zero-suppressed blocks with the zero suppression layout
+   * @param adc filled with the zero-suppressed waveform
+   * @param adcsize number of ticks of the uncompressed waveform
+   * @param blockBegin first tick of each block
+   * @param blockSize number of ticks of each block
+   * @param nblocks number of blocks
+   * @param data samples of all the blocks, one block after the other
+   * @param datasize number of samples in data
+   * @param maxShortTicks longest waveform written with the short layout
+   * @throw cet::exception if the waveform is too long for any layout
+   *
+   * The short layout is used for waveforms up to maxShortTicks ticks, the
+   * long one otherwise (see raw::ZeroSuppressionMaxShortTicks).
+   * The input buffers must not be part of adc.
+   */
+  void PackZeroSuppressed(std::vector<short>& adc,
+                          std::size_t         adcsize,
+                          int const*          blockBegin,
+                          int const*          blockSize,
+                          int                 nblocks,
+                          short const*        data,
+                          std::size_t         datasize,
+                          std::size_t         maxShortTicks
+                            = ZeroSuppressionMaxShortTicks);
+
+
+  /**
+   * @brief Rewrites zero-suppressed data with a layout fit for Huffman coding
+   * @param adc zero-suppressed data, in either layout
+   *
+   * Data with the short layout and more than raw::ZeroHuffmanMaxShortTicks
+   * ticks is rewritten with the long layout, since Huffman coding would not
+   * preserve its counts; other data is left unchanged.
+   */
+  void ZeroSuppressedForHuffman(std::vector<short>& adc);
+
+
+  /**
+   * @brief Zero-suppresses ADC waveforms, reusing its work space
+   *
+   * The zero suppression algorithms are the same as the ones of the
+   * raw::ZeroSuppression() functions, and so is the format of the result:
+   *
+   *     [ size, nblocks, begin[0], ..., begin[n-1], size[0], ..., size[n-1], data... ]
+   *
+   * for waveforms up to raw::ZeroSuppressionMaxShortTicks ticks, and the
+   * long layout with 28-bit counts for longer ones
+   * (see raw::ZeroSuppressionLongMarker).
+   *
+   * The samples above threshold are first marked in a bit mask
+   * (see raw::AddOverThresholdMask()); blocks are then found by skipping
+   * through the mask a whole run of marked or unmarked samples at a time,
+   * and their samples are collected at the same time.
+   * The temporary buffers needed for that are
+   * owned by this object and they are reused on the next call, so that a
+   * suppressor used on many channels allocates memory only when a waveform
+   * is longer than any of the previous ones.
+   *
+   * A ZeroSuppressor object is not thread-safe: each thread should use its
+   * own, for example:
+   *
+   *     thread_local raw::ZeroSuppressor suppressor;
+   *     suppressor.Suppress(adc, zerothreshold, pedestal, nearestneighbor);
+   *
+   */
+  class ZeroSuppressor {
+
+  public:
+
+    /// Type of the collection of neighbouring channel waveforms
+    using Neighbors_t = boost::circular_buffer<std::vector<short>>;
+
+    /// Returns whether the vectorized comparisons are used (the default)
+    bool Vectorized() const { return fVectorized; }
+
+    /// Sets whether to use the vectorized comparisons or the scalar ones
+    /// (see raw::AddOverThresholdMask()); the result is the same
+    void SetVectorized(bool vectorized) { fVectorized = vectorized; }
+
+    /**
+     * @brief Suppresses the samples not above threshold
+     * @param adc waveform; replaced by its zero-suppressed version
+     * @param zerothreshold samples with larger absolute value are kept
+     *
+     * Each block includes a sample below threshold after the last one
+     * above threshold.
+     */
+    void Suppress(std::vector<short>& adc, unsigned int zerothreshold);
+
+    /**
+     * @brief Suppresses the samples far from any sample above threshold
+     * @param adc waveform; replaced by its zero-suppressed version
+     * @param zerothreshold samples with larger absolute value are kept
+     * @param nearestneighbor number of samples kept around each block
+     *
+     * Blocks closer than nearestneighbor ticks are merged.
+     */
+    void Suppress(std::vector<short>& adc,
+                  unsigned int        zerothreshold,
+                  int                 nearestneighbor);
+
+    /**
+     * @brief Suppresses the samples far from any sample above threshold
+     * @param adc waveform; replaced by its zero-suppressed version
+     * @param zerothreshold samples farther from pedestal are kept
+     * @param pedestal pedestal level of the waveform
+     * @param nearestneighbor number of samples kept around each block
+     * @param fADCStickyCodeFeature whether to ignore ADC sticky codes
+     * @see raw::ADCStickyCodeCheck()
+     */
+    void Suppress(std::vector<short>& adc,
+                  unsigned int        zerothreshold,
+                  int                 pedestal,
+                  int                 nearestneighbor,
+                  bool                fADCStickyCodeFeature = false);
+
+    /**
+     * @brief Suppresses the samples where no neighbour is above threshold
+     * @param adcvec_neighbors waveforms of the neighbouring channels
+     * @param adc waveform; replaced by its zero-suppressed version
+     * @param zerothreshold samples with larger absolute value are kept
+     * @param nearestneighbor number of samples kept around each block
+     */
+    void Suppress(Neighbors_t const&  adcvec_neighbors,
+                  std::vector<short>& adc,
+                  unsigned int        zerothreshold,
+                  int                 nearestneighbor);
+
+    /**
+     * @brief Suppresses the samples where no neighbour is above threshold
+     * @param adcvec_neighbors waveforms of the neighbouring channels
+     * @param adc waveform; replaced by its zero-suppressed version
+     * @param zerothreshold samples farther from pedestal are kept
+     * @param pedestal pedestal level of all the waveforms
+     * @param nearestneighbor number of samples kept around each block
+     * @param fADCStickyCodeFeature whether to ignore ADC sticky codes
+     */
+    void Suppress(Neighbors_t const&  adcvec_neighbors,
+                  std::vector<short>& adc,
+                  unsigned int        zerothreshold,
+                  int                 pedestal,
+                  int                 nearestneighbor,
+                  bool                fADCStickyCodeFeature = false);
+
+    /**
+     * @brief Zero-suppresses all the channels of a plane
+     * @param adcs samples of all the channels, one channel after the other
+     * @param nChannels number of channels
+     * @param nTicks number of samples of each channel
+     * @param zerothreshold samples with larger absolute value are kept
+     * @param neighboringchannels number of neighbours on each side
+     * @param nearestneighbor number of samples kept around each block
+     * @param suppressed filled with the zero-suppressed channel waveforms
+     *
+     * The sample at tick `t` of channel `c` is `adcs[c * nTicks + t]`.
+     * The result for each channel is the same as the one of
+     * `Suppress(adcvec_neighbors, adc, zerothreshold, nearestneighbor)`
+     * with `adcvec_neighbors` containing the channels from
+     * `c - neighboringchannels` to `c + neighboringchannels` within the plane,
+     * channel `c` included.
+     *
+     * Which ticks have a neighbour above threshold is found with a sliding
+     * window over the channels, so that the cost per channel does not depend
+     * on the number of neighbours.
+     */
+    void SuppressPlane(short const*                     adcs,
+                       std::size_t                      nChannels,
+                       std::size_t                      nTicks,
+                       unsigned int                     zerothreshold,
+                       int                              neighboringchannels,
+                       int                              nearestneighbor,
+                       std::vector<std::vector<short>>& suppressed);
+
+    /**
+     * @brief Zero-suppresses all the channels of a plane
+     * @param adcs samples of all the channels, one channel after the other
+     * @param nChannels number of channels
+     * @param nTicks number of samples of each channel
+     * @param zerothreshold samples farther from pedestal are kept
+     * @param pedestal pedestal level of all the channels
+     * @param neighboringchannels number of neighbours on each side
+     * @param nearestneighbor number of samples kept around each block
+     * @param suppressed filled with the zero-suppressed channel waveforms
+     * @param fADCStickyCodeFeature whether to ignore ADC sticky codes
+     *
+     * Like the other SuppressPlane(), the result for each channel is the same
+     * as the one of the `Suppress(adcvec_neighbors, ...)` overload with
+     * pedestal.
+     */
+    void SuppressPlane(short const*                     adcs,
+                       std::size_t                      nChannels,
+                       std::size_t                      nTicks,
+                       unsigned int                     zerothreshold,
+                       int                              pedestal,
+                       int                              neighboringchannels,
+                       int                              nearestneighbor,
+                       std::vector<std::vector<short>>& suppressed,
+                       bool                             fADCStickyCodeFeature = false);
+
+  private:
+
+    bool fVectorized = true; ///< whether to use vectorized comparisons
+
+    std::vector<int>   fBlockBegin; ///< first tick of each block
+    std::vector<int>   fBlockSize;  ///< number of ticks in each block
+    std::vector<short> fData;       ///< samples of all the blocks
+    std::vector<std::uint64_t> fMask;    ///< samples opening or extending blocks
+    std::vector<std::uint64_t> fEndMask; ///< samples preventing a block end
+
+    /// Samples above threshold of each channel of a plane, with empty
+    /// channels on both sides
+    std::vector<std::uint64_t> fChannelMasks;
+    /// Union of channel masks from the start of each group of channels
+    std::vector<std::uint64_t> fGroupHead;
+    /// Union of channel masks up to the end of each group of channels
+    std::vector<std::uint64_t> fGroupTail;
+
+    /// Makes sure the work space can host a waveform of nTicks samples,
+    /// and clears the masks
+    void prepare(std::size_t nTicks);
+
+    /**
+     * @brief Block search with merging of close blocks
+     * @param adc pointer to the first sample of the waveform
+     * @param adcsize number of samples in the waveform
+     * @param nearestneighbor number of samples kept around each block
+     * @param endMask samples not allowing a block to end right before them
+     * @param suppressed filled with the zero-suppressed waveform
+     *
+     * The samples opening or extending blocks are marked in fMask.
+     * The input waveform may be the content of suppressed.
+     */
+    void suppressNeighborhood(short const*         adc,
+                              int                  adcsize,
+                              int                  nearestneighbor,
+                              std::uint64_t const* endMask,
+                              std::vector<short>&  suppressed);
+
+    /// Implementation of SuppressPlane()
+    void suppressPlane(short const*                     adcs,
+                       std::size_t                      nChannels,
+                       std::size_t                      nTicks,
+                       unsigned int                     zerothreshold,
+                       int                              pedestal,
+                       int                              neighboringchannels,
+                       int                              nearestneighbor,
+                       bool                             fADCStickyCodeFeature,
+                       std::vector<std::vector<short>>& suppressed);
+
+    /// Fills adc with the blocks collected in the work space
+    void pack
+      (std::vector<short>& adc, int adcsize, int nblocks, int datasize) const;
+
+  }; // class ZeroSuppressor
+
+} // namespace raw
+
+
+#endif // RAWDATA_ZEROSUPPRESSOR_H
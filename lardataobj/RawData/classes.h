@@ -19,3 +19,6 @@
 #include "lardataobj/RawData/TriggerData.h"
 #include "lardataobj/RawData/OpDetWaveform.h"
 #include "lardataobj/RawData/RDTimeStamp.h"
+#include "lardataobj/RawData/CompressedDigitBlock.h"
+#include "lardataobj/RawData/RawDigitBlock.h"
+#include "lardataobj/RawData/CompressedOpDetWaveform.h"
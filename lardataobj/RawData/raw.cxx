@@ -4,53 +4,937 @@
 /// modified by jti3@fnal.gov
 
 #include "lardataobj/RawData/raw.h"
+#include "lardataobj/RawData/ZeroSuppressor.h"
+#include "lardataobj/RawData/Codec.h"
+#include "lardataobj/RawData/RawDigit.h"
+#include "lardataobj/RawData/WorkerPool.h"
 
 #include <iostream>
+#include <algorithm> // std::copy_n(), std::fill(), std::count_if()
+#include <atomic>
 #include <bitset>
-#include <numeric> // std::adjacent_difference()
-#include <iterator> // std::back_inserter()
+#include <cmath> // std::lround()
+#include <cstdint> // std::uint64_t
+#include <cstdlib> // std::abs()
+#include <iterator> // std::size()
+#include <limits>
+#include <memory> // std::make_unique()
+#include <thread> // std::thread::hardware_concurrency()
+#include <utility> // std::move()
 
 #include "cetlib_except/exception.h"
 #include "messagefacility/MessageLogger/MessageLogger.h"
 
-namespace raw {
+#if defined(__AVX2__) || defined(__SSE2__)
+#  include <immintrin.h>
+#endif
+
+namespace {
+
+  /**
+   * @brief Lookup table for the decoding of Huffman-encoded words
+   *
+   * The table is indexed by the 15-bit payload of an encoded word (bit 15
+   * set, see raw::CompressHuffman()). Each entry packs:
+   * * bits  0- 5: number of ticks encoded in the word
+   * * bits  6- 9: number of codes in the word
+   * * bit     10: set for all non-empty payloads
+   * * bits 16-60: the codes, 3 bits each, first code in the lowest bits
+   *
+   * A code is the number of zeroes before the terminating bit (`1`),
+   * and it translates into an ADC delta `Delta[code]` repeated for
+   * `Ticks[code]` ticks. Codes longer than 7 zeroes are not produced by the
+   * encoder; they are decoded like the code with no zeroes, which is what the
+   * original bit-by-bit decoder did.
+   */
+  struct HuffmanDecodeTable {
+
+    static constexpr short        Delta[8] = { 0, 0, +1, -1, +2, -2, +3, -3 };
+    static constexpr unsigned int Ticks[8] = { 4, 1,  1,  1,  1,  1,  1,  1 };
+
+    std::vector<std::uint64_t> entries;
+
+    HuffmanDecodeTable(): entries(1U << 15, 0U)
+      {
+        for(unsigned int payload = 1; payload < entries.size(); ++payload){
+          std::uint64_t nTicks = 0, nCodes = 0, codes = 0;
+          unsigned int zerocnt = 0;
+          for(int b = 14; b >= 0; --b){
+            if(!(payload & (1U << b))){
+              ++zerocnt;
+              continue;
+            }
+            // the bit-by-bit decoder used to read the set bit after more
+            // than 7 zeroes again, as a code without zeroes
+            if(zerocnt >= 8) zerocnt = 0;
+            codes |= std::uint64_t(zerocnt) << (3 * nCodes);
+            nTicks += Ticks[zerocnt];
+            ++nCodes;
+            zerocnt = 0;
+          } // for bits
+          entries[payload] = nTicks | (nCodes << 6) | (1U << 10) | (codes << 16);
+        } // for payloads
+      } // HuffmanDecodeTable()
+
+    static unsigned int nTicks(std::uint64_t entry) { return entry & 0x3fU; }
+    static unsigned int nCodes(std::uint64_t entry) { return (entry >> 6) & 0xfU; }
+    static std::uint64_t codes(std::uint64_t entry) { return entry >> 16; }
+
+  }; // struct HuffmanDecodeTable
+
+  constexpr short        HuffmanDecodeTable::Delta[8];
+  constexpr unsigned int HuffmanDecodeTable::Ticks[8];
+
+  /// Returns the decoding table, built on first use (thread-safe)
+  HuffmanDecodeTable const& huffmanDecodeTable()
+  {
+    static HuffmanDecodeTable const table;
+    return table;
+  }
 
-  //----------------------------------------------------------
-  void Compress(std::vector<short> &adc,
-		raw::Compress_t     compress)
+  /**
+   * @brief Access to zero-suppressed data, in either of its layouts
+   * @see raw::ZeroSuppressionLongMarker
+   *
+   * Only the header of the data, up to the block sizes, is read.
+   */
+  class ZeroSuppressedLayout {
+
+  public:
+    explicit ZeroSuppressedLayout(short const* adc)
+      : fADC(adc)
+      , fLong(adc[0] == raw::ZeroSuppressionLongMarker)
+      {
+        if(fLong && (adc[1] != raw::ZeroSuppressionLongVersion)){
+          throw cet::exception("raw")
+            << "zero-suppressed data with unsupported layout version "
+            << adc[1] << "\n";
+        }
+        fNTicks = fLong? read(2): adc[0];
+        fNBlocks = fLong? read(4): adc[1];
+        fBegins = fLong? 6: 2;
+        fSizes = fBegins + fNBlocks * width();
+      }
+
+    /// Number of ticks of the uncompressed waveform
+    int NTicks() const { return fNTicks; }
+
+    /// Number of blocks of samples
+    int NBlocks() const { return fNBlocks; }
+
+    /// First tick of block i
+    int BlockBegin(int i) const { return value(fBegins + i * width()); }
+
+    /// Number of ticks in block i
+    int BlockSize(int i) const { return value(fSizes + i * width()); }
+
+    /// Index of the first sample of the first block
+    std::size_t DataStart() const { return fSizes + fNBlocks * width(); }
+
+    /// Index of the first block begin
+    std::size_t HeaderSize() const { return fBegins; }
+
+    /// Number of words storing each block begin and size
+    std::size_t ValueWidth() const { return width(); }
+
+    /// Number of words of the header of the long layout, before the blocks
+    static constexpr std::size_t LongHeaderSize = 6;
+
+    /// Value of a count of the long layout from its two 14-bit words
+    static int LongValue(short low, short high)
+      { return (int(high) << 14) | (low & 0x3fff); }
+
+  private:
+    short const* fADC;
+    bool fLong;
+    int fNTicks;
+    int fNBlocks;
+    std::size_t fBegins;
+    std::size_t fSizes;
+
+    std::size_t width() const { return fLong? 2: 1; }
+
+    int read(std::size_t pos) const
+      { return LongValue(fADC[pos], fADC[pos+1]); }
+
+    int value(std::size_t pos) const { return fLong? read(pos): fADC[pos]; }
+
+  }; // class ZeroSuppressedLayout
+
+
+  /// Returns the word for a value escaped from Huffman encoding: the actual
+  /// value with bit 15 unset, and bit 14 set if it is not positive
+  short HuffmanEscape(short value)
   {
-    if(compress == raw::kHuffman) CompressHuffman(adc);
-    else if(compress == raw::kZeroHuffman){
-      unsigned int zerothreshold = 5;
-      ZeroSuppression(adc,zerothreshold);
-      CompressHuffman(adc);
+    return (value > 0)
+      ? value: static_cast<short>(((-value) & 0xffff) | 0x4000);
+  }
+
+
+  /**
+   * @brief Huffman-encodes the differences between consecutive samples
+   * @param adc pointer to the first sample
+   * @param nTicks number of samples
+   * @param out where to write the encoded words
+   * @param writeEmpty whether to write the last word even if empty
+   * @return a pointer past the last word written
+   *
+   * The samples from `adc[1]` on are encoded, with at most one word each
+   * (see raw::CompressHuffman()); the first sample is not written.
+   * Codes are never split between words: when the code does not fit in the
+   * bits left in the current word, the word is written out and a new one is
+   * started.
+   */
+  short* EncodeHuffmanDifferences
+    (short const* adc, std::size_t nTicks, short* out, bool writeEmpty)
+  {
+    // length of the code (a `1` preceded by length-1 zeroes) for differences
+    // from -3 to +3; no change for 4 ticks is a special case with length 1
+    static constexpr unsigned int CodeLength[7] = { 8, 6, 4, 2, 3, 5, 7 };
+
+    unsigned int word = 0x8000U; // bit 15 set: Huffman-encoded word
+    unsigned int curb = 15U;     // the next code ends below this bit
+
+    for(std::size_t i = 1; i < nTicks; ++i){
+
+      // differences are computed as short, like the decoder will add them
+      short const diff = adc[i] - adc[i-1];
+      unsigned int const index = diff + 3;
+
+      if(index < 7U){
+        unsigned int length = CodeLength[index];
+        if(diff == 0 && i + 3 < nTicks
+          && adc[i+1] == adc[i] && adc[i+2] == adc[i] && adc[i+3] == adc[i])
+        {
+          length = 1U;
+          i += 3;
+        }
+        if(curb < length){
+          *out++ = static_cast<short>(word);
+          word = 0x8000U;
+          curb = 15U;
+        }
+        curb -= length;
+        word |= 1U << curb;
+      }
+      else{
+        // the difference is too large: write the actual value
+        if(curb != 15U) *out++ = static_cast<short>(word);
+        word = 0x8000U;
+        curb = 15U;
+        *out++ = HuffmanEscape(adc[i]);
+      }
+    }// end loop over ticks
+
+    //write out the last word
+    if(writeEmpty || (curb != 15U)) *out++ = static_cast<short>(word);
+
+    return out;
+  } // EncodeHuffmanDifferences()
+
+
+  /**
+   * @brief Sequential decoder of Huffman-encoded data
+   * @see raw::CompressHuffman(), raw::UncompressHuffman()
+   *
+   * The samples are decoded on demand, any number at a time, so that each
+   * part of a waveform can be written straight to its final destination.
+   * A copy of a decoder continues independently from the same point.
+   * No sample is produced past the end of the encoded data.
+   */
+  class HuffmanStreamDecoder {
+
+  public:
+    explicit HuffmanStreamDecoder(std::vector<short> const& adc)
+      : HuffmanStreamDecoder(adc, raw::HuffmanCheckpoint{ 0U, 0U, 0 })
+      {}
+
+    /// Constructor: decoding starts from the specified checkpoint
+    HuffmanStreamDecoder
+      (std::vector<short> const& adc, raw::HuffmanCheckpoint const& from)
+      : fTable(huffmanDecodeTable()), fADC(adc)
+      , fNextWord(from.word), fCurADC(from.adc)
+      {
+        //the first entry in adc is a data value by construction
+        if((fNextWord == 0) && !adc.empty()){
+          fCurADC = adc[0];
+          fRepeat = 1;
+          fNextWord = 1;
+        }
+      }
+
+    /// Decodes up to n samples into out, returns how many were decoded
+    std::size_t Read(short* out, std::size_t n);
+
+    /// Returns the next sample (0 past the end of the data)
+    short Next() { short value = 0; Read(&value, 1); return value; }
+
+    /// Skips the next n samples
+    void Skip(std::size_t n)
+      {
+        short buffer[64];
+        while(n > 0){
+          std::size_t const chunk = std::min(n, std::size(buffer));
+          if(Read(buffer, chunk) < chunk) break;
+          n -= chunk;
+        }
+      }
+
+  private:
+    HuffmanDecodeTable const& fTable;
+    std::vector<short> const& fADC;
+    std::size_t   fNextWord = 0; ///< index of the next word to be decoded
+    short         fCurADC   = 0; ///< value of the last decoded sample
+    unsigned int  fRepeat   = 0; ///< ticks still to be given fCurADC
+    std::uint64_t fCodes    = 0; ///< codes left in the current word
+    unsigned int  fNCodes   = 0; ///< number of codes left in the current word
+
+  }; // class HuffmanStreamDecoder
+
+
+  std::size_t HuffmanStreamDecoder::Read(short* out, std::size_t n)
+  {
+    // the state is worked on in local copies, which the compiler does not
+    // need to reload after each write to out
+    std::size_t   nextWord = fNextWord;
+    short         curADC   = fCurADC;
+    unsigned int  repeat   = fRepeat;
+    std::uint64_t codes    = fCodes;
+    unsigned int  nCodes   = fNCodes;
+
+    std::size_t const nWords = fADC.size();
+    std::size_t curu = 0;
+    while(curu < n){
+
+      if(repeat > 0){
+        // the last decoded value still covers some ticks
+        std::size_t const k = std::min<std::size_t>(repeat, n - curu);
+        std::fill_n(out + curu, k, curADC);
+        curu += k;
+        repeat -= k;
+        continue;
+      }
+
+      if(nCodes > 0){
+        // close to the end of the request or of the data: one code at a time
+        unsigned int const code = codes & 0x7U;
+        codes >>= 3;
+        --nCodes;
+        curADC += HuffmanDecodeTable::Delta[code];
+        repeat = HuffmanDecodeTable::Ticks[code];
+        continue;
+      }
+
+      if(nextWord >= nWords) break;
+
+      // loop over the entries in adc and uncompress them according to the
+      // encoding scheme above the CompressHuffman method
+      for(; nextWord < nWords && curu < n; ++nextWord){
+
+        unsigned int const word = static_cast<unsigned short>(fADC[nextWord]);
+
+        //check the 15 bit to see if this entry is a full data value or not
+        if( !(word & 0x8000U) ){
+          curADC = (word & 0x4000U)? short(-short(word & 0x3fffU)): fADC[nextWord];
+          out[curu++] = curADC;
+          continue;
+        }
+
+        std::uint64_t const entry = fTable.entries[word & 0x7fffU];
+        if(entry == 0U){
+          mf::LogWarning("raw.cxx") << "encoded entry has no set bits!!! "
+                                    << nextWord << " "
+                                    << std::bitset<16>(fADC[nextWord]).to_string< char,std::char_traits<char>,std::allocator<char> >();
+          continue;
+        }
+
+        codes = HuffmanDecodeTable::codes(entry);
+        nCodes = HuffmanDecodeTable::nCodes(entry);
+
+        // the fast path writes each code four ticks unconditionally and only
+        // advances by the number it actually encodes; the (up to three) ticks
+        // written past the word must be overwritten by the following words,
+        // which encode at least one tick each except for a final empty one
+        if((curu + HuffmanDecodeTable::nTicks(entry) + 3 > n)
+          || (nextWord + 5 > nWords))
+        {
+          ++nextWord;
+          break;
+        }
+
+        for(; nCodes > 0; --nCodes, codes >>= 3){
+          unsigned int const code = codes & 0x7U;
+          curADC += HuffmanDecodeTable::Delta[code];
+          out[curu]   = curADC;
+          out[curu+1] = curADC;
+          out[curu+2] = curADC;
+          out[curu+3] = curADC;
+          curu += HuffmanDecodeTable::Ticks[code];
+        }
+      }// end loop over entries in adc
+
+    } // while
+
+    fNextWord = nextWord;
+    fCurADC   = curADC;
+    fRepeat   = repeat;
+    fCodes    = codes;
+    fNCodes   = nCodes;
+    return curu;
+  } // HuffmanStreamDecoder::Read()
+
+
+  /**
+   * @brief Returns a decoder of adc positioned at the specified sample
+   * @param adc Huffman-encoded data
+   * @param sample index of the first sample the decoder will return
+   * @param index checkpoints of adc, or `nullptr` to decode from the start
+   *
+   * Decoding starts from the last checkpoint not after sample, if any.
+   */
+  HuffmanStreamDecoder seekHuffman(std::vector<short> const& adc,
+                                   std::size_t               sample,
+                                   raw::HuffmanIndex const*  index)
+  {
+    raw::HuffmanCheckpoint const* start = nullptr;
+    if(index){
+      auto const next = std::upper_bound(index->begin(), index->end(), sample,
+        [](std::size_t tick, raw::HuffmanCheckpoint const& checkpoint)
+          { return tick < checkpoint.tick; }
+        );
+      if(next != index->begin()) start = &*std::prev(next);
     }
-    else if(compress == raw::kZeroSuppression){
-      unsigned int zerothreshold = 5;
-      ZeroSuppression(adc,zerothreshold);
+
+    HuffmanStreamDecoder decoder = start
+      ? HuffmanStreamDecoder(adc, *start): HuffmanStreamDecoder(adc);
+    decoder.Skip(sample - (start? start->tick: 0));
+    return decoder;
+  } // seekHuffman()
+
+
+  /**
+   * @brief Reverses zero suppression in a window of ticks
+   * @param adc zero-suppressed data
+   * @param uncompressed filled with the ticks of the window
+   * @param pedestal value of the suppressed samples
+   * @param tickBegin first tick of the window
+   * @param tickEnd tick after the last one of the window
+   *
+   * The first block reaching into the window is found by a binary search of
+   * the block table. Its samples are then located by adding up the sizes of
+   * the blocks before it, which is a cheap loop on the table.
+   */
+  void ZeroUnsuppressionWindow(std::vector<short> const& adc,
+                               std::vector<short>&       uncompressed,
+                               int                       pedestal,
+                               std::size_t               tickBegin,
+                               std::size_t               tickEnd)
+  {
+    ZeroSuppressedLayout const layout(adc.data());
+    int const nBlocks = layout.NBlocks();
+    std::size_t const end
+      = std::min(tickEnd, static_cast<std::size_t>(layout.NTicks()));
+    std::size_t const first = std::min(tickBegin, end);
+
+    uncompressed.assign(end - first, pedestal);
+
+    auto const blockEnd = [&layout](int i)
+      { return static_cast<std::size_t>(layout.BlockBegin(i) + layout.BlockSize(i)); };
+
+    // first block ending after the start of the window
+    int lo = 0, hi = nBlocks;
+    while(lo < hi){
+      int const mid = lo + (hi - lo) / 2;
+      if(blockEnd(mid) > first) hi = mid;
+      else                      lo = mid + 1;
     }
 
+    std::size_t zerosuppressedindex = layout.DataStart();
+    for(int i = 0; i < lo; ++i) zerosuppressedindex += layout.BlockSize(i);
+
+    for(int i = lo; i < nBlocks; ++i){
+      std::size_t const blockBegin = layout.BlockBegin(i);
+      if(blockBegin >= end) break;
+      std::size_t const from = std::max(blockBegin, first);
+      std::size_t const to = std::min(blockEnd(i), end);
+      std::copy_n(adc.begin() + zerosuppressedindex + (from - blockBegin),
+        to - from, uncompressed.begin() + (from - first));
+      zerosuppressedindex += layout.BlockSize(i);
+    }
 
-    return;
+  } // ZeroUnsuppressionWindow()
+
+
+  /**
+   * @brief Reverses zero suppression and Huffman encoding in a single pass
+   * @param adc zero-suppressed, then Huffman-encoded data
+   * @param uncompressed filled with the ticks of the window
+   * @param pedestal value of the suppressed samples
+   * @param tickBegin first tick of the window
+   * @param tickEnd tick after the last one of the window
+   * @param index checkpoints of adc, or `nullptr` to decode from the start
+   *
+   * The zero-suppressed data is never materialized: the block begins, the
+   * block sizes and the samples are decoded by three decoders running
+   * along the stream side by side, and the samples of each block are
+   * decoded right into their place in uncompressed. Only the gaps between
+   * blocks are filled with the pedestal.
+   * The block table is decoded up to the window; the samples are decoded
+   * from the last checkpoint before the window, if an index is available.
+   */
+  void ZeroHuffmanUnsuppression(std::vector<short> const& adc,
+                                std::vector<short>&       uncompressed,
+                                int                       pedestal,
+                                std::size_t               tickBegin,
+                                std::size_t               tickEnd,
+                                raw::HuffmanIndex const*  index)
+  {
+    short header[ZeroSuppressedLayout::LongHeaderSize] = {};
+    HuffmanStreamDecoder(adc).Read(header, std::size(header));
+    ZeroSuppressedLayout const layout(header);
+    std::size_t const nBlocks = layout.NBlocks();
+    std::size_t const width = layout.ValueWidth();
+    std::size_t const end
+      = std::min(tickEnd, static_cast<std::size_t>(layout.NTicks()));
+    std::size_t const first = std::min(tickBegin, end);
+
+    HuffmanStreamDecoder begins(adc);
+    begins.Skip(layout.HeaderSize());
+    HuffmanStreamDecoder sizes(begins);
+    sizes.Skip(nBlocks * width);
+
+    auto const nextValue = [width](HuffmanStreamDecoder& decoder)
+      {
+        short const low = decoder.Next();
+        return static_cast<std::size_t>((width == 1)
+          ? low: ZeroSuppressedLayout::LongValue(low, decoder.Next()));
+      };
+
+    uncompressed.resize(end - first);
+    short* const out = uncompressed.data(); // tick `t` is at `out[t - first]`
+    short const fill = pedestal;
+
+    // index of the samples of the current block in the zero-suppressed data
+    std::size_t sample = layout.HeaderSize() + 2 * nBlocks * width;
+
+    // skip the blocks ending before the window
+    std::size_t i = 0, blockBegin = 0, blockSize = 0;
+    for(; i < nBlocks; ++i){
+      blockBegin = nextValue(begins);
+      blockSize = nextValue(sizes);
+      if(blockBegin + blockSize > first) break;
+      sample += blockSize;
+    }
+
+    std::size_t tick = first; // next tick to be written
+    if((i < nBlocks) && (blockBegin < end)){
+      HuffmanStreamDecoder data = seekHuffman
+        (adc, sample + (std::max(blockBegin, first) - blockBegin), index);
+      while(true){
+        std::size_t const from = std::max(blockBegin, first);
+        std::size_t const to = std::min(blockBegin + blockSize, end);
+        if(from > tick) std::fill(out + (tick - first), out + (from - first), fill);
+        std::size_t const nRead = data.Read(out + (from - first), to - from);
+        std::fill(out + (from - first) + nRead, out + (to - first), 0); // truncated data
+        tick = to;
+        if(++i >= nBlocks) break;
+        blockBegin = nextValue(begins);
+        blockSize = nextValue(sizes);
+        if(blockBegin >= end) break;
+      }
+    }
+    if(tick < end) std::fill(out + (tick - first), out + (end - first), fill);
+
+  } // ZeroHuffmanUnsuppression()
+
+
+  /// Number of samples decoded at a time for pedestal subtraction
+  constexpr std::size_t SubtractionChunkSize = 512;
+
+  /// Writes the n samples from adc minus pedestal into out
+  void subtractPedestal
+    (short const* adc, std::size_t n, float pedestal, float* out)
+  {
+    std::size_t i = 0;
+#if defined(__AVX2__)
+    __m256 const vped = _mm256_set1_ps(pedestal);
+    for(; i + 8 <= n; i += 8){
+      __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(adc + i));
+      __m256 const f = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(v));
+      _mm256_storeu_ps(out + i, _mm256_sub_ps(f, vped));
+    } // for
+#elif defined(__SSE2__)
+    __m128 const vped = _mm_set1_ps(pedestal);
+    for(; i + 8 <= n; i += 8){
+      __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(adc + i));
+      // each sample goes to the upper half of a 32-bit lane, then it is
+      // shifted down with sign extension
+      __m128i const lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+      __m128i const hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+      _mm_storeu_ps(out + i, _mm_sub_ps(_mm_cvtepi32_ps(lo), vped));
+      _mm_storeu_ps(out + i + 4, _mm_sub_ps(_mm_cvtepi32_ps(hi), vped));
+    } // for
+#endif // vector instructions
+    for(; i < n; ++i) out[i] = adc[i] - pedestal;
+  } // subtractPedestal()
+
+
+  /// Decodes n samples into out, minus pedestal; samples past the end of the
+  /// data are 0
+  void decodeSubtracted(HuffmanStreamDecoder& decoder,
+                        std::size_t           n,
+                        float                 pedestal,
+                        float*                out)
+  {
+    short buffer[SubtractionChunkSize];
+    while(n > 0){
+      std::size_t const chunk = std::min(n, SubtractionChunkSize);
+      std::size_t const nRead = decoder.Read(buffer, chunk);
+      subtractPedestal(buffer, nRead, pedestal, out);
+      if(nRead < chunk){ // truncated data
+        std::fill(out + nRead, out + n, 0.f);
+        return;
+      }
+      out += chunk;
+      n -= chunk;
+    } // while
+  } // decodeSubtracted()
+
+
+  /// Reverses zero suppression into nTicks values minus pedestal
+  void ZeroUnsuppressionSubtracted(std::vector<short> const& adc,
+                                   float*                    out,
+                                   std::size_t               nTicks,
+                                   float                     pedestal)
+  {
+    std::size_t tick = 0; // next tick to be written
+    if(!adc.empty()){
+      ZeroSuppressedLayout const layout(adc.data());
+      std::size_t const end
+        = std::min(nTicks, static_cast<std::size_t>(layout.NTicks()));
+      std::size_t sample = layout.DataStart();
+      for(int i = 0; i < layout.NBlocks(); ++i){
+        std::size_t const blockBegin = layout.BlockBegin(i);
+        if(blockBegin >= end) break;
+        std::size_t const size
+          = std::min(static_cast<std::size_t>(layout.BlockSize(i)), end - blockBegin);
+        if(blockBegin > tick) std::fill(out + tick, out + blockBegin, 0.f);
+        subtractPedestal(adc.data() + sample, size, pedestal, out + blockBegin);
+        sample += layout.BlockSize(i);
+        tick = blockBegin + size;
+      } // for blocks
+    }
+    if(tick < nTicks) std::fill(out + tick, out + nTicks, 0.f);
+  } // ZeroUnsuppressionSubtracted()
+
+
+  /// Reverses zero suppression and Huffman encoding into nTicks values minus
+  /// pedestal, in a single pass like ZeroHuffmanUnsuppression()
+  void ZeroHuffmanUnsuppressionSubtracted(std::vector<short> const& adc,
+                                          float*                    out,
+                                          std::size_t               nTicks,
+                                          float                     pedestal)
+  {
+    std::size_t tick = 0; // next tick to be written
+    if(!adc.empty()){
+      short header[ZeroSuppressedLayout::LongHeaderSize] = {};
+      HuffmanStreamDecoder(adc).Read(header, std::size(header));
+      ZeroSuppressedLayout const layout(header);
+      std::size_t const nBlocks = layout.NBlocks();
+      std::size_t const width = layout.ValueWidth();
+      std::size_t const end
+        = std::min(nTicks, static_cast<std::size_t>(layout.NTicks()));
+
+      HuffmanStreamDecoder begins(adc);
+      begins.Skip(layout.HeaderSize());
+      HuffmanStreamDecoder sizes(begins);
+      sizes.Skip(nBlocks * width);
+      HuffmanStreamDecoder data(sizes);
+      data.Skip(nBlocks * width);
+
+      auto const nextValue = [width](HuffmanStreamDecoder& decoder)
+        {
+          short const low = decoder.Next();
+          return static_cast<std::size_t>((width == 1)
+            ? low: ZeroSuppressedLayout::LongValue(low, decoder.Next()));
+        };
+
+      for(std::size_t i = 0; i < nBlocks; ++i){
+        std::size_t const blockBegin = nextValue(begins);
+        std::size_t const blockSize = nextValue(sizes);
+        if(blockBegin >= end) break;
+        std::size_t const size = std::min(blockSize, end - blockBegin);
+        if(blockBegin > tick) std::fill(out + tick, out + blockBegin, 0.f);
+        decodeSubtracted(data, size, pedestal, out + blockBegin);
+        tick = blockBegin + size;
+      } // for blocks
+    }
+    if(tick < nTicks) std::fill(out + tick, out + nTicks, 0.f);
+  } // ZeroHuffmanUnsuppressionSubtracted()
+
+  /// Counts the samples escaped in Huffman-encoded data into record, if any:
+  /// all the words but the first one without bit 15 (see raw::CompressHuffman())
+  void recordHuffman(std::vector<short> const& adc, raw::CompressionRecord* record)
+  {
+    if(!record || adc.empty()) return;
+    record->huffmanEscapes = std::count_if(adc.begin() + 1, adc.end(),
+      [](short word){ return word >= 0; });
+  } // recordHuffman()
+
+
+  /// Records blocks and samples of zero-suppressed data into record, if any
+  void recordZeroSuppression
+    (std::vector<short> const& adc, raw::CompressionRecord* record)
+  {
+    if(!record || adc.empty()) return;
+    ZeroSuppressedLayout const layout(adc.data());
+    record->zsBlocks = layout.NBlocks();
+    record->zsKeptTicks = adc.size() - layout.DataStart();
+  } // recordZeroSuppression()
+
+
+  /// Zero-suppresses adc with the algorithm selected by params
+  void ZeroSuppress(std::vector<short>& adc, raw::CodecParameters const& params)
+  {
+    unsigned int zerothreshold = params.zerothreshold;
+    if(!params.pedestal && !params.nearestneighbor && !params.neighbors){
+      raw::ZeroSuppression(adc, zerothreshold);
+      recordZeroSuppression(adc, params.statistics);
+      return;
+    }
+
+    int nearestneighbor = params.nearestneighbor.value_or(0);
+    if(params.neighbors){
+      if(params.pedestal){
+        raw::ZeroSuppression(*params.neighbors, adc, zerothreshold,
+          *params.pedestal, nearestneighbor, params.fADCStickyCodeFeature);
+      }
+      else{
+        raw::ZeroSuppression
+          (*params.neighbors, adc, zerothreshold, nearestneighbor);
+      }
+    }
+    else if(params.pedestal){
+      raw::ZeroSuppression(adc, zerothreshold,
+        *params.pedestal, nearestneighbor, params.fADCStickyCodeFeature);
+    }
+    else raw::ZeroSuppression(adc, zerothreshold, nearestneighbor);
+    recordZeroSuppression(adc, params.statistics);
+  } // ZeroSuppress()
+
+
+  /// Codec of uncompressed data (raw::kNone)
+  class NoneCodec: public raw::Codec {
+  public:
+    void Encode(std::vector<short>&, raw::CodecParameters const&) const override
+      {}
+
+    void Decode(std::vector<short> const& adc,
+                std::vector<short>&       uncompressed,
+                int) const override
+      {
+        for(unsigned int i = 0; i < adc.size(); ++i) uncompressed[i] = adc[i];
+      }
+
+    void DecodeRange(std::vector<short> const& adc,
+                     std::vector<short>&       uncompressed,
+                     int,
+                     std::size_t               tickBegin,
+                     std::size_t               tickEnd,
+                     raw::HuffmanIndex const*) const override
+      {
+        std::size_t const end = std::min(tickEnd, adc.size());
+        std::size_t const first = std::min(tickBegin, end);
+        uncompressed.assign(adc.begin() + first, adc.begin() + end);
+      }
+  }; // class NoneCodec
+
+
+  /// Codec of Huffman-encoded data (raw::kHuffman)
+  class HuffmanCodec: public raw::Codec {
+  public:
+    void Encode
+      (std::vector<short>& adc, raw::CodecParameters const& params) const override
+      {
+        raw::CompressHuffman(adc);
+        recordHuffman(adc, params.statistics);
+      }
+
+    void Decode(std::vector<short> const& adc,
+                std::vector<short>&       uncompressed,
+                int) const override
+      { raw::UncompressHuffman(adc, uncompressed); }
+
+    void DecodeRange(std::vector<short> const& adc,
+                     std::vector<short>&       uncompressed,
+                     int,
+                     std::size_t               tickBegin,
+                     std::size_t               tickEnd,
+                     raw::HuffmanIndex const*  index) const override
+      {
+        uncompressed.clear();
+        if(tickEnd <= tickBegin) return;
+
+        // the end of the waveform is known only when decoding reaches it:
+        // the buffer grows while reading, up to the window size or to the
+        // most ticks the data can encode (4 per bit, 60 per word)
+        std::size_t const maxTicks
+          = std::min(tickEnd - tickBegin, 60 * adc.size());
+        std::size_t size = std::min(maxTicks, 4 * adc.size());
+        std::size_t nRead = 0;
+        HuffmanStreamDecoder decoder = seekHuffman(adc, tickBegin, index);
+        while(true){
+          uncompressed.resize(size);
+          nRead += decoder.Read(uncompressed.data() + nRead, size - nRead);
+          if((nRead < size) || (size == maxTicks)) break;
+          size = std::min(2 * size, maxTicks);
+        } // while
+        uncompressed.resize(nRead);
+      }
+  }; // class HuffmanCodec
+
+
+  /// Codec of zero-suppressed data (raw::kZeroSuppression)
+  class ZeroSuppressionCodec: public raw::Codec {
+  public:
+    void Encode
+      (std::vector<short>& adc, raw::CodecParameters const& params) const override
+      { ZeroSuppress(adc, params); }
+
+    void Decode(std::vector<short> const& adc,
+                std::vector<short>&       uncompressed,
+                int                       pedestal) const override
+      { raw::ZeroUnsuppression(adc, uncompressed, pedestal); }
+
+    void DecodeRange(std::vector<short> const& adc,
+                     std::vector<short>&       uncompressed,
+                     int                       pedestal,
+                     std::size_t               tickBegin,
+                     std::size_t               tickEnd,
+                     raw::HuffmanIndex const*) const override
+      {
+        ZeroUnsuppressionWindow
+          (adc, uncompressed, pedestal, tickBegin, tickEnd);
+      }
+  }; // class ZeroSuppressionCodec
+
+
+  /// Codec of zero-suppressed, then Huffman-encoded data (raw::kZeroHuffman)
+  class ZeroHuffmanCodec: public raw::Codec {
+  public:
+    void Encode
+      (std::vector<short>& adc, raw::CodecParameters const& params) const override
+      {
+        ZeroSuppress(adc, params);
+        raw::ZeroSuppressedForHuffman(adc);
+        raw::CompressHuffman(adc);
+        recordHuffman(adc, params.statistics);
+      }
+
+    void Decode(std::vector<short> const& adc,
+                std::vector<short>&       uncompressed,
+                int                       pedestal) const override
+      {
+        ZeroHuffmanUnsuppression(adc, uncompressed, pedestal,
+          0, std::numeric_limits<std::size_t>::max(), nullptr);
+      }
+
+    void DecodeRange(std::vector<short> const& adc,
+                     std::vector<short>&       uncompressed,
+                     int                       pedestal,
+                     std::size_t               tickBegin,
+                     std::size_t               tickEnd,
+                     raw::HuffmanIndex const*  index) const override
+      {
+        ZeroHuffmanUnsuppression
+          (adc, uncompressed, pedestal, tickBegin, tickEnd, index);
+      }
+  }; // class ZeroHuffmanCodec
+
+
+  /// Compresses adc with the codec for compress, if any, and records the
+  /// sizes into the statistics requested in params
+  void Encode(std::vector<short>&         adc,
+              raw::Compress_t             compress,
+              raw::CodecParameters const& params)
+  {
+    if(params.statistics){
+      *params.statistics = raw::CompressionRecord{};
+      params.statistics->ticks = adc.size();
+    }
+    raw::Codec const* codec = raw::CodecRegistry::Instance().Find(compress);
+    if(codec) codec->Encode(adc, params);
+    if(params.statistics) params.statistics->words = adc.size();
   }
-  //----------------------------------------------------------
-  void Compress(std::vector<short> &adc,
-		raw::Compress_t     compress,
-		int                &nearestneighbor)
+
+
+  /// Returns the codec for compress
+  /// @throw cet::exception if there is none
+  raw::Codec const& DecoderFor(raw::Compress_t compress)
   {
-    if(compress == raw::kHuffman) CompressHuffman(adc);
-    else if(compress == raw::kZeroHuffman){
-      unsigned int zerothreshold = 5;
-      ZeroSuppression(adc,zerothreshold, nearestneighbor);
-      CompressHuffman(adc);
+    raw::Codec const* codec = raw::CodecRegistry::Instance().Find(compress);
+    if(!codec){
+      throw cet::exception("raw")
+        << "raw::Uncompress() does not support compression #"
+        << ((int) compress);
     }
-    else if(compress == raw::kZeroSuppression){
-      unsigned int zerothreshold = 5;
-      ZeroSuppression(adc,zerothreshold, nearestneighbor);
+    return *codec;
+  }
+
+  /// Branchless implementation of raw::ADCStickyCodeCheck()
+  inline int StickyCodeMagnitude
+    (short adc, int pedestal, bool fADCStickyCodeFeature)
+  {
+    int const magnitude = std::abs(adc - pedestal);
+    unsigned int const sixlsbs = adc & raw::onemask;
+    bool const stuck = fADCStickyCodeFeature
+      & ((sixlsbs == raw::onemask) | (sixlsbs == 0)) & (magnitude < 64);
+    return stuck? 0: magnitude;
+  } // StickyCodeMagnitude()
+
+} // local namespace
+
+
+namespace raw {
+
+  namespace details {
+
+    //----------------------------------------------------------
+    void RegisterBuiltinCodecs(CodecRegistry& registry)
+    {
+      registry.Register(raw::kNone, std::make_unique<NoneCodec>());
+      registry.Register(raw::kHuffman, std::make_unique<HuffmanCodec>());
+      registry.Register
+        (raw::kZeroSuppression, std::make_unique<ZeroSuppressionCodec>());
+      registry.Register(raw::kZeroHuffman, std::make_unique<ZeroHuffmanCodec>());
     }
 
+  } // namespace details
 
-    return;
+  //----------------------------------------------------------
+  // All the Compress() overloads use the codec registered for the compression
+  // type; types without a codec are left uncompressed.
+  void Compress(std::vector<short> &adc,
+		raw::Compress_t     compress)
+  {
+    CodecParameters params;
+    Encode(adc, compress, params);
+  }
+  //----------------------------------------------------------
+  void Compress(std::vector<short>&    adc,
+		raw::Compress_t        compress,
+		CodecParameters const& params)
+  {
+    Encode(adc, compress, params);
+  }
+  //----------------------------------------------------------
+  void Compress(std::vector<short> &adc,
+		raw::Compress_t     compress,
+		int                &nearestneighbor)
+  {
+    CodecParameters params;
+    params.nearestneighbor = nearestneighbor;
+    Encode(adc, compress, params);
   }
 
   //----------------------------------------------------------
@@ -58,15 +942,9 @@ namespace raw {
 		raw::Compress_t     compress,
 		unsigned int       &zerothreshold)
   {
-    if(compress == raw::kHuffman) CompressHuffman(adc);
-
-    else if(compress == raw::kZeroSuppression) ZeroSuppression(adc,zerothreshold);
-    else if(compress == raw::kZeroHuffman){
-      ZeroSuppression(adc,zerothreshold);
-      CompressHuffman(adc);
-    }
-
-    return;
+    CodecParameters params;
+    params.zerothreshold = zerothreshold;
+    Encode(adc, compress, params);
   }
   //----------------------------------------------------------
   void Compress(std::vector<short> &adc,
@@ -74,16 +952,10 @@ namespace raw {
 		unsigned int       &zerothreshold,
 		int                &nearestneighbor)
   {
-    if(compress == raw::kHuffman)
-      CompressHuffman(adc);
-    else if(compress == raw::kZeroSuppression)
-      ZeroSuppression(adc,zerothreshold, nearestneighbor);
-    else if(compress == raw::kZeroHuffman){
-      ZeroSuppression(adc,zerothreshold, nearestneighbor);
-      CompressHuffman(adc);
-    }
-
-    return;
+    CodecParameters params;
+    params.zerothreshold = zerothreshold;
+    params.nearestneighbor = nearestneighbor;
+    Encode(adc, compress, params);
   }
 
   //----------------------------------------------------------
@@ -93,36 +965,27 @@ namespace raw {
 		unsigned int       &zerothreshold,
 		int                &nearestneighbor)
   {
-    if(compress == raw::kHuffman)
-      CompressHuffman(adc);
-    else if(compress == raw::kZeroSuppression)
-      ZeroSuppression(adcvec_neighbors,adc,zerothreshold, nearestneighbor);
-    else if(compress == raw::kZeroHuffman){
-      ZeroSuppression(adcvec_neighbors,adc,zerothreshold, nearestneighbor);
-      CompressHuffman(adc);
-    }
-
-    return;
+    CodecParameters params;
+    params.zerothreshold = zerothreshold;
+    params.nearestneighbor = nearestneighbor;
+    params.neighbors = &adcvec_neighbors;
+    Encode(adc, compress, params);
   }
 
   //----------------------------------------------------------
   void Compress(std::vector<short> &adc,
 		raw::Compress_t     compress,
 		unsigned int       &zerothreshold,
-		int               pedestal,
+		int                 pedestal,
 		int                &nearestneighbor,
-		bool              fADCStickyCodeFeature)
+		bool                fADCStickyCodeFeature)
   {
-    if(compress == raw::kHuffman)
-      CompressHuffman(adc);
-    else if(compress == raw::kZeroSuppression)
-      ZeroSuppression(adc,zerothreshold, pedestal, nearestneighbor, fADCStickyCodeFeature);
-    else if(compress == raw::kZeroHuffman){
-      ZeroSuppression(adc,zerothreshold, pedestal, nearestneighbor, fADCStickyCodeFeature);
-      CompressHuffman(adc);
-    }
-
-    return;
+    CodecParameters params;
+    params.zerothreshold = zerothreshold;
+    params.pedestal = pedestal;
+    params.nearestneighbor = nearestneighbor;
+    params.fADCStickyCodeFeature = fADCStickyCodeFeature;
+    Encode(adc, compress, params);
   }
 
   //----------------------------------------------------------
@@ -130,92 +993,37 @@ namespace raw {
 		std::vector<short> &adc,
 		raw::Compress_t     compress,
 		unsigned int       &zerothreshold,
-		int               pedestal,
+		int                 pedestal,
 		int                &nearestneighbor,
-		bool              fADCStickyCodeFeature)
+		bool                fADCStickyCodeFeature)
   {
-    if(compress == raw::kHuffman)
-      CompressHuffman(adc);
-    else if(compress == raw::kZeroSuppression)
-      ZeroSuppression(adcvec_neighbors,adc,zerothreshold, pedestal, nearestneighbor, fADCStickyCodeFeature);
-    else if(compress == raw::kZeroHuffman){
-      ZeroSuppression(adcvec_neighbors,adc,zerothreshold, pedestal, nearestneighbor, fADCStickyCodeFeature);
-      CompressHuffman(adc);
-    }
-
-    return;
+    CodecParameters params;
+    params.zerothreshold = zerothreshold;
+    params.pedestal = pedestal;
+    params.nearestneighbor = nearestneighbor;
+    params.fADCStickyCodeFeature = fADCStickyCodeFeature;
+    params.neighbors = &adcvec_neighbors;
+    Encode(adc, compress, params);
   }
 
 
+  //----------------------------------------------------------
+  // The zero suppression functions are implemented by raw::ZeroSuppressor;
+  // each thread uses its own, so that its work space is reused.
+  ZeroSuppressor& ThreadLocalZeroSuppressor()
+  {
+    static thread_local ZeroSuppressor suppressor;
+    return suppressor;
+  }
+
   //----------------------------------------------------------
   // Zero suppression function
   void ZeroSuppression(std::vector<short> &adc,
 		       unsigned int       &zerothreshold)
   {
-    const int adcsize = adc.size();
-    const int zerothresholdsigned = zerothreshold;
-
-    std::vector<short> zerosuppressed(adc.size());
-    int maxblocks = adcsize/2 + 1;
-    std::vector<short> blockbegin(maxblocks);
-    std::vector<short> blocksize(maxblocks);
-
-    unsigned int nblocks = 0;
-    unsigned int zerosuppressedsize = 0;
-
-    int blockcheck = 0;
-
-    for(int i = 0; i < adcsize; ++i){
-      int adc_current_value = std::abs(adc[i]);
-
-      if(adc_current_value > zerothresholdsigned){
-
-	if(blockcheck == 0){
-
-	  blockbegin[nblocks] = i;
-	  blocksize[nblocks] = 0;
-	  blockcheck=1;
-	}
-
-	zerosuppressed[zerosuppressedsize] = adc[i];
-	zerosuppressedsize++;
-	blocksize[nblocks]++;
-
-	if(i == adcsize-1) nblocks++;
-      }
-
-      if(adc_current_value <= zerothresholdsigned && blockcheck == 1){
-	  zerosuppressed[zerosuppressedsize] = adc[i];
-	  zerosuppressedsize++;
-	  blocksize[nblocks]++;
-	  nblocks++;
-	  blockcheck = 0;
-      }
-    }
-
-
-
-    adc.resize(2+nblocks+nblocks+zerosuppressedsize);
-
-    adc[0] = adcsize; //fill first entry in adc with length of uncompressed vector
-    adc[1] = nblocks;
-
-
-
-    for(unsigned int i = 0; i < nblocks; ++i)
-      adc[i+2] = blockbegin[i];
-
-    for(unsigned int i = 0; i < nblocks; ++i)
-      adc[i+nblocks+2] = blocksize[i];
-
-    for(unsigned int i = 0; i < zerosuppressedsize; ++i)
-      adc[i+nblocks+nblocks+2] = zerosuppressed[i];
-
-
+    ThreadLocalZeroSuppressor().Suppress(adc, zerothreshold);
   }
 
-
-
   //----------------------------------------------------------
   // Zero suppression function which merges blocks if they are
   // within parameter nearestneighbor of each other
@@ -223,107 +1031,7 @@ namespace raw {
 		       unsigned int       &zerothreshold,
 		       int                &nearestneighbor)
   {
-
-    const int adcsize = adc.size();
-    const int zerothresholdsigned = zerothreshold;
-
-    std::vector<short> zerosuppressed(adcsize);
-    int maxblocks = adcsize/2 + 1;
-    std::vector<short> blockbegin(maxblocks);
-    std::vector<short> blocksize(maxblocks);
-
-    int nblocks = 0;
-    int zerosuppressedsize = 0;
-
-    int blockstartcheck = 0;
-    int endofblockcheck = 0;
-
-    for(int i = 0; i < adcsize; ++i){
-      int adc_current_value = std::abs(adc[i]);
-
-      if(blockstartcheck==0){
-	if(adc_current_value>zerothresholdsigned){
-	  if(nblocks>0){
-	    if((i-nearestneighbor)<=(blockbegin[nblocks-1]+blocksize[nblocks-1]+1)){
-
-	      nblocks--;
-	      blocksize[nblocks] = i - blockbegin[nblocks] + 1;
-	      blockstartcheck = 1;
-	    }
-	    else{
-	      blockbegin[nblocks] = (i - nearestneighbor > 0) ? i - nearestneighbor : 0;
-	      blocksize[nblocks] = i - blockbegin[nblocks] + 1;
-	      blockstartcheck = 1;
-	    }
-	  }
-	  else{
-	    blockbegin[nblocks] = (i - nearestneighbor > 0) ? i - nearestneighbor : 0;
-	    blocksize[nblocks] = i - blockbegin[nblocks] + 1;
-	    blockstartcheck = 1;
-	  }
-	}
-      }
-      else if(blockstartcheck==1){
-	if(adc_current_value>zerothresholdsigned){
-	  blocksize[nblocks]++;
-	  endofblockcheck = 0;
-	}
-	else{
-	  if(endofblockcheck<nearestneighbor){
-	    endofblockcheck++;
-	    blocksize[nblocks]++;
-	  }
-	  //block has ended
-	  else if(i+2<adcsize){ //check if end of adc vector is near
-	    if(std::abs(adc[i+1]) <= zerothresholdsigned && std::abs(adc[i+2]) <= zerothresholdsigned){
-	      endofblockcheck = 0;
-	      blockstartcheck = 0;
-	      nblocks++;
-	    }
-	  }
-
-
-	} // end else
-      } // end if blockstartcheck == 1
-    }// end loop over adc size
-
-    if(blockstartcheck==1){ // we reached the end of the adc vector with the block still going
-      ++nblocks;
-    }
-
-    for(int i = 0; i < nblocks; ++i)
-      zerosuppressedsize += blocksize[i];
-
-
-    adc.resize(2+nblocks+nblocks+zerosuppressedsize);
-    zerosuppressed.resize(2+nblocks+nblocks+zerosuppressedsize);
-
-
-    int zerosuppressedcount = 0;
-    for(int i = 0; i < nblocks; ++i){
-      //zerosuppressedsize += blocksize[i];
-      for(int j = 0; j < blocksize[i]; ++j){
-	zerosuppressed[zerosuppressedcount] = adc[blockbegin[i] + j];
-	zerosuppressedcount++;
-      }
-    }
-
-    adc[0] = adcsize; //fill first entry in adc with length of uncompressed vector
-    adc[1] = nblocks;
-    for(int i = 0; i < nblocks; ++i){
-      adc[i+2] = blockbegin[i];
-      adc[i+nblocks+2] = blocksize[i];
-    }
-
-
-
-    for(int i = 0; i < zerosuppressedsize; ++i)
-      adc[i+nblocks+nblocks+2] = zerosuppressed[i];
-
-
-    // for(int i = 0; i < 2 + 2*nblocks + zerosuppressedsize; ++i)
-    //   std::cout << adc[i] << std::endl;
-    //adc.resize(2+nblocks+nblocks+zerosuppressedsize);
+    ThreadLocalZeroSuppressor().Suppress(adc, zerothreshold, nearestneighbor);
   }
 
   //----------------------------------------------------------
@@ -336,105 +1044,8 @@ namespace raw {
 		       int                &nearestneighbor,
 		       bool              fADCStickyCodeFeature)
   {
-
-    const int adcsize = adc.size();
-    const int zerothresholdsigned = zerothreshold;
-
-    std::vector<short> zerosuppressed(adcsize);
-    int maxblocks = adcsize/2 + 1;
-    std::vector<short> blockbegin(maxblocks);
-    std::vector<short> blocksize(maxblocks);
-
-    int nblocks = 0;
-    int zerosuppressedsize = 0;
-
-    int blockstartcheck = 0;
-    int endofblockcheck = 0;
-
-    for(int i = 0; i < adcsize; ++i){
-      int adc_current_value = ADCStickyCodeCheck(adc[i],pedestal,fADCStickyCodeFeature);
-
-      if(blockstartcheck==0){
-	if(adc_current_value>zerothresholdsigned){
-	  if(nblocks>0){
-	    if(i-nearestneighbor<=blockbegin[nblocks-1]+blocksize[nblocks-1]+1){
-	      nblocks--;
-	      blocksize[nblocks] = i - blockbegin[nblocks] + 1;
-	      blockstartcheck = 1;
-	    }
-	    else{
-	      blockbegin[nblocks] = (i - nearestneighbor > 0) ? i - nearestneighbor : 0;
-	      blocksize[nblocks] = i - blockbegin[nblocks] + 1;
-	      blockstartcheck = 1;
-	    }
-	  }
-	  else{
-	    blockbegin[nblocks] = (i - nearestneighbor > 0) ? i - nearestneighbor : 0;
-	    blocksize[nblocks] = i - blockbegin[nblocks] + 1;
-	    blockstartcheck = 1;
-	  }
-	}
-      }
-      else if(blockstartcheck==1){
-	if(adc_current_value>zerothresholdsigned){
-	  blocksize[nblocks]++;
-	  endofblockcheck = 0;
-	}
-	else{
-	  if(endofblockcheck<nearestneighbor){
-	    endofblockcheck++;
-	    blocksize[nblocks]++;
-	  }
-	  //block has ended
-	  else if(i+2<adcsize){ //check if end of adc vector is near
-	    if(ADCStickyCodeCheck(adc[i+1],pedestal,fADCStickyCodeFeature) <= zerothresholdsigned && ADCStickyCodeCheck(adc[i+2],pedestal,fADCStickyCodeFeature) <= zerothresholdsigned){
-	      endofblockcheck = 0;
-	      blockstartcheck = 0;
-	      nblocks++;
-	    }
-	  }
-	} // end else
-      } // end if blockstartcheck == 1
-    }// end loop over adc size
-
-    if(blockstartcheck==1){ // we reached the end of the adc vector with the block still going
-      ++nblocks;
-    }
-
-
-    for(int i = 0; i < nblocks; ++i)
-      zerosuppressedsize += blocksize[i];
-
-
-    adc.resize(2+nblocks+nblocks+zerosuppressedsize);
-    zerosuppressed.resize(2+nblocks+nblocks+zerosuppressedsize);
-
-
-    int zerosuppressedcount = 0;
-    for(int i = 0; i < nblocks; ++i){
-      //zerosuppressedsize += blocksize[i];
-      for(int j = 0; j < blocksize[i]; ++j){
-	zerosuppressed[zerosuppressedcount] = adc[blockbegin[i] + j];
-	zerosuppressedcount++;
-      }
-    }
-
-    adc[0] = adcsize; //fill first entry in adc with length of uncompressed vector
-    adc[1] = nblocks;
-    for(int i = 0; i < nblocks; ++i){
-      adc[i+2] = blockbegin[i];
-      adc[i+nblocks+2] = blocksize[i];
-    }
-
-
-
-    for(int i = 0; i < zerosuppressedsize; ++i)
-      adc[i+nblocks+nblocks+2] = zerosuppressed[i];
-
-
-    // for(int i = 0; i < 2 + 2*nblocks + zerosuppressedsize; ++i)
-    //   std::cout << adc[i] << std::endl;
-    //adc.resize(2+nblocks+nblocks+zerosuppressedsize);
+    ThreadLocalZeroSuppressor().Suppress
+      (adc, zerothreshold, pedestal, nearestneighbor, fADCStickyCodeFeature);
   }
 
   //----------------------------------------------------------
@@ -446,119 +1057,8 @@ namespace raw {
 		       unsigned int       &zerothreshold,
 		       int                &nearestneighbor)
   {
-
-    const int adcsize = adc.size();
-    const int zerothresholdsigned = zerothreshold;
-
-    std::vector<short> zerosuppressed(adcsize);
-    const int maxblocks = adcsize/2 + 1;
-    std::vector<short> blockbegin(maxblocks);
-    std::vector<short> blocksize(maxblocks);
-
-    int nblocks = 0;
-    int zerosuppressedsize = 0;
-
-    int blockstartcheck = 0;
-    int endofblockcheck = 0;
-
-    for(int i = 0; i < adcsize; ++i){
-
-      //find maximum adc value among all neighboring channels within the nearest neighbor channel distance
-
-      int adc_current_value = 0;
-
-      for(boost::circular_buffer<std::vector<short>>::const_iterator adcveciter = adcvec_neighbors.begin(); adcveciter!=adcvec_neighbors.end();++adcveciter){
-	const std::vector<short> &adcvec_current = *adcveciter;
-	const int adcvec_current_single = std::abs(adcvec_current[i]);
-
-	if(adc_current_value < adcvec_current_single){
-	  adc_current_value = adcvec_current_single;
-	}
-
-      }
-      if(blockstartcheck==0){
-	if(adc_current_value>zerothresholdsigned){
-	  if(nblocks>0){
-	    if(i-nearestneighbor<=blockbegin[nblocks-1]+blocksize[nblocks-1]+1){
-	      nblocks--;
-	      blocksize[nblocks] = i - blockbegin[nblocks] + 1;
-	      blockstartcheck = 1;
-	    }
-	    else{
-	      blockbegin[nblocks] = (i - nearestneighbor > 0) ? i - nearestneighbor : 0;
-	      blocksize[nblocks] = i - blockbegin[nblocks] + 1;
-	      blockstartcheck = 1;
-	    }
-	  }
-	  else{
-	    blockbegin[nblocks] = (i - nearestneighbor > 0) ? i - nearestneighbor : 0;
-	    blocksize[nblocks] = i - blockbegin[nblocks] + 1;
-	    blockstartcheck = 1;
-	  }
-	}
-      }
-      else if(blockstartcheck==1){
-	if(adc_current_value>zerothresholdsigned){
-	  blocksize[nblocks]++;
-	  endofblockcheck = 0;
-	}
-	else{
-	  if(endofblockcheck<nearestneighbor){
-	    endofblockcheck++;
-	    blocksize[nblocks]++;
-	  }
-	  //block has ended
-	  else  if(i+2<adcsize){ //check if end of adc vector is near
-	    if(std::abs(adc[i+1]) <= zerothresholdsigned && std::abs(adc[i+2]) <= zerothresholdsigned){
-	      endofblockcheck = 0;
-	      blockstartcheck = 0;
-	      nblocks++;
-	    }
-	  }
-
-	} // end else
-      } // end if blockstartcheck == 1
-    }// end loop over adc size
-
-    if(blockstartcheck==1){ // we reached the end of the adc vector with the block still going
-      ++nblocks;
-    }
-
-
-
-    for(int i = 0; i < nblocks; ++i)
-      zerosuppressedsize += blocksize[i];
-
-
-    adc.resize(2+nblocks+nblocks+zerosuppressedsize);
-    zerosuppressed.resize(2+nblocks+nblocks+zerosuppressedsize);
-
-
-    int zerosuppressedcount = 0;
-    for(int i = 0; i < nblocks; ++i){
-      //zerosuppressedsize += blocksize[i];
-      for(int j = 0; j < blocksize[i]; ++j){
-	zerosuppressed[zerosuppressedcount] = adc[blockbegin[i] + j];
-	zerosuppressedcount++;
-      }
-    }
-
-    adc[0] = adcsize; //fill first entry in adc with length of uncompressed vector
-    adc[1] = nblocks;
-    for(int i = 0; i < nblocks; ++i){
-      adc[i+2] = blockbegin[i];
-      adc[i+nblocks+2] = blocksize[i];
-    }
-
-
-
-    for(int i = 0; i < zerosuppressedsize; ++i)
-      adc[i+nblocks+nblocks+2] = zerosuppressed[i];
-
-
-    // for(int i = 0; i < 2 + 2*nblocks + zerosuppressedsize; ++i)
-    //   std::cout << adc[i] << std::endl;
-    //adc.resize(2+nblocks+nblocks+zerosuppressedsize);
+    ThreadLocalZeroSuppressor().Suppress
+      (adcvec_neighbors, adc, zerothreshold, nearestneighbor);
   }
 
   //----------------------------------------------------------
@@ -573,120 +1073,8 @@ namespace raw {
 		       int                &nearestneighbor,
 		       bool              fADCStickyCodeFeature)
   {
-
-    const int adcsize = adc.size();
-    const int zerothresholdsigned = zerothreshold;
-
-    std::vector<short> zerosuppressed(adcsize);
-    const int maxblocks = adcsize/2 + 1;
-    std::vector<short> blockbegin(maxblocks);
-    std::vector<short> blocksize(maxblocks);
-
-    int nblocks = 0;
-    int zerosuppressedsize = 0;
-
-    int blockstartcheck = 0;
-    int endofblockcheck = 0;
-
-    for(int i = 0; i < adcsize; ++i){
-
-      //find maximum adc value among all neighboring channels within the nearest neighbor channel distance
-
-      int adc_current_value = ADCStickyCodeCheck(adc[i],pedestal,fADCStickyCodeFeature);
-
-      for(boost::circular_buffer<std::vector<short>>::const_iterator adcveciter = adcvec_neighbors.begin(); adcveciter!=adcvec_neighbors.end();++adcveciter){
-	const std::vector<short> &adcvec_current = *adcveciter;
-	const int adcvec_current_single = std::abs(adcvec_current[i] - pedestal);
-
-	if(adc_current_value < adcvec_current_single){
-	  adc_current_value = adcvec_current_single;
-	}
-
-      }
-      if(blockstartcheck==0){
-	if(adc_current_value>zerothresholdsigned){
-	  if(nblocks>0){
-	    if(i-nearestneighbor<=blockbegin[nblocks-1]+blocksize[nblocks-1]+1){
-	      nblocks--;
-	      blocksize[nblocks] = i - blockbegin[nblocks] + 1;
-	      blockstartcheck = 1;
-	    }
-	    else{
-	      blockbegin[nblocks] = (i - nearestneighbor > 0) ? i - nearestneighbor : 0;
-	      blocksize[nblocks] = i - blockbegin[nblocks] + 1;
-	      blockstartcheck = 1;
-	    }
-	  }
-	  else{
-	    blockbegin[nblocks] = (i - nearestneighbor > 0) ? i - nearestneighbor : 0;
-	    blocksize[nblocks] = i - blockbegin[nblocks] + 1;
-	    blockstartcheck = 1;
-	  }
-	}
-      }
-      else if(blockstartcheck==1){
-	if(adc_current_value>zerothresholdsigned){
-	  blocksize[nblocks]++;
-	  endofblockcheck = 0;
-	}
-	else{
-	  if(endofblockcheck<nearestneighbor){
-	    endofblockcheck++;
-	    blocksize[nblocks]++;
-	  }
-	  //block has ended
-
-	  else  if(i+2<adcsize){ //check if end of adc vector is near
-	    if(ADCStickyCodeCheck(adc[i+1],pedestal,fADCStickyCodeFeature) <= zerothresholdsigned && ADCStickyCodeCheck(adc[i+2],pedestal,fADCStickyCodeFeature) <= zerothresholdsigned){
-	      endofblockcheck = 0;
-	      blockstartcheck = 0;
-	      nblocks++;
-	    }
-	  }
-
-	} // end else
-      } // end if blockstartcheck == 1
-    }// end loop over adc size
-
-    if(blockstartcheck==1){ // we reached the end of the adc vector with the block still going
-      ++nblocks;
-    }
-
-
-
-    for(int i = 0; i < nblocks; ++i)
-      zerosuppressedsize += blocksize[i];
-
-
-    adc.resize(2+nblocks+nblocks+zerosuppressedsize);
-    zerosuppressed.resize(2+nblocks+nblocks+zerosuppressedsize);
-
-
-    int zerosuppressedcount = 0;
-    for(int i = 0; i < nblocks; ++i){
-      //zerosuppressedsize += blocksize[i];
-      for(int j = 0; j < blocksize[i]; ++j){
-	zerosuppressed[zerosuppressedcount] = adc[blockbegin[i] + j];
-	zerosuppressedcount++;
-      }
-    }
-
-    adc[0] = adcsize; //fill first entry in adc with length of uncompressed vector
-    adc[1] = nblocks;
-    for(int i = 0; i < nblocks; ++i){
-      adc[i+2] = blockbegin[i];
-      adc[i+nblocks+2] = blocksize[i];
-    }
-
-
-
-    for(int i = 0; i < zerosuppressedsize; ++i)
-      adc[i+nblocks+nblocks+2] = zerosuppressed[i];
-
-
-    // for(int i = 0; i < 2 + 2*nblocks + zerosuppressedsize; ++i)
-    //   std::cout << adc[i] << std::endl;
-    //adc.resize(2+nblocks+nblocks+zerosuppressedsize);
+    ThreadLocalZeroSuppressor().Suppress(adcvec_neighbors, adc,
+      zerothreshold, pedestal, nearestneighbor, fADCStickyCodeFeature);
   }
 
 
@@ -695,28 +1083,7 @@ namespace raw {
   void ZeroUnsuppression(const std::vector<short>& adc,
 			 std::vector<short>      &uncompressed)
   {
-    const int lengthofadc = adc[0];
-    const int nblocks = adc[1];
-
-    uncompressed.resize(lengthofadc);
-    for (int i = 0;i < lengthofadc; ++i){
-      uncompressed[i] = 0;
-    }
-
-    int zerosuppressedindex = nblocks*2 + 2;
-
-    for(int i = 0; i < nblocks; ++i){ //loop over each nonzero block of the compressed vector
-
-      for(int j = 0; j < adc[2+nblocks+i]; ++j){//loop over each block size
-
-	//set uncompressed value
-	uncompressed[adc[2+i]+j] = adc[zerosuppressedindex];
-	zerosuppressedindex++;
-
-      }
-    }
-
-    return;
+    ZeroUnsuppression(adc, uncompressed, 0);
   }
 
   //----------------------------------------------------------
@@ -725,25 +1092,18 @@ namespace raw {
 			 std::vector<short>      &uncompressed,
 			 int               pedestal)
   {
-    const int lengthofadc = adc[0];
-    const int nblocks = adc[1];
+    ZeroSuppressedLayout const layout(adc.data());
+    const int nblocks = layout.NBlocks();
 
-    uncompressed.resize(lengthofadc);
-    for (int i = 0;i < lengthofadc; ++i){
-      uncompressed[i] = pedestal;
-    }
+    uncompressed.assign(layout.NTicks(), pedestal);
 
-    int zerosuppressedindex = nblocks*2 + 2;
+    std::size_t zerosuppressedindex = layout.DataStart();
 
     for(int i = 0; i < nblocks; ++i){ //loop over each nonzero block of the compressed vector
-
-      for(int j = 0; j < adc[2+nblocks+i]; ++j){//loop over each block size
-
-	//set uncompressed value
-	uncompressed[adc[2+i]+j] = adc[zerosuppressedindex];
-	zerosuppressedindex++;
-
-      }
+      const int blocksize = layout.BlockSize(i);
+      std::copy_n(adc.begin() + zerosuppressedindex, blocksize,
+        uncompressed.begin() + layout.BlockBegin(i));
+      zerosuppressedindex += blocksize;
     }
 
     return;
@@ -756,24 +1116,7 @@ namespace raw {
 		  std::vector<short>      &uncompressed,
 		  raw::Compress_t          compress)
   {
-    if(compress == raw::kHuffman) UncompressHuffman(adc, uncompressed);
-    else if(compress == raw::kZeroSuppression){
-      ZeroUnsuppression(adc, uncompressed);
-    }
-    else if(compress == raw::kZeroHuffman){
-      std::vector<short> tmp(2*adc[0]);
-      UncompressHuffman(adc, tmp);
-      ZeroUnsuppression(tmp, uncompressed);
-    }
-    else if(compress == raw::kNone){
-      for(unsigned int i = 0; i < adc.size(); ++i) uncompressed[i] = adc[i];
-    }
-    else {
-      throw cet::exception("raw")
-        << "raw::Uncompress() does not support compression #"
-        << ((int) compress);
-    }
-    return;
+    DecoderFor(compress).Decode(adc, uncompressed, 0);
   }
 
   //----------------------------------------------------------
@@ -783,24 +1126,85 @@ namespace raw {
 		  int               pedestal,
 		  raw::Compress_t          compress)
   {
-    if(compress == raw::kHuffman) UncompressHuffman(adc, uncompressed);
-    else if(compress == raw::kZeroSuppression){
-      ZeroUnsuppression(adc, uncompressed, pedestal);
-    }
-    else if(compress == raw::kZeroHuffman){
-      std::vector<short> tmp(2*adc[0]);
-      UncompressHuffman(adc, tmp);
-      ZeroUnsuppression(tmp, uncompressed, pedestal);
-    }
-    else if(compress == raw::kNone){
-      for(unsigned int i = 0; i < adc.size(); ++i) uncompressed[i] = adc[i];
-    }
-    else {
-      throw cet::exception("raw")
-        << "raw::Uncompress() does not support compression #"
-        << ((int) compress);
-    }
-    return;
+    DecoderFor(compress).Decode(adc, uncompressed, pedestal);
+  }
+
+  //----------------------------------------------------------
+  void Uncompress(const std::vector<short>& adc,
+                  std::vector<short>      &uncompressed,
+                  raw::Compress_t          compress,
+                  std::size_t              tickBegin,
+                  std::size_t              tickEnd,
+                  HuffmanIndex const*      index)
+  {
+    Uncompress(adc, uncompressed, 0, compress, tickBegin, tickEnd, index);
+  }
+
+  //----------------------------------------------------------
+  void Uncompress(const std::vector<short>& adc,
+                  std::vector<short>      &uncompressed,
+                  int                      pedestal,
+                  raw::Compress_t          compress,
+                  std::size_t              tickBegin,
+                  std::size_t              tickEnd,
+                  HuffmanIndex const*      index)
+  {
+    DecoderFor(compress).DecodeRange
+      (adc, uncompressed, pedestal, tickBegin, tickEnd, index);
+  }
+
+  //----------------------------------------------------------
+  // Built-in compression types are decoded a chunk at a time; the others
+  // through their codec.
+  void UncompressPedestalSubtracted(std::vector<short> const& adc,
+                                    float*                    out,
+                                    std::size_t               nTicks,
+                                    float                     pedestal,
+                                    raw::Compress_t           compress)
+  {
+    switch(compress){
+      case raw::kNone: {
+        std::size_t const n = std::min(adc.size(), nTicks);
+        subtractPedestal(adc.data(), n, pedestal, out);
+        std::fill(out + n, out + nTicks, 0.f);
+        break;
+      }
+      case raw::kHuffman: {
+        HuffmanStreamDecoder decoder(adc);
+        decodeSubtracted(decoder, nTicks, pedestal, out);
+        break;
+      }
+      case raw::kZeroSuppression:
+        ZeroUnsuppressionSubtracted(adc, out, nTicks, pedestal);
+        break;
+      case raw::kZeroHuffman:
+        ZeroHuffmanUnsuppressionSubtracted(adc, out, nTicks, pedestal);
+        break;
+      default: {
+        std::vector<short> uncompressed(nTicks);
+        DecoderFor(compress).Decode
+          (adc, uncompressed, static_cast<int>(std::lround(pedestal)));
+        std::size_t const n = std::min(uncompressed.size(), nTicks);
+        subtractPedestal(uncompressed.data(), n, pedestal, out);
+        std::fill(out + n, out + nTicks, 0.f);
+        break;
+      }
+    } // switch
+  } // UncompressPedestalSubtracted()
+
+  //----------------------------------------------------------
+  void UncompressPedestalSubtracted(raw::RawDigit const& digit, float* out)
+  {
+    UncompressPedestalSubtracted(digit.ADCs(), out, digit.Samples(),
+      digit.GetPedestal(), digit.Compression());
+  }
+
+  //----------------------------------------------------------
+  void UncompressPedestalSubtracted
+    (raw::RawDigit const& digit, std::vector<float>& out)
+  {
+    out.resize(digit.Samples());
+    UncompressPedestalSubtracted(digit, out.data());
   }
 
 
@@ -821,336 +1225,180 @@ namespace raw {
   // pad out the lowest bits in a word with 0's
   void CompressHuffman(std::vector<short> &adc)
   {
-    std::vector<short> const orig_adc(std::move(adc));
-
-    // diffs contains the difference between an element of adc and the previous
-    // one; the first entry is never used.
-    std::vector<short> diffs;
-    diffs.reserve(orig_adc.size());
-    std::adjacent_difference
-      (orig_adc.begin(), orig_adc.end(), std::back_inserter(diffs));
-
-    // prepare adc for the new data; we kind-of-expect the size,
-    // so we pre-allocate it; we might want to shrink-to-fit at the end
-    adc.clear();
-    adc.reserve(orig_adc.size());
-    // now loop over the diffs and do the Huffman encoding
-    adc.push_back(orig_adc.front());
-    unsigned int curb = 15U;
-
-    std::bitset<16> bset;
-    bset.set(15);
-
-    for(size_t i = 1U; i < diffs.size(); ++i){
-
-      switch (diffs[i]) {
-	// if the difference is 0, check to see what the next 3 differences are
-        case 0 : {
-	  if(i < diffs.size() - 3){
-	    // if next 3 are also 0, set the next bit to be 1
-	    if(diffs[i+1] == 0 && diffs[i+2] == 0 && diffs[i+3] == 0){
-	      if(curb > 0){
-		--curb;
-		bset.set(curb);
-		i += 3;
-		continue;
-	      }
-	      else{
-		adc.push_back(bset.to_ulong());
-
-		// reset the bitset to be ready for the next word
-		bset.reset();
-		bset.set(15);
-		bset.set(14); // account for the fact that this is a zero diff
-		curb = 14;
-		i += 3;
-		continue;
-	      } // end if curb is not big enough to put current difference in bset
-	    } // end if next 3 are also zero
-	    else{
-	      // 0 diff is encoded as 01, so move the current bit one to the right
-	      if(curb > 1){
-		curb -= 2;
-		bset.set(curb);
-		continue;
-	      } // end if the current bit is large enough to set this one
-	      else{
-		adc.push_back(bset.to_ulong());
-		// reset the bitset to be ready for the next word
-		bset.reset();
-		bset.set(15);
-		bset.set(13); // account for the fact that this is a zero diff
-		curb = 13;
-		continue;
-	      } // end if curb is not big enough to put current difference in bset
-	    } // end if next 3 are not also 0
-	  }// end if able to check next 3
-	  else{
-	    // 0 diff is encoded as 01, so move the current bit one to the right
-	    if(curb > 1){
-	      curb -= 2;
-	      bset.set(curb);
-		continue;
-	    } // end if the current bit is large enough to set this one
-	    else{
-	      adc.push_back(bset.to_ulong());
-	      // reset the bitset to be ready for the next word
-	      bset.reset();
-	      bset.set(15);
-	      bset.set(13); // account for the fact that this is a zero diff
-	      curb = 13;
-		continue;
-	    } // end if curb is not big enough to put current difference in bset
-	  }// end if not able to check the next 3
-	  break;
-	}// end if current difference is zero
-	case 1: {
-	  if(curb > 2){
-	    curb -= 3;
-	    bset.set(curb);
-	  }
-	  else{
-	    adc.push_back(bset.to_ulong());
-	    // reset the bitset to be ready for the next word
-	    bset.reset();
-	    bset.set(15);
-	    bset.set(12); // account for the fact that this is a +1 diff
-	    curb = 12;
-	  } // end if curb is not big enough to put current difference in bset
-	  break;
-	} // end if difference = 1
-        case -1: {
-	  if(curb > 3){
-	    curb -= 4;
-	    bset.set(curb);
-	  }
-	  else{
-	    adc.push_back(bset.to_ulong());
-	    // reset the bitset to be ready for the next word
-	    bset.reset();
-	    bset.set(15);
-	    bset.set(11); // account for the fact that this is a -1 diff
-	    curb = 11;
-	  } // end if curb is not big enough to put current difference in bset
-	  break;
-	}// end if difference = -1
-        case 2: {
-	  if(curb > 4){
-	    curb -= 5;
-	    bset.set(curb);
-	  }
-	  else{
-	    adc.push_back(bset.to_ulong());
-	    // reset the bitset to be ready for the next word
-	    bset.reset();
-	    bset.set(15);
-	    bset.set(10); // account for the fact that this is a +2 diff
-	    curb = 10;
-	  } // end if curb is not big enough to put current difference in bset
-	  break;
-	}// end if difference = 2
-        case -2: {
-	  if(curb > 5){
-	    curb -= 6;
-	    bset.set(curb);
-	  }
-	  else{
-	    adc.push_back(bset.to_ulong());
-	    // reset the bitset to be ready for the next word
-	    bset.reset();
-	    bset.set(15);
-	    bset.set(9); // account for the fact that this is a -2 diff
-	    curb = 9;
-	  } // end if curb is not big enough to put current difference in bset
-	  break;
-	}// end if difference = -2
-        case 3: {
-	  if(curb > 6){
-	    curb -= 7;
-	    bset.set(curb);
-	  }
-	  else{
-	    adc.push_back(bset.to_ulong());
-	    // reset the bitset to be ready for the next word
-	    bset.reset();
-	    bset.set(15);
-	    bset.set(8); // account for the fact that this is a +3 diff
-	    curb = 8;
-	  } // end if curb is not big enough to put current difference in bset
-	  break;
-	}// end if difference = 3
-        case -3: {
-	  if(curb > 7){
-	    curb -= 8;
-	    bset.set(curb);
-	  }
-	  else{
-	    adc.push_back(bset.to_ulong());
-	    // reset the bitset to be ready for the next word
-	    bset.reset();
-	    bset.set(15);
-	    bset.set(7); // account for the fact that this is a -3 diff
-	    curb = 7;
-	  } // end if curb is not big enough to put current difference in bset
-	  break;
-	}// end if difference = -3
-        default: {
-	  // if the difference is too large that we have to put the entire adc value in:
-	  // put the current value into the adc vec unless the current bit is 15, then there
-	  // were multiple large difference values in a row
-	  if(curb != 15){
-	    adc.push_back(bset.to_ulong());
-	  }
-
-	  bset.reset();
-	  bset.set(15);
-	  curb = 15;
-
-	  // put the current adcvalue in adc, with its bit 15 set to 0
-	  if(orig_adc[i] > 0) adc.push_back(orig_adc[i]);
-	  else{
-	    std::bitset<16> tbit(-orig_adc[i]);
-	    tbit.set(14);
-	    adc.push_back(tbit.to_ulong());
-	  }
-	  break;
-        } // if |difference| > 3
-      }// switch diff[i]
-    }// end loop over differences
-
-    //write out the last bitset
-    adc.push_back(bset.to_ulong());
-
-    // this would reduce global memory usage,
-    // at the cost of a new allocation and copy
-  //  adc.shrink_to_fit();
+    std::vector<short> compressed(HuffmanMaxCompressedSize(adc.size()));
+    compressed.resize(CompressHuffman(adc.data(), adc.size(), compressed.data()));
+    adc = std::move(compressed);
+  } // CompressHuffman()
+
+  //--------------------------------------------------------
+  // The last word is always written, even if empty.
+  std::size_t CompressHuffman(short const* adc,
+                              std::size_t  nTicks,
+                              short*       compressed)
+  {
+    if(nTicks == 0) return 0;
+
+    short* out = compressed;
+    *out++ = adc[0];
+    out = EncodeHuffmanDifferences(adc, nTicks, out, true);
 
+    return out - compressed;
   } // CompressHuffman()
+
   //--------------------------------------------------------
-  // need to decrement the bit you are looking at to determine the deltas as that is how
-  // the bits are set
+  // Each chunk starts on a new word with its first sample escaped, like a
+  // large difference would be; the decoder needs no special treatment.
+  void CompressHuffmanChunked(std::vector<short> &adc,
+                              std::size_t         chunkTicks,
+                              HuffmanIndex       &index)
+  {
+    if(chunkTicks == 0){
+      throw cet::exception("raw")
+        << "raw::CompressHuffmanChunked() requires chunks of at least one tick\n";
+    }
+
+    std::size_t const nTicks = adc.size();
+    std::size_t const nChunks = (nTicks + chunkTicks - 1) / chunkTicks;
+
+    // each chunk takes at most as many words as its ticks, plus the last word
+    std::vector<short> compressed(nTicks + 1);
+    index.clear();
+    if(nChunks > 1) index.reserve(nChunks - 1);
+
+    short* const start = compressed.data();
+    short* out = start;
+    for(std::size_t tick = 0; tick < nTicks; tick += chunkTicks){
+      std::size_t const n = std::min(chunkTicks, nTicks - tick);
+      if(tick == 0) *out++ = adc[0];
+      else{
+        index.push_back({ std::size_t(out - start), tick, adc[tick - 1] });
+        *out++ = HuffmanEscape(adc[tick]);
+      }
+      out = EncodeHuffmanDifferences(adc.data() + tick, n, out, tick + n == nTicks);
+    } // for chunks
+
+    compressed.resize(out - start);
+    adc = std::move(compressed);
+  } // CompressHuffmanChunked()
+
+  //--------------------------------------------------------
+  // The encoded words are decoded with a lookup table built once from the
+  // 15-bit payload (see HuffmanStreamDecoder above), so that all the deltas
+  // packed in a word are emitted without scanning it bit by bit.
+  // The output is truncated to the size of the uncompressed buffer.
   void UncompressHuffman(const std::vector<short>& adc,
-			 std::vector<short>      &uncompressed)
+                         std::vector<short>      &uncompressed)
+  {
+    HuffmanStreamDecoder(adc).Read(uncompressed.data(), uncompressed.size());
+  }
+
+  //--------------------------------------------------------
+  // The waveform is split in segments at the checkpoints, and the segments in
+  // nThreads contiguous groups; the calling thread and the helpers from the
+  // shared WorkerPool take the groups one at a time until none is left.
+  // Decoders never write past the end of the range they are asked for,
+  // so the threads do not share any part of the buffer.
+  void UncompressHuffman(const std::vector<short>& adc,
+                         std::vector<short>      &uncompressed,
+                         HuffmanIndex const&      index,
+                         unsigned int             nThreads)
   {
+    std::size_t const nTicks = uncompressed.size();
+    short* const out = uncompressed.data();
+
+    // segment 0 starts at the beginning, segment i at checkpoint i-1
+    std::size_t const nSegments = 1 + std::distance(index.begin(),
+      std::lower_bound(index.begin(), index.end(), nTicks,
+        [](HuffmanCheckpoint const& checkpoint, std::size_t tick)
+          { return checkpoint.tick < tick; }
+      ));
+    auto const segmentStart = [&index](std::size_t segment)
+      { return (segment == 0)? std::size_t(0): index[segment - 1].tick; };
+
+    // decodes the segments from first to last (excluded)
+    auto const decodeSegments
+      = [&adc, &index, out, nTicks, nSegments, segmentStart]
+      (std::size_t first, std::size_t last)
+      {
+        if(first >= last) return;
+        HuffmanStreamDecoder decoder = (first == 0)
+          ? HuffmanStreamDecoder(adc): HuffmanStreamDecoder(adc, index[first - 1]);
+        std::size_t const begin = segmentStart(first);
+        std::size_t const end = (last == nSegments)? nTicks: segmentStart(last);
+        decoder.Read(out + begin, end - begin);
+      };
+
+    if(nThreads == 0) nThreads = std::max(1U, std::thread::hardware_concurrency());
+    if(nThreads > nSegments) nThreads = nSegments;
+
+    if(nThreads <= 1){
+      decodeSegments(0, nSegments);
+      return;
+    }
 
-    //the first entry in adc is a data value by construction
-    uncompressed[0] = adc[0];
+    std::atomic<unsigned int> nextGroup{ 0 };
+    auto const work = [&nextGroup, nThreads, nSegments, &decodeSegments]()
+      {
+        while(true){
+          std::size_t const group = nextGroup++;
+          if(group >= nThreads) break;
+          decodeSegments(nSegments * group / nThreads,
+                         nSegments * (group + 1) / nThreads);
+        } // while
+      };
+    details::WorkerPool::Instance().Run(nThreads - 1, work);
 
-    unsigned int curu = 1;
-    short curADC = uncompressed[0];
+  } // UncompressHuffman()
+
+  //--------------------------------------------------------
+  // Checkpoints are taken at word boundaries, where the state of the decoder
+  // is only the value of the last sample decoded; the words are scanned
+  // with the decoding table, without writing any sample.
+  HuffmanIndex MakeHuffmanIndex(std::vector<short> const& adc,
+                                std::size_t               interval)
+  {
+    HuffmanIndex index;
+    if(adc.empty() || (interval == 0)) return index;
+    index.reserve(adc.size() / interval);
+
+    HuffmanDecodeTable const& table = huffmanDecodeTable();
+
+    //the first entry in adc is a data value by construction
+    std::size_t tick = 1;
+    short curADC = adc[0];
 
-    // loop over the entries in adc and uncompress them according to the
-    // encoding scheme above the CompressHuffman method
-    for(unsigned int i = 1; i < adc.size() && curu < uncompressed.size(); ++i){
+    for(std::size_t i = 1; i < adc.size(); ++i){
 
-      std::bitset<16> bset(adc[i]);
+      if(i % interval == 0) index.push_back({ i, tick, curADC });
 
-      int numu = 0;
+      unsigned int const word = static_cast<unsigned short>(adc[i]);
 
       //check the 15 bit to see if this entry is a full data value or not
-      if( !bset.test(15) ){
-	curADC = adc[i];
-	if(bset.test(14)){
-	  bset.set(14, false);
-	  curADC = -1*bset.to_ulong();
-	}
-	uncompressed[curu] = curADC;
-
-	++curu;
+      if( !(word & 0x8000U) ){
+        curADC = (word & 0x4000U)? short(-short(word & 0x3fffU)): adc[i];
+        ++tick;
+        continue;
       }
-      else{
 
-	int  b       = 14;
-	int  lowestb = 0;
-
-	// ignore any padding with zeros in the lower order bits
-	while( !bset.test(lowestb) && lowestb < 15) ++lowestb;
-
-	if(lowestb > 14){
-	  mf::LogWarning("raw.cxx") << "encoded entry has no set bits!!! "
-				    << i << " "
-				    << bset.to_string< char,std::char_traits<char>,std::allocator<char> >();
-	  continue;
-	}
-
-	while( b >= lowestb){
-
-	  // count the zeros between the current bit and the next on bit
-	  int zerocnt = 0;
-	  while( !bset.test(b-zerocnt) && b-zerocnt > lowestb) ++zerocnt;
-
-	  b -= zerocnt;
-
-	  if(zerocnt == 0){
-	    for(int s = 0; s < 4; ++s){
-	      uncompressed[curu] = curADC;
-	      ++curu;
-	      ++numu;
-	      if(curu > uncompressed.size()-1) break;
-	    }
-	    --b;
-	  }
-	  else if(zerocnt == 1){
-	    uncompressed[curu] = curADC;
-	    ++curu;
-	    ++numu;
-	    --b;
-	  }
-	  else if(zerocnt == 2){
-	    curADC += 1;
-	    uncompressed[curu] = curADC;
-	    ++curu;
-	    ++numu;
-	    --b;
-	  }
-	  else if(zerocnt == 3){
-	    curADC -= 1;
-	    uncompressed[curu] = curADC;
-	    ++curu;
-	    ++numu;
-	    --b;
-	  }
-	  else if(zerocnt == 4){
-	    curADC += 2;
-	    uncompressed[curu] = curADC;
-	    ++curu;
-	    ++numu;
-	    --b;
-	  }
-	  else if(zerocnt == 5){
-	    curADC -= 2;
-	    uncompressed[curu] = curADC;
-	    ++curu;
-	    ++numu;
-	    --b;
-	  }
-	  else if(zerocnt == 6){
-	    curADC += 3;
-	    uncompressed[curu] = curADC;
-	    ++curu;
-	    ++numu;
-	    --b;
-	  }
-	  else if(zerocnt == 7){
-	    curADC -= 3;
-	    uncompressed[curu] = curADC;
-	    ++curu;
-	    ++numu;
-	    --b;
-	  }
-
-	  if(curu > uncompressed.size() - 1) break;
-
-	}// end loop over bits
-
-	if(curu > uncompressed.size() - 1) break;
-
-      }// end if this entry in the vector is encoded
+      std::uint64_t const entry = table.entries[word & 0x7fffU];
+      tick += HuffmanDecodeTable::nTicks(entry);
+      std::uint64_t codes = HuffmanDecodeTable::codes(entry);
+      for(unsigned int c = HuffmanDecodeTable::nCodes(entry); c > 0; --c, codes >>= 3)
+        curADC += HuffmanDecodeTable::Delta[codes & 0x7U];
 
     }// end loop over entries in adc
 
-    return;
-  }
+    return index;
+  } // MakeHuffmanIndex()
+
+  //--------------------------------------------------------
+  void CompressHuffman(std::vector<short> &adc,
+                       HuffmanIndex       &index,
+                       std::size_t         interval)
+  {
+    CompressHuffman(adc);
+    index = MakeHuffmanIndex(adc, interval);
+  } // CompressHuffman()
 
   //--------------------------------------------------------
   // need to decrement the bit you are looking at to determine the deltas as that is how
@@ -1159,18 +1407,57 @@ namespace raw {
 			 const int pedestal,
 			 bool fADCStickyCodeFeature){
 
-    int adc_return_value = std::abs(adc_value - pedestal);
+    // if DUNE 35t ADC sticky code feature is enabled in simulation, skip over
+    // ADC codes with LSBs of 0x00 or 0x3f within one MSB cell (64 ADC counts)
+    // of the pedestal value
+    return StickyCodeMagnitude(adc_value, pedestal, fADCStickyCodeFeature);
+  }
 
-      if(!fADCStickyCodeFeature){
-	return adc_return_value;
-      }
-     // if DUNE 35t ADC sticky code feature is enabled in simulation, skip over ADC codes with LSBs of 0x00 or 0x3f
-      unsigned int sixlsbs = adc_value & onemask;
+  //--------------------------------------------------------
+  void ADCStickyCodeMagnitudes(short const* adc,
+                               std::size_t  nTicks,
+                               int          pedestal,
+                               bool         fADCStickyCodeFeature,
+                               int*         magnitudes)
+  {
+    if(fADCStickyCodeFeature){
+      for(std::size_t i = 0; i < nTicks; ++i)
+        magnitudes[i] = StickyCodeMagnitude(adc[i], pedestal, true);
+    }
+    else{
+      for(std::size_t i = 0; i < nTicks; ++i)
+        magnitudes[i] = std::abs(adc[i] - pedestal);
+    }
+  } // ADCStickyCodeMagnitudes()
 
-      if((sixlsbs==onemask || sixlsbs==0) && std::abs(adc_value - pedestal) < 64){
-	adc_return_value = 0; //set current adc value to zero if its LSBs are at sticky values and if it is within one MSB cell (64 ADC counts) of the pedestal value
-      }
-      return adc_return_value;
-  }
+  //--------------------------------------------------------
+  std::vector<int> ADCStickyCodeMagnitudes(std::vector<short> const& adc,
+                                           int  pedestal,
+                                           bool fADCStickyCodeFeature)
+  {
+    std::vector<int> magnitudes(adc.size());
+    ADCStickyCodeMagnitudes
+      (adc.data(), adc.size(), pedestal, fADCStickyCodeFeature, magnitudes.data());
+    return magnitudes;
+  } // ADCStickyCodeMagnitudes()
+
+  //--------------------------------------------------------
+  ADCStickyCodeTable::ADCStickyCodeTable(int pedestal, bool fADCStickyCodeFeature)
+    : fPedestal(pedestal)
+    , fADCStickyCodeFeature(fADCStickyCodeFeature)
+    , fMagnitudes(NADCValues)
+  {
+    for(int adc = 0; adc < NADCValues; ++adc){
+      fMagnitudes[adc]
+        = StickyCodeMagnitude(short(adc), fPedestal, fADCStickyCodeFeature);
+    }
+  } // ADCStickyCodeTable::ADCStickyCodeTable()
+
+  //--------------------------------------------------------
+  void ADCStickyCodeTable::Magnitudes
+    (short const* adc, std::size_t nTicks, int* magnitudes) const
+  {
+    for(std::size_t i = 0; i < nTicks; ++i) magnitudes[i] = (*this)(adc[i]);
+  } // ADCStickyCodeTable::Magnitudes()
 
 }
@@ -6,6 +6,8 @@
 #ifndef RAWDATA_RAW_H
 #define RAWDATA_RAW_H
 
+#include <cstddef> // std::size_t
+#include <limits>
 #include <vector>
 #include <boost/circular_buffer.hpp>
 #include "larcoreobj/SimpleTypesAndConstants/RawTypes.h"
@@ -18,8 +20,9 @@ namespace raw{
    * @param uncompressed buffer to be filled with uncompressed data
    * @param compress type of compression in the adc buffer
    *
-   * This function dispatches the uncompression to the correct uncompress
-   * function according to compression type in compress.
+   * This function dispatches the uncompression to the codec registered for
+   * the compression type in compress (see raw::CodecRegistry in Codec.h),
+   * and throws cet::exception if there is none.
    *
    * The uncompressed buffer *must* be already allocated with enough space
    * to store the full inflated adc data. Uncompressing raw::RawDigit can
@@ -39,6 +42,90 @@ namespace raw{
 		  int       pedestal,
                   raw::Compress_t          compress);
 
+  /// A point of Huffman-encoded data where decoding can start
+  struct HuffmanCheckpoint {
+    std::size_t word; ///< index of the encoded word decoding starts from
+    std::size_t tick; ///< index of the first sample decoded from that word
+    short       adc;  ///< value of the sample before that one
+  };
+
+  /// Checkpoints of Huffman-encoded data, sorted by tick
+  using HuffmanIndex = std::vector<HuffmanCheckpoint>;
+
+  /**
+   * @brief Uncompresses a window of ticks of a raw data buffer
+   * @param adc compressed buffer
+   * @param uncompressed filled with the samples from tickBegin to tickEnd
+   * @param compress type of compression in the adc buffer
+   * @param tickBegin first tick of the window
+   * @param tickEnd tick after the last one of the window
+   * @param index checkpoints of the Huffman-encoded adc (optional)
+   *
+   * The uncompressed buffer is resized to the ticks of the window within the
+   * waveform, which may be fewer than `tickEnd - tickBegin` for windows
+   * extending past its end. The content is the same as the one of that
+   * range of the full uncompressed waveform.
+   *
+   * Zero-suppressed data is located by a binary search of the block
+   * table, so that the cost depends on the size of the window rather than
+   * on the one of the waveform. Huffman-encoded data must be decoded from
+   * its start, unless an index of the data is specified (see
+   * MakeHuffmanIndex()): decoding then starts from the last checkpoint
+   * before the window. With kZeroHuffman the block table is still decoded
+   * from the start, and the index is used to reach the samples.
+   */
+  void Uncompress(const std::vector<short>& adc,
+                  std::vector<short>      &uncompressed,
+                  raw::Compress_t          compress,
+                  std::size_t              tickBegin,
+                  std::size_t              tickEnd,
+                  HuffmanIndex const*      index = nullptr);
+
+  /// Like the other windowed Uncompress(), with pedestal for suppressed ticks
+  void Uncompress(const std::vector<short>& adc,
+                  std::vector<short>      &uncompressed,
+                  int                      pedestal,
+                  raw::Compress_t          compress,
+                  std::size_t              tickBegin,
+                  std::size_t              tickEnd,
+                  HuffmanIndex const*      index = nullptr);
+
+  /**
+   * @brief Uncompresses a raw data buffer into pedestal-subtracted values
+   * @param adc compressed buffer
+   * @param out buffer for nTicks values
+   * @param nTicks number of values to be written
+   * @param pedestal pedestal subtracted from each sample
+   * @param compress type of compression in the adc buffer
+   * @throw cet::exception if there is no codec for compress
+   *
+   * The result is the same as uncompressing the data with Uncompress() and
+   * then subtracting the pedestal from each sample, without an intermediate
+   * buffer for the whole waveform: the samples are decoded a few hundred at
+   * a time and converted while they are still in cache. The conversion is
+   * vectorized with AVX2 or SSE2 instructions, depending on the compilation
+   * target.
+   * Suppressed samples are 0 (they are at the pedestal), and so are the
+   * values beyond the end of the data. Compression types other than the
+   * built-in ones are uncompressed by their codec into a temporary buffer.
+   */
+  void UncompressPedestalSubtracted(std::vector<short> const& adc,
+                                    float*                    out,
+                                    std::size_t               nTicks,
+                                    float                     pedestal,
+                                    raw::Compress_t           compress);
+
+  class RawDigit;
+
+  /// Writes the `digit.Samples()` pedestal-subtracted samples of digit into
+  /// out (see the other UncompressPedestalSubtracted())
+  void UncompressPedestalSubtracted(raw::RawDigit const& digit, float* out);
+
+  /// Resizes out to the samples of digit, and fills it with their
+  /// pedestal-subtracted values
+  void UncompressPedestalSubtracted
+    (raw::RawDigit const& digit, std::vector<float>& out);
+
   void Compress(std::vector<short> &adc,
                 raw::Compress_t     compress,
                 int                &nearestneighbor);
@@ -58,8 +145,9 @@ namespace raw{
    * @param adc buffer with uncompressed data
    * @param compress type of compression to be applied
    *
-   * This function dispatches the compression to the function appropriate
-   * for the specified compression type.
+   * This function dispatches the compression to the codec registered for
+   * the specified compression type (see raw::CodecRegistry in Codec.h);
+   * the data is left uncompressed if there is none.
    * The resulting compressed data replaces the input buffer content, which is lost.
    * Compression is expected to reduce the size of the data, so that there is
    * in principle no need for reallocation of the input buffer, adc, to store
@@ -85,11 +173,117 @@ namespace raw{
                 int &nearestneighbor,
 		bool fADCStickyCodeFeature=false);
 
+  struct CodecParameters;
+
+  /**
+   * @brief Compresses a raw data buffer with the specified settings
+   * @param adc buffer with uncompressed data, replaced by the compressed one
+   * @param compress type of compression to be applied
+   * @param params compression settings (see raw::CodecParameters in Codec.h)
+   *
+   * This is the most general form of the other Compress() functions.
+   * If `params.statistics` is set, the record it points to is reset and
+   * filled with the statistics of this compression.
+   */
+  void Compress(std::vector<short>&    adc,
+                raw::Compress_t        compress,
+                CodecParameters const& params);
+
   void CompressHuffman(std::vector<short> &adc);
 
+  /// Maximum number of words raw::CompressHuffman() writes for nTicks samples
+  constexpr std::size_t HuffmanMaxCompressedSize(std::size_t nTicks)
+    { return nTicks + 1; }
+
+  /**
+   * @brief Huffman-compresses ADC samples into a caller-provided buffer
+   * @param adc pointer to the first of the uncompressed samples
+   * @param nTicks number of uncompressed samples
+   * @param compressed buffer to write the compressed data into
+   * @return the number of words written into compressed
+   *
+   * The output is the same as the one of CompressHuffman(std::vector<short>&),
+   * but no memory is allocated: the buffer compressed must have room for
+   * at least `HuffmanMaxCompressedSize(nTicks)` words, and it must not
+   * overlap with the input.
+   */
+  std::size_t CompressHuffman(short const* adc,
+                              std::size_t  nTicks,
+                              short*       compressed);
+
   void UncompressHuffman(const std::vector<short>& adc,
                          std::vector<short>      &uncompressed);
 
+  /**
+   * @brief Decodes Huffman-encoded data with many threads
+   * @param adc Huffman-encoded data
+   * @param uncompressed buffer to be filled with uncompressed data
+   * @param index checkpoints of adc
+   * @param nThreads number of threads to use
+   *                 (default: only the calling one; 0: one per hardware thread)
+   *
+   * The result is the same as the one of `UncompressHuffman(adc, uncompressed)`.
+   * Each thread decodes the data between some of the checkpoints of the index,
+   * from either MakeHuffmanIndex() or CompressHuffmanChunked(); no more
+   * threads than checkpoints are used, and the calling thread is one of them.
+   * The other threads are taken from the ones kept by the library for
+   * CompressAll() and UncompressAll(), which are started on first use.
+   * When the waveforms are already decoded in parallel (e.g. by many art
+   * modules), more threads may oversubscribe the processor.
+   */
+  void UncompressHuffman(const std::vector<short>& adc,
+                         std::vector<short>      &uncompressed,
+                         HuffmanIndex const&      index,
+                         unsigned int             nThreads = 1);
+
+  /**
+   * @brief Returns checkpoints of Huffman-encoded data
+   * @param adc Huffman-encoded data (see CompressHuffman())
+   * @param interval number of encoded words between checkpoints
+   * @return the checkpoints, one every interval words
+   *
+   * The index allows the windowed Uncompress() to start decoding close to
+   * the window. It is not part of the encoded data, which is unchanged, and
+   * it must be kept together with it by the caller.
+   * A larger interval makes a smaller index and a slower seek.
+   */
+  HuffmanIndex MakeHuffmanIndex(std::vector<short> const& adc,
+                                std::size_t               interval);
+
+  /// Huffman-compresses adc and fills index with its checkpoints,
+  /// one every interval encoded words (see MakeHuffmanIndex())
+  void CompressHuffman(std::vector<short> &adc,
+                       HuffmanIndex       &index,
+                       std::size_t         interval);
+
+  /**
+   * @brief Huffman-compresses adc in chunks which can be decoded independently
+   * @param adc buffer with uncompressed data, replaced by the compressed one
+   * @param chunkTicks number of ticks in each chunk
+   * @param index filled with a checkpoint at the start of each chunk but the
+   *              first one
+   * @throw cet::exception if chunkTicks is 0
+   *
+   * The first sample of each chunk is written as an absolute value rather
+   * than as a difference from the previous one, on a new word, so that a
+   * chunk can be decoded without any of the previous ones. The result is
+   * still plain Huffman-encoded data (raw::kHuffman), which any decoder
+   * reads, a few words longer than the one of CompressHuffman().
+   * As with any value escaped from Huffman coding, the first sample of each
+   * chunk but the first one must be within -16383 and 16383.
+   *
+   * The index allows decoding the chunks in parallel with
+   * `UncompressHuffman(adc, uncompressed, index, nThreads)`.
+   */
+  void CompressHuffmanChunked(std::vector<short> &adc,
+                              std::size_t         chunkTicks,
+                              HuffmanIndex       &index);
+
+  class ZeroSuppressor;
+
+  /// Returns the raw::ZeroSuppressor used by ZeroSuppression() in this thread
+  ZeroSuppressor& ThreadLocalZeroSuppressor();
+
   void ZeroSuppression(std::vector<short> &adc,
                        unsigned int       &zerothreshold,
                        int                &nearestneighbor);
@@ -117,6 +311,45 @@ namespace raw{
 		       bool fADCStickyCodeFeature=false);
 
 
+  /**
+   * @name Layouts of zero-suppressed data
+   *
+   * Zero suppression writes waveforms up to ZeroSuppressionMaxShortTicks
+   * ticks with 16-bit tick and block counts:
+   *
+   *     [ nTicks, nBlocks, begin[0], ..., begin[n-1], size[0], ..., size[n-1], data... ]
+   *
+   * Longer waveforms, up to ZeroSuppressionMaxLongTicks ticks, start with
+   * the ZeroSuppressionLongMarker word and the version of the layout, and
+   * then each count is stored in two words, its lower and upper 14 bits:
+   *
+   *     [ marker, version, nTicks (2), nBlocks (2), begin[0] (2), ..., begin[n-1] (2),
+   *       size[0] (2), ..., size[n-1] (2), data... ]
+   *
+   * The counts never use more than 14 bits of a word, so that they are
+   * preserved by Huffman coding (see CompressHuffman()), which does not
+   * preserve values from 16384 on. For that reason, waveforms longer than
+   * ZeroHuffmanMaxShortTicks ticks are written with the long layout when
+   * they are going to be Huffman-coded (kZeroHuffman).
+   * ZeroUnsuppression() reads both layouts.
+   */
+  /// @{
+  /// Longest waveform written with the 16-bit layout
+  constexpr std::size_t ZeroSuppressionMaxShortTicks = 32767;
+
+  /// Longest waveform written with the 16-bit layout for Huffman coding
+  constexpr std::size_t ZeroHuffmanMaxShortTicks = 16383;
+
+  /// Longest waveform that can be zero-suppressed
+  constexpr std::size_t ZeroSuppressionMaxLongTicks = (std::size_t(1) << 28) - 1;
+
+  /// First word of zero-suppressed data with the long layout
+  constexpr short ZeroSuppressionLongMarker = std::numeric_limits<short>::min();
+
+  /// Version of the long layout
+  constexpr short ZeroSuppressionLongVersion = 1;
+  /// @}
+
   void ZeroUnsuppression(const std::vector<short>& adc,
                          std::vector<short>      &uncompressed);
 
@@ -130,6 +363,71 @@ namespace raw{
 			 const int   pedestal,
 			 bool fADCStickyCodeFeature);
 
+  /**
+   * @brief Computes raw::ADCStickyCodeCheck() for all the samples of a waveform
+   * @param adc the samples
+   * @param nTicks number of samples
+   * @param pedestal the pedestal of the waveform
+   * @param fADCStickyCodeFeature whether to ignore ADC sticky codes
+   * @param magnitudes filled with the effective magnitude of each sample
+   *
+   * The classification has no branches, so that the compiler can vectorize
+   * the loop over the samples.
+   */
+  void ADCStickyCodeMagnitudes(short const* adc,
+                               std::size_t  nTicks,
+                               int          pedestal,
+                               bool         fADCStickyCodeFeature,
+                               int*         magnitudes);
+
+  /// Returns raw::ADCStickyCodeCheck() of all the samples of a waveform
+  std::vector<int> ADCStickyCodeMagnitudes(std::vector<short> const& adc,
+                                           int  pedestal,
+                                           bool fADCStickyCodeFeature);
+
+  /**
+   * @brief Table of the results of raw::ADCStickyCodeCheck() for a pedestal
+   *
+   * The effective magnitudes of all the values of a 12-bit ADC are computed
+   * once, and then looked up; other values are computed on each call.
+   * A table is worth when many samples share the same pedestal, for example
+   * in all the channels of a plane.
+   */
+  class ADCStickyCodeTable {
+
+  public:
+
+    /// Number of ADC values in the table
+    static constexpr int NADCValues = 4096;
+
+    /// Constructor: computes the table for the pedestal
+    ADCStickyCodeTable(int pedestal, bool fADCStickyCodeFeature);
+
+    /// Returns the pedestal of the table
+    int Pedestal() const { return fPedestal; }
+
+    /// Returns whether sticky codes are ignored
+    bool StickyCodeFeature() const { return fADCStickyCodeFeature; }
+
+    /// Returns `raw::ADCStickyCodeCheck(adc, Pedestal(), StickyCodeFeature())`
+    int operator() (short adc) const
+      {
+        return (static_cast<unsigned short>(adc) < NADCValues)
+          ? fMagnitudes[adc]
+          : ADCStickyCodeCheck(adc, fPedestal, fADCStickyCodeFeature);
+      }
+
+    /// Fills magnitudes with the effective magnitude of each of the samples
+    void Magnitudes(short const* adc, std::size_t nTicks, int* magnitudes) const;
+
+  private:
+
+    int  fPedestal;              ///< pedestal the magnitudes are relative to
+    bool fADCStickyCodeFeature;  ///< whether sticky codes are ignored
+    std::vector<int> fMagnitudes; ///< magnitude of each 12-bit ADC value
+
+  }; // class ADCStickyCodeTable
+
 } // namespace raw
 
 #endif // RAWDATA_RAW_H
@@ -996,9 +996,26 @@ class sparse_vector {
 
 
   //@{
-  /// Performs internal optimization, returns whether the object was changed
+  /**
+   * @brief Performs internal optimization, returns whether the object changed
+   * @param gap_threshold ranges separated by fewer void elements are merged
+   *                      (default: `min_gap()`)
+   * @return whether any range was merged
+   *
+   * Ranges closer to each other than `gap_threshold` are merged into a single
+   * range, and the elements of the gaps in between, which were void, are
+   * set to `value_zero`. The content of the vector as seen by `operator[]`
+   * or by iterators does not change, but there are fewer ranges, each one
+   * with its own allocated data. The ranges are processed in a single pass,
+   * each merged range being allocated only once.
+   *
+   * @note The elements of the merged gaps are not void any more: `is_void()`
+   *       is `false` for them, `count()` includes them, they are part of the
+   *       ranges from `get_ranges()`, and `combine_range()` does not replace
+   *       them with its baseline, treating them as any element of value zero.
+   */
   bool optimize() { return optimize(min_gap()); }
-  bool optimize(size_t) { return false; /* no optimization implemented yet */ }
+  bool optimize(size_t gap_threshold);
   //@}
 
 
@@ -1221,7 +1238,7 @@ class lar::sparse_vector<T>::datarange_t: public range_t<size_type> {
 
   /// Constructor: offset and data as a vector (which will be used directly)
   datarange_t(size_type offset, vector_t&& data):
-    base_t(offset, offset + data.size()), values(data)
+    base_t(offset, offset + data.size()), values(std::move(data))
     {}
 
 
@@ -2143,6 +2160,42 @@ bool lar::sparse_vector<T>::is_valid() const {
 } // lar::sparse_vector<T>::is_valid()
 
 
+template <typename T>
+bool lar::sparse_vector<T>::optimize(size_t gap_threshold) {
+  range_iterator iDest = ranges.begin(), iSrc = ranges.begin(),
+    rend = ranges.end();
+  while (iSrc != rend) {
+    // find all the ranges to be merged into iSrc: [ iSrc, iGroupEnd [
+    range_iterator iGroupEnd = iSrc + 1;
+    while (iGroupEnd != rend) {
+      size_type const gap
+        = iGroupEnd->begin_index() - (iGroupEnd - 1)->end_index();
+      if (gap >= gap_threshold) break;
+      ++iGroupEnd;
+    } // while
+
+    if (iGroupEnd - iSrc > 1) {
+      // allocate the merged range once, with the gaps set to zero
+      size_type const offset = iSrc->begin_index();
+      vector_t data((iGroupEnd - 1)->end_index() - offset, value_zero);
+      for (range_iterator iRange = iSrc; iRange != iGroupEnd; ++iRange) {
+        std::copy(iRange->begin(), iRange->end(),
+          data.begin() + (iRange->begin_index() - offset));
+      }
+      *iDest = datarange_t(offset, std::move(data));
+    }
+    else if (iDest != iSrc) *iDest = std::move(*iSrc);
+
+    ++iDest;
+    iSrc = iGroupEnd;
+  } // while
+
+  if (iDest == rend) return false;
+  ranges.erase(iDest, rend);
+  return true;
+} // lar::sparse_vector<T>::optimize()
+
+
 
 // --- private methods
 
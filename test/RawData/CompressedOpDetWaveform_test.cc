@@ -0,0 +1,211 @@
+/**
+ * @file    CompressedOpDetWaveform_test.cc
+ * @brief   Test on raw::CompressedOpDetWaveform objects
+ * @date    20261017
+ * @version 1.0
+ *
+ * This test compresses optical waveforms with each compression type and
+ * verifies that they are restored, exactly or, with zero suppression, with
+ * the samples close to the baseline at the baseline. The uncompression on
+ * demand of raw::CompressedOpDetWaveformView is also tested.
+ *
+ * See http://www.boost.org/libs/test for the Boost test library home page.
+ *
+ * Timing:
+ * version 1.0: <1" (debug mode)
+ */
+
+// C/C++ standard library
+#include <cstdlib> // std::abs()
+#include <deque>
+#include <thread>
+#include <vector>
+
+
+// Boost libraries
+/*
+ * Boost Magic: define the name of the module;
+ * and do that before the inclusion of Boost unit test headers
+ * because it will change what they provide.
+ * Among the those, there is a main() function and some wrapping catching
+ * unhandled exceptions and considering them test failures, and probably more.
+ * This also makes fairly complicate to receive parameters from the command line
+ * (for example, a random seed).
+ */
+#define BOOST_TEST_MODULE ( compressedopdetwaveform_test )
+#include "cetlib/quiet_unit_test.hpp" // BOOST_AUTO_TEST_CASE()
+#include <boost/test/test_tools.hpp> // BOOST_CHECK()
+
+// LArSoft libraries
+#include "larcoreobj/SimpleTypesAndConstants/RawTypes.h" // raw::Compress_t
+#include "lardataobj/RawData/OpDetWaveform.h"
+#include "lardataobj/RawData/CompressedOpDetWaveform.h"
+#include "lardataobj/RawData/Codec.h" // raw::CodecRegistry
+
+// framework libraries
+#include "cetlib_except/exception.h"
+
+
+
+//------------------------------------------------------------------------------
+//--- Test code
+//
+
+constexpr short Baseline = 2000;
+
+
+/// Returns a waveform at baseline with small noise and a few negative pulses
+raw::OpDetWaveform MakeTestWaveform(size_t nSamples) {
+
+  raw::OpDetWaveform waveform(1234.5, 17, nSamples);
+  for (size_t i = 0; i < nSamples; ++i) {
+    short sample = Baseline + short(i % 5) - 2; // noise within 2 counts
+    size_t const fromPulse = i % 500;
+    if (fromPulse >= 100 && fromPulse < 120)
+      sample -= 400 - 40 * std::abs(int(fromPulse) - 110);
+    waveform.push_back(sample);
+  }
+  return waveform;
+
+} // MakeTestWaveform()
+
+
+void CheckHeader
+  (raw::OpDetWaveform const& waveform, raw::OpDetWaveform const& expected)
+{
+  BOOST_CHECK_EQUAL(waveform.ChannelNumber(), expected.ChannelNumber());
+  BOOST_CHECK_EQUAL(waveform.TimeStamp(), expected.TimeStamp());
+  BOOST_CHECK_EQUAL(waveform.size(), expected.size());
+} // CheckHeader()
+
+
+void CompressedOpDetWaveformTestLossless() {
+
+  raw::OpDetWaveform const waveform = MakeTestWaveform(3000);
+
+  for (raw::Compress_t compress: { raw::kNone, raw::kHuffman }) {
+    raw::CompressedOpDetWaveform const compressed
+      (waveform, compress, Baseline, 10);
+    BOOST_CHECK_EQUAL(compressed.ChannelNumber(), waveform.ChannelNumber());
+    BOOST_CHECK_EQUAL(compressed.TimeStamp(), waveform.TimeStamp());
+    BOOST_CHECK_EQUAL(compressed.Samples(), waveform.size());
+    BOOST_CHECK_EQUAL(compressed.Baseline(), Baseline);
+    BOOST_CHECK_EQUAL(compressed.Compression(), compress);
+    BOOST_CHECK_EQUAL(compressed.NADC(), compressed.ADCs().size());
+    if (compress == raw::kHuffman)
+      BOOST_CHECK_LT(compressed.NADC(), waveform.size() / 2);
+
+    raw::OpDetWaveform const restored = compressed.Uncompress();
+    CheckHeader(restored, waveform);
+    BOOST_CHECK(restored == waveform);
+  } // for
+
+} // CompressedOpDetWaveformTestLossless()
+
+
+void CompressedOpDetWaveformTestZeroSuppression() {
+
+  raw::OpDetWaveform const waveform = MakeTestWaveform(3000);
+
+  for (raw::Compress_t compress: { raw::kZeroSuppression, raw::kZeroHuffman }) {
+    // the baseline is estimated from the waveform
+    raw::CodecParameters params;
+    params.zerothreshold = 10;
+    params.nearestneighbor = 2;
+    raw::CompressedOpDetWaveform const compressed(waveform, compress, params);
+    BOOST_CHECK_EQUAL(compressed.Baseline(), Baseline);
+    BOOST_CHECK_LT(compressed.NADC(), waveform.size() / 5);
+
+    raw::OpDetWaveform const restored = compressed.Uncompress();
+    CheckHeader(restored, waveform);
+    for (size_t i = 0; i < waveform.size(); ++i) {
+      // the pulses (below baseline) are kept, and the noise is suppressed
+      if (std::abs(waveform[i] - Baseline) > 10)
+        BOOST_CHECK_EQUAL(restored[i], waveform[i]);
+      else if (restored[i] != waveform[i])
+        BOOST_CHECK_EQUAL(restored[i], Baseline);
+    }
+  } // for
+
+} // CompressedOpDetWaveformTestZeroSuppression()
+
+
+void CompressedOpDetWaveformTestSpecialCases() {
+
+  // empty waveform
+  raw::OpDetWaveform const empty(10.0, 3);
+  raw::CompressedOpDetWaveform const compressedEmpty(empty, raw::kZeroHuffman);
+  BOOST_CHECK_EQUAL(compressedEmpty.Samples(), 0U);
+  BOOST_CHECK_EQUAL(compressedEmpty.Baseline(), 0);
+  raw::OpDetWaveform const restoredEmpty = compressedEmpty.Uncompress();
+  CheckHeader(restoredEmpty, empty);
+
+  // default-constructed
+  raw::CompressedOpDetWaveform const defaultWaveform;
+  BOOST_CHECK_EQUAL(defaultWaveform.Samples(), 0U);
+  BOOST_CHECK(defaultWaveform.Uncompress().empty());
+
+  // baseline estimation
+  BOOST_CHECK_EQUAL(raw::CompressedOpDetWaveform::EstimateBaseline
+    ({ 5, 100, 5, 4, 6, -300, 5 }), 5);
+  BOOST_CHECK_EQUAL(raw::CompressedOpDetWaveform::EstimateBaseline({}), 0);
+
+  // unsupported compression
+  if (!raw::CodecRegistry::Instance().Find(raw::kDynamicDec)) {
+    BOOST_CHECK_THROW(raw::CompressedOpDetWaveform
+      (MakeTestWaveform(100), raw::kDynamicDec), cet::exception);
+  }
+
+} // CompressedOpDetWaveformTestSpecialCases()
+
+
+void CompressedOpDetWaveformTestView() {
+
+  std::vector<raw::CompressedOpDetWaveform> compressed;
+  raw::OpDetWaveform const waveform = MakeTestWaveform(2000);
+  for (raw::Compress_t compress: { raw::kNone, raw::kHuffman, raw::kZeroHuffman })
+    compressed.emplace_back(waveform, compress, Baseline, 10, 2);
+
+  std::deque<raw::CompressedOpDetWaveformView> const views
+    (compressed.begin(), compressed.end());
+  for (size_t i = 0; i < compressed.size(); ++i) {
+    raw::CompressedOpDetWaveformView const& view = views[i];
+    BOOST_CHECK_EQUAL(&view.Compressed(), &compressed[i]);
+    BOOST_CHECK(!view.IsUncompressed());
+
+    // many threads asking at the same time get the same waveform
+    std::vector<raw::OpDetWaveform const*> results(8, nullptr);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < results.size(); ++t)
+      threads.emplace_back([&view, &results, t](){ results[t] = &view.Waveform(); });
+    for (std::thread& thread: threads) thread.join();
+    BOOST_CHECK(view.IsUncompressed());
+    for (raw::OpDetWaveform const* result: results)
+      BOOST_CHECK_EQUAL(result, &view.Waveform());
+
+    CheckHeader(view.Waveform(), waveform);
+    BOOST_CHECK(view.Waveform() == compressed[i].Uncompress());
+  } // for
+
+} // CompressedOpDetWaveformTestView()
+
+
+//------------------------------------------------------------------------------
+//--- registration of tests
+//
+
+BOOST_AUTO_TEST_CASE(CompressedOpDetWaveformLossless) {
+  CompressedOpDetWaveformTestLossless();
+}
+
+BOOST_AUTO_TEST_CASE(CompressedOpDetWaveformZeroSuppression) {
+  CompressedOpDetWaveformTestZeroSuppression();
+}
+
+BOOST_AUTO_TEST_CASE(CompressedOpDetWaveformSpecialCases) {
+  CompressedOpDetWaveformTestSpecialCases();
+}
+
+BOOST_AUTO_TEST_CASE(CompressedOpDetWaveformView) {
+  CompressedOpDetWaveformTestView();
+}
@@ -0,0 +1,148 @@
+/**
+ * @file    OpDetWaveformIndex_test.cc
+ * @brief   Test on raw::OpDetWaveformIndex
+ * @date    20261017
+ * @version 1.0
+ *
+ * This test indexes collections of optical waveforms and compares the
+ * waveforms found in time windows with the ones found by checking all the
+ * waveforms of the collection.
+ *
+ * See http://www.boost.org/libs/test for the Boost test library home page.
+ *
+ * Timing:
+ * version 1.0: <1" (debug mode)
+ */
+
+// C/C++ standard library
+#include <algorithm> // std::stable_sort()
+#include <random>
+#include <vector>
+
+
+// Boost libraries
+/*
+ * Boost Magic: define the name of the module;
+ * and do that before the inclusion of Boost unit test headers
+ * because it will change what they provide.
+ * Among the those, there is a main() function and some wrapping catching
+ * unhandled exceptions and considering them test failures, and probably more.
+ * This also makes fairly complicate to receive parameters from the command line
+ * (for example, a random seed).
+ */
+#define BOOST_TEST_MODULE ( opdetwaveformindex_test )
+#include "cetlib/quiet_unit_test.hpp" // BOOST_AUTO_TEST_CASE()
+#include <boost/test/test_tools.hpp> // BOOST_CHECK()
+
+// LArSoft libraries
+#include "lardataobj/RawData/OpDetWaveform.h"
+#include "lardataobj/RawData/OpDetWaveformIndex.h"
+
+
+
+//------------------------------------------------------------------------------
+//--- Test code
+//
+
+constexpr double TickPeriod = 0.002; // us
+
+
+/// Returns a waveform on channel starting at time with nSamples samples
+raw::OpDetWaveform MakeWaveform
+  (raw::Channel_t channel, raw::TimeStamp_t time, size_t nSamples)
+{
+  raw::OpDetWaveform waveform(time, channel, nSamples);
+  waveform.resize(nSamples, 2000);
+  return waveform;
+} // MakeWaveform()
+
+
+/// Returns the indices of the waveforms overlapping the window, by time
+std::vector<size_t> FindAll(std::vector<raw::OpDetWaveform> const& waveforms,
+  raw::Channel_t channel, raw::TimeStamp_t start, raw::TimeStamp_t end)
+{
+  std::vector<size_t> indices;
+  for (size_t i = 0; i < waveforms.size(); ++i) {
+    raw::OpDetWaveform const& waveform = waveforms[i];
+    if (waveform.ChannelNumber() != channel) continue;
+    raw::TimeStamp_t const wEnd
+      = waveform.TimeStamp() + waveform.size() * TickPeriod;
+    if ((waveform.TimeStamp() < end) && (wEnd > start) && (start < end))
+      indices.push_back(i);
+  }
+  std::stable_sort(indices.begin(), indices.end(),
+    [&waveforms](size_t a, size_t b)
+      { return waveforms[a].TimeStamp() < waveforms[b].TimeStamp(); });
+  return indices;
+} // FindAll()
+
+
+void OpDetWaveformIndexTestSimple() {
+
+  std::vector<raw::OpDetWaveform> waveforms;
+  waveforms.push_back(MakeWaveform(5, 10.0, 500));  // [ 10, 11 )
+  waveforms.push_back(MakeWaveform(3, 10.5, 500));  // [ 10.5, 11.5 )
+  waveforms.push_back(MakeWaveform(5, 12.0, 500));  // [ 12, 13 )
+  waveforms.push_back(MakeWaveform(5, 11.0, 250));  // [ 11, 11.5 )
+
+  raw::OpDetWaveformIndex const index(waveforms, TickPeriod);
+  BOOST_CHECK_EQUAL(index.size(), waveforms.size());
+  BOOST_CHECK_EQUAL(index.TickPeriod(), TickPeriod);
+  BOOST_CHECK(index.Channels() == (std::vector<raw::Channel_t>{ 3, 5 }));
+
+  std::vector<raw::OpDetWaveform const*> const all = index.Waveforms(5);
+  BOOST_CHECK(all == (std::vector<raw::OpDetWaveform const*>
+    { &waveforms[0], &waveforms[3], &waveforms[2] }));
+  BOOST_CHECK(index.Waveforms(4).empty());
+
+  // the end of the waveforms and of the window are excluded
+  BOOST_CHECK(index.OverlappingIndices(5, 10.9, 11.0) == std::vector<size_t>{ 0 });
+  BOOST_CHECK(index.OverlappingIndices(5, 10.9, 11.1) == (std::vector<size_t>{ 0, 3 }));
+  BOOST_CHECK(index.OverlappingIndices(5, 11.5, 12.0).empty());
+  BOOST_CHECK(index.OverlappingIndices(5, 0.0, 100.0) == (std::vector<size_t>{ 0, 3, 2 }));
+  BOOST_CHECK(index.OverlappingIndices(5, 12.0, 11.0).empty());
+  BOOST_CHECK(index.OverlappingIndices(3, 11.2, 11.3) == std::vector<size_t>{ 1 });
+  BOOST_CHECK(index.OverlappingIndices(4, 0.0, 100.0).empty());
+  BOOST_CHECK(index.Overlapping(5, 12.5, 12.6)
+    == std::vector<raw::OpDetWaveform const*>{ &waveforms[2] });
+
+} // OpDetWaveformIndexTestSimple()
+
+
+void OpDetWaveformIndexTestRandom() {
+
+  std::default_random_engine engine(20261017);
+  std::uniform_int_distribution<raw::Channel_t> channelDist(0, 9);
+  std::uniform_real_distribution<double> timeDist(0.0, 100.0);
+  std::uniform_int_distribution<size_t> sizeDist(0, 5000); // up to 10 us
+
+  // waveforms of different length, overlapping and containing each other
+  std::vector<raw::OpDetWaveform> waveforms;
+  for (size_t i = 0; i < 2000; ++i)
+    waveforms.push_back(MakeWaveform(channelDist(engine), timeDist(engine), sizeDist(engine)));
+  waveforms.push_back(MakeWaveform(2, waveforms.back().TimeStamp(), 100)); // same time
+
+  raw::OpDetWaveformIndex const index(waveforms, TickPeriod);
+  std::uniform_real_distribution<double> windowDist(0.0, 2.0);
+  for (size_t i = 0; i < 2000; ++i) {
+    raw::Channel_t const channel = channelDist(engine);
+    raw::TimeStamp_t const start = timeDist(engine) - 5.0;
+    raw::TimeStamp_t const end = start + windowDist(engine);
+    std::vector<size_t> const expected = FindAll(waveforms, channel, start, end);
+    BOOST_CHECK(index.OverlappingIndices(channel, start, end) == expected);
+  } // for
+
+} // OpDetWaveformIndexTestRandom()
+
+
+//------------------------------------------------------------------------------
+//--- registration of tests
+//
+
+BOOST_AUTO_TEST_CASE(OpDetWaveformIndexSimple) {
+  OpDetWaveformIndexTestSimple();
+}
+
+BOOST_AUTO_TEST_CASE(OpDetWaveformIndexRandom) {
+  OpDetWaveformIndexTestRandom();
+}
@@ -0,0 +1,179 @@
+/**
+ * @file    RawDigitBlock_test.cc
+ * @brief   Test on a raw::RawDigitBlock object
+ * @date    20261017
+ * @version 1.0
+ *
+ * This test fills raw::RawDigitBlock objects and verifies that the digits
+ * it provides are the same as the raw::RawDigit it was filled with.
+ *
+ * See http://www.boost.org/libs/test for the Boost test library home page.
+ *
+ * Timing:
+ * version 1.0: <1" (debug mode)
+ */
+
+// C/C++ standard library
+#include <algorithm> // std::equal()
+#include <vector>
+
+
+// Boost libraries
+/*
+ * Boost Magic: define the name of the module;
+ * and do that before the inclusion of Boost unit test headers
+ * because it will change what they provide.
+ * Among the those, there is a main() function and some wrapping catching
+ * unhandled exceptions and considering them test failures, and probably more.
+ * This also makes fairly complicate to receive parameters from the command line
+ * (for example, a random seed).
+ */
+#define BOOST_TEST_MODULE ( rawdigitblock_test )
+#include "cetlib/quiet_unit_test.hpp" // BOOST_AUTO_TEST_CASE()
+#include <boost/test/test_tools.hpp> // BOOST_CHECK()
+
+// LArSoft libraries
+#include "larcoreobj/SimpleTypesAndConstants/RawTypes.h" // raw::ChannelID_t
+#include "lardataobj/RawData/raw.h"
+#include "lardataobj/RawData/RawDigit.h"
+#include "lardataobj/RawData/RawDigitBlock.h"
+
+// framework libraries
+#include "cetlib_except/exception.h"
+
+
+
+//------------------------------------------------------------------------------
+//--- Test code
+//
+
+
+/// Returns some digits with different sizes and compressions
+std::vector<raw::RawDigit> MakeTestDigits() {
+
+  std::vector<raw::RawDigit> digits;
+  for (raw::ChannelID_t channel = 0; channel < 20; ++channel) {
+    const unsigned short samples = 100 + 10 * channel;
+    raw::RawDigit::ADCvector_t adclist(samples);
+    for (size_t i = 0; i < samples; ++i)
+      adclist[i] = 400 + ((i % 7 == 0)? 50: 0) + channel;
+    const raw::Compress_t compression = (channel % 2)? raw::kHuffman: raw::kNone;
+    raw::Compress(adclist, compression);
+    digits.emplace_back(channel, samples, adclist, compression);
+    digits.back().SetPedestal(400. + channel, 2.5);
+  } // for
+  return digits;
+
+} // MakeTestDigits()
+
+
+template <typename Digit>
+void CheckDigit(Digit const& digit, raw::RawDigit const& expected) {
+
+  BOOST_CHECK_EQUAL(digit.Channel(), expected.Channel());
+  BOOST_CHECK_EQUAL(digit.Samples(), expected.Samples());
+  BOOST_CHECK_EQUAL(digit.GetPedestal(), expected.GetPedestal());
+  BOOST_CHECK_EQUAL(digit.GetSigma(), expected.GetSigma());
+  BOOST_CHECK_EQUAL(digit.Compression(), expected.Compression());
+  BOOST_CHECK_EQUAL(digit.NADC(), expected.NADC());
+  BOOST_CHECK(std::equal(digit.ADCs().begin(), digit.ADCs().end(),
+    expected.ADCs().begin(), expected.ADCs().end()));
+  for (size_t i = 0; i < expected.NADC(); ++i)
+    BOOST_CHECK_EQUAL(digit.ADC(i), expected.ADC(i));
+
+} // CheckDigit()
+
+
+void RawDigitBlockTestDefaultConstructor() {
+
+  raw::RawDigitBlock block;
+
+  BOOST_CHECK_EQUAL(block.NDigits(), 0U);
+  BOOST_CHECK(block.empty());
+  BOOST_CHECK(block.begin() == block.end());
+  BOOST_CHECK_EQUAL(block.Offsets().size(), 1U);
+  BOOST_CHECK(block.ADCData().empty());
+
+} // RawDigitBlockTestDefaultConstructor()
+
+
+void RawDigitBlockTestFromDigits() {
+
+  std::vector<raw::RawDigit> const digits = MakeTestDigits();
+
+  raw::RawDigitBlock const block(digits);
+  BOOST_CHECK_EQUAL(block.NDigits(), digits.size());
+
+  size_t nADCs = 0;
+  for (raw::RawDigit const& digit: digits) nADCs += digit.NADC();
+  BOOST_CHECK_EQUAL(block.ADCData().size(), nADCs);
+
+  // access by index
+  for (size_t i = 0; i < digits.size(); ++i) {
+    CheckDigit(block[i], digits[i]);
+    BOOST_CHECK_EQUAL(block.Digit(i).Index(), i);
+  }
+
+  // access by iteration
+  size_t i = 0;
+  for (raw::RawDigitRef digit: block) CheckDigit(digit, digits[i++]);
+  BOOST_CHECK_EQUAL(i, digits.size());
+
+  // conversion back
+  std::vector<raw::RawDigit> const copies = block.MakeRawDigits();
+  BOOST_CHECK_EQUAL(copies.size(), digits.size());
+  for (size_t i = 0; i < digits.size(); ++i) CheckDigit(copies[i], digits[i]);
+
+  // the data can be uncompressed from the copies
+  raw::RawDigit const& copy = copies[1];
+  raw::RawDigit::ADCvector_t ADCs(copy.Samples());
+  raw::Uncompress(copy.ADCs(), ADCs, copy.Compression());
+  BOOST_CHECK_EQUAL(ADCs[0], 400 + 50 + 1);
+
+  BOOST_CHECK_THROW(block[0].ADC(block[0].NADC()), std::out_of_range);
+
+} // RawDigitBlockTestFromDigits()
+
+
+void RawDigitBlockTestAllData() {
+
+  std::vector<raw::RawDigit> const digits = MakeTestDigits();
+  raw::RawDigitBlock const block(digits);
+
+  // a block with the same content
+  raw::RawDigitBlock const copy(block.Channels(), block.SampleCounts(),
+    block.Pedestals(), block.Sigmas(), block.Compressions(), block.ADCData(),
+    block.Offsets());
+  BOOST_CHECK_EQUAL(copy.NDigits(), digits.size());
+  for (size_t i = 0; i < digits.size(); ++i) CheckDigit(copy[i], digits[i]);
+
+  // inconsistent content
+  std::vector<float> shortPedestals(block.Pedestals());
+  shortPedestals.pop_back();
+  BOOST_CHECK_THROW(raw::RawDigitBlock(block.Channels(), block.SampleCounts(),
+    shortPedestals, block.Sigmas(), block.Compressions(), block.ADCData(),
+    block.Offsets()), cet::exception);
+  std::vector<ULong64_t> badOffsets(block.Offsets());
+  badOffsets.back() += 1;
+  BOOST_CHECK_THROW(raw::RawDigitBlock(block.Channels(), block.SampleCounts(),
+    block.Pedestals(), block.Sigmas(), block.Compressions(), block.ADCData(),
+    badOffsets), cet::exception);
+
+} // RawDigitBlockTestAllData()
+
+
+//------------------------------------------------------------------------------
+//--- registration of tests
+//
+
+BOOST_AUTO_TEST_CASE(RawDigitBlockDefaultConstructor) {
+  RawDigitBlockTestDefaultConstructor();
+}
+
+BOOST_AUTO_TEST_CASE(RawDigitBlockFromDigits) {
+  RawDigitBlockTestFromDigits();
+}
+
+BOOST_AUTO_TEST_CASE(RawDigitBlockAllData) {
+  RawDigitBlockTestAllData();
+}
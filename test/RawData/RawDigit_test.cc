@@ -6,7 +6,8 @@
  * @version 1.0
  *
  * This test simply creates raw::RawDigit objects and verifies that the values
- * it can access are the right ones.
+ * it can access are the right ones. It also times a pedestal RMS computation
+ * with checked access to the samples and with the unchecked view.
  *
  * See http://www.boost.org/libs/test for the Boost test library home page.
  *
@@ -16,6 +17,9 @@
 
 // C/C++ standard library
 #include <algorithm> // std::equal()
+#include <chrono> // std::chrono::steady_clock
+#include <cmath> // std::sqrt()
+#include <iostream>
 
 
 // Boost libraries
@@ -76,6 +80,16 @@ void CheckRawDigit(
   BOOST_CHECK
     (std::equal(ADCs.begin(), ADCs.end(), uncompressed_adclist.begin()));
 
+  // - views of the compressed digits
+  raw::SampleSpan const span = digits.ADCSpan();
+  BOOST_CHECK_EQUAL(span.size(), digits.NADC());
+  BOOST_CHECK_EQUAL(span.data(), digits.ADCs().data());
+  BOOST_CHECK(std::equal(span.begin(), span.end(),
+    digits.ADCs().begin(), digits.ADCs().end()));
+  for (size_t i = 0; i < span.size(); ++i)
+    BOOST_CHECK_EQUAL(span[i], digits.ADC(i));
+  BOOST_CHECK_THROW(span.at(span.size()), std::out_of_range);
+
   // - others
   BOOST_CHECK_EQUAL(digits.GetPedestal(), 0.);
   BOOST_CHECK_EQUAL(digits.GetSigma(), 0.);
@@ -153,6 +167,60 @@ void RawDigitTestCustomConstructors() {
 } // RawDigitTestCustomConstructors()
 
 
+/// Pedestal RMS from the samples of an uncompressed digit, via RawDigit::ADC()
+double PedestalRMSChecked(raw::RawDigit const& digit) {
+  // integral sums are exact, and the compiler is free to reorder them
+  long long int sum = 0, sum2 = 0;
+  for (size_t i = 0; i < digit.NADC(); ++i) {
+    int const adc = digit.ADC(i);
+    sum += adc;
+    sum2 += adc * adc;
+  }
+  double const n = digit.NADC();
+  return std::sqrt(sum2 / n - (sum / n) * (sum / n));
+} // PedestalRMSChecked()
+
+
+/// Pedestal RMS from the samples of an uncompressed digit, via its view
+double PedestalRMSSpan(raw::RawDigit const& digit) {
+  long long int sum = 0, sum2 = 0;
+  for (int adc: digit.ADCSpan()) {
+    sum += adc;
+    sum2 += adc * adc;
+  }
+  double const n = digit.NADC();
+  return std::sqrt(sum2 / n - (sum / n) * (sum / n));
+} // PedestalRMSSpan()
+
+
+void RawDigitTestPedestalRMSSpeed() {
+
+  constexpr size_t samples = 6400;
+  constexpr unsigned int repetitions = 2000;
+  raw::RawDigit::ADCvector_t adclist(samples);
+  for (size_t i = 0; i < samples; ++i)
+    adclist[i] = 400 + (i * 7919) % 11 - 5;
+  raw::RawDigit const digit(1, samples, adclist);
+
+  BOOST_CHECK_CLOSE(PedestalRMSChecked(digit), PedestalRMSSpan(digit), 1e-6);
+
+  auto const time = [&digit](double (*rms)(raw::RawDigit const&)) {
+    double total = 0.;
+    auto const start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < repetitions; ++i) total += rms(digit);
+    std::chrono::duration<double> const elapsed
+      = std::chrono::steady_clock::now() - start;
+    BOOST_CHECK_GT(total, 0.); // also keeps the loop from being optimized away
+    return samples * repetitions / elapsed.count() / 1e6;
+  };
+  double const checked = time(PedestalRMSChecked);
+  double const span = time(PedestalRMSSpan);
+  std::cout << "Pedestal RMS: " << checked << " Msamples/s with ADC(), "
+    << span << " Msamples/s with ADCSpan()" << std::endl;
+
+} // RawDigitTestPedestalRMSSpeed()
+
+
 //------------------------------------------------------------------------------
 //--- registration of tests
 //
@@ -169,3 +237,7 @@ BOOST_AUTO_TEST_CASE(RawDigitDefaultConstructor) {
 BOOST_AUTO_TEST_CASE(RawDigitCustomConstructors) {
   RawDigitTestCustomConstructors();
 }
+
+BOOST_AUTO_TEST_CASE(RawDigitPedestalRMSSpeed) {
+  RawDigitTestPedestalRMSSpeed();
+}
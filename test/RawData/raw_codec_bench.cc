@@ -0,0 +1,404 @@
+/**
+ * @file    raw_codec_bench.cc
+ * @brief   Benchmark of the raw data compression routines
+ * @date    20261017
+ * @version 1.0
+ * @see     lardataobj/RawData/raw.h
+ *
+ * Synthetic waveforms of a few kinds (white noise, noise coherent among
+ * channels, track pulses, saturated pulses and long readouts) are compressed
+ * with raw::Compress() and uncompressed with raw::Uncompress() with each of
+ * the compression types, and with a few zero suppression thresholds.
+ * For each combination, a line is printed in CSV format with:
+ *
+ * * `dataset`: the kind of waveforms
+ * * `compression`: the compression type
+ * * `threshold`, `nearestneighbor`: zero suppression settings (empty if not
+ *   used by the compression type)
+ * * `channels`, `ticks`: number of waveforms and of ticks in each of them
+ * * `raw_bytes`, `compressed_bytes`: size of the data before and after
+ *   compression
+ * * `ratio`: compressed size over original size
+ * * `encode_MBps`, `decode_MBps`: speed of compression and uncompression, in
+ *   megabytes of uncompressed data per second
+ * * `roundtrip`: `exact` if the uncompressed waveforms are identical to the
+ *   original ones, `lossy` if the only differences are suppressed samples,
+ *   `ERROR` otherwise, and `unsupported` if there is no codec for the type
+ *
+ * A second table compares, for each kind of waveforms, alternative ways to
+ * decode the same data, with columns:
+ *
+ * * `dataset`, `compression`, `channels`, `ticks`: as above
+ * * `decoder`: the decoding function; `UncompressEntropy` decodes the data
+ *   from raw::CompressEntropy() (`entropy` compression) and
+ *   `UncompressHuffman` the one from raw::CompressHuffman(), while
+ *   `Uncompress+subtraction` and `UncompressPedestalSubtracted` produce
+ *   pedestal-subtracted samples in two passes and in a single one
+ * * `decode_MBps`: speed of the decoding, in megabytes of uncompressed data
+ *   per second
+ *
+ * Options:
+ *
+ * * `--quick`: fewer and shorter waveforms, and a single repetition (used
+ *   as a test)
+ * * `--repetitions N`: number of times each measurement is repeated (default:
+ *   5); the fastest one is reported
+ *
+ * The program exits with a non-zero code if any round trip fails.
+ */
+
+// LArSoft libraries
+#include "lardataobj/RawData/raw.h"
+#include "lardataobj/RawData/Codec.h"
+#include "lardataobj/RawData/EntropyCodec.h"
+
+// C/C++ standard libraries
+#include <algorithm> // std::min(), std::max()
+#include <chrono> // std::chrono::steady_clock
+#include <cmath> // std::exp(), std::lround()
+#include <cstdlib> // std::atoi()
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+  /// Pedestal of all the waveforms
+  constexpr int Pedestal = 400;
+
+  /// Largest value of the ADC (12 bits)
+  constexpr short ADCMax = 4095;
+
+  using Waveforms_t = std::vector<std::vector<short>>;
+
+
+  /// A set of waveforms to be compressed
+  struct DataSet {
+    std::string name;
+    Waveforms_t waveforms;
+  };
+
+
+  /// Rounds and clamps a value into the range of the ADC
+  short toADC(double value)
+  {
+    return static_cast<short>
+      (std::min(std::max(std::lround(value), 0L), long(ADCMax)));
+  }
+
+
+  /// Gaussian noise around the pedestal
+  Waveforms_t whiteNoise
+    (std::size_t nChannels, std::size_t nTicks, std::mt19937& engine)
+  {
+    std::normal_distribution<double> noise(Pedestal, 2.5);
+    Waveforms_t waveforms(nChannels, std::vector<short>(nTicks));
+    for(auto& waveform: waveforms)
+      for(short& sample: waveform) sample = toADC(noise(engine));
+    return waveforms;
+  } // whiteNoise()
+
+
+  /// Noise common to all channels, plus a smaller noise of each channel
+  Waveforms_t coherentNoise
+    (std::size_t nChannels, std::size_t nTicks, std::mt19937& engine)
+  {
+    std::normal_distribution<double> common(0., 3.), own(0., 1.);
+    std::vector<double> commonMode(nTicks);
+    double level = 0.;
+    for(double& value: commonMode){
+      level = 0.9 * level + common(engine); // low-frequency noise
+      value = level;
+    }
+    Waveforms_t waveforms(nChannels, std::vector<short>(nTicks));
+    for(auto& waveform: waveforms){
+      for(std::size_t tick = 0; tick < nTicks; ++tick)
+        waveform[tick] = toADC(Pedestal + commonMode[tick] + own(engine));
+    }
+    return waveforms;
+  } // coherentNoise()
+
+
+  /// Adds to each waveform pulses of the specified amplitude
+  void addPulses(Waveforms_t& waveforms, double amplitude,
+                 std::size_t spacing, std::mt19937& engine)
+  {
+    std::uniform_real_distribution<double> scale(0.2, 1.0);
+    constexpr double width = 6.; // ticks
+    for(auto& waveform: waveforms){
+      for(std::size_t peak = spacing / 2; peak < waveform.size(); peak += spacing){
+        double const height = amplitude * scale(engine);
+        std::size_t const first = (peak > 30)? peak - 30: 0;
+        std::size_t const last = std::min(peak + 30, waveform.size());
+        for(std::size_t tick = first; tick < last; ++tick){
+          double const x = (double(tick) - double(peak)) / width;
+          waveform[tick] = toADC(waveform[tick] + height * std::exp(-0.5 * x * x));
+        }
+      } // for pulses
+    } // for waveforms
+  } // addPulses()
+
+
+  /// Creates all the data sets
+  std::vector<DataSet> makeDataSets(bool quick)
+  {
+    std::mt19937 engine(20261017);
+    std::size_t const nChannels = quick? 8: 64;
+    std::size_t const nTicks = quick? 2000: 6400;
+
+    std::vector<DataSet> dataSets;
+    dataSets.push_back({ "white noise", whiteNoise(nChannels, nTicks, engine) });
+    dataSets.push_back
+      ({ "coherent noise", coherentNoise(nChannels, nTicks, engine) });
+
+    Waveforms_t tracks = whiteNoise(nChannels, nTicks, engine);
+    addPulses(tracks, 100., 500, engine);
+    dataSets.push_back({ "track pulses", std::move(tracks) });
+
+    Waveforms_t saturated = whiteNoise(nChannels, nTicks, engine);
+    addPulses(saturated, 2.5 * (ADCMax - Pedestal), 1000, engine);
+    dataSets.push_back({ "saturation", std::move(saturated) });
+
+    Waveforms_t longReadout
+      = whiteNoise(quick? 2: 4, quick? 40000: (1U << 20), engine);
+    addPulses(longReadout, 100., 5000, engine);
+    dataSets.push_back({ "long readout", std::move(longReadout) });
+
+    return dataSets;
+  } // makeDataSets()
+
+
+  /// Compression settings
+  struct Setting {
+    raw::Compress_t compress;
+    std::string name;
+    bool zeroSuppression; ///< whether threshold and neighbours are used
+    unsigned int threshold = 0;
+    int nearestNeighbor = 0;
+  };
+
+
+  /// Returns all the settings to be tried
+  std::vector<Setting> makeSettings()
+  {
+    std::vector<Setting> settings;
+    settings.push_back({ raw::kNone, "kNone", false });
+    settings.push_back({ raw::kHuffman, "kHuffman", false });
+    for(auto const& [ compress, name ]: {
+      std::pair{ raw::kZeroSuppression, "kZeroSuppression" },
+      std::pair{ raw::kZeroHuffman, "kZeroHuffman" }
+    }) {
+      for(unsigned int threshold: { 3U, 5U, 10U, 20U })
+        for(int nearestNeighbor: { 0, 4 })
+          settings.push_back({ compress, name, true, threshold, nearestNeighbor });
+    }
+    settings.push_back({ raw::kDynamicDec, "kDynamicDec", false });
+    return settings;
+  } // makeSettings()
+
+
+  /// Returns whether the only differences of b from a are at the pedestal
+  std::string compareWaveforms
+    (std::vector<short> const& a, std::vector<short> const& b)
+  {
+    if(a.size() != b.size()) return "ERROR";
+    bool exact = true;
+    for(std::size_t tick = 0; tick < a.size(); ++tick){
+      if(a[tick] == b[tick]) continue;
+      if(b[tick] != Pedestal) return "ERROR";
+      exact = false;
+    }
+    return exact? "exact": "lossy";
+  } // compareWaveforms()
+
+
+  /// Runs a benchmark and prints its result; returns whether it succeeded
+  bool benchmark
+    (DataSet const& dataSet, Setting const& setting, unsigned int repetitions)
+  {
+    Waveforms_t const& original = dataSet.waveforms;
+    std::size_t const nTicks = original.front().size();
+    std::size_t const rawBytes = original.size() * nTicks * sizeof(short);
+
+    // the line is printed in one go, after messages from the compression
+    std::ostringstream line;
+    line << '"' << dataSet.name << "\"," << setting.name << ',';
+    if(setting.zeroSuppression)
+      line << setting.threshold << ',' << setting.nearestNeighbor << ',';
+    else line << ",,";
+    line << original.size() << ',' << nTicks << ',' << rawBytes << ',';
+
+    if(!raw::CodecRegistry::Instance().Find(setting.compress)){
+      std::cout << line.str() << ",,,,unsupported" << std::endl;
+      return true;
+    }
+
+    using clock = std::chrono::steady_clock;
+    double bestEncode = 0., bestDecode = 0.; // seconds
+    Waveforms_t compressed, uncompressed
+      (original.size(), std::vector<short>(nTicks));
+    for(unsigned int rep = 0; rep < repetitions; ++rep){
+      compressed = original;
+      auto start = clock::now();
+      for(auto& adc: compressed){
+        unsigned int threshold = setting.threshold;
+        int nearestNeighbor = setting.nearestNeighbor;
+        raw::Compress
+          (adc, setting.compress, threshold, Pedestal, nearestNeighbor);
+      }
+      std::chrono::duration<double> const encode = clock::now() - start;
+
+      start = clock::now();
+      for(std::size_t i = 0; i < compressed.size(); ++i){
+        raw::Uncompress
+          (compressed[i], uncompressed[i], Pedestal, setting.compress);
+      }
+      std::chrono::duration<double> const decode = clock::now() - start;
+
+      if((rep == 0) || (encode.count() < bestEncode)) bestEncode = encode.count();
+      if((rep == 0) || (decode.count() < bestDecode)) bestDecode = decode.count();
+    } // for repetitions
+
+    std::size_t compressedWords = 0;
+    for(auto const& adc: compressed) compressedWords += adc.size();
+    std::size_t const compressedBytes = compressedWords * sizeof(short);
+
+    std::string roundtrip = "exact";
+    for(std::size_t i = 0; i < original.size(); ++i){
+      std::string const result = compareWaveforms(original[i], uncompressed[i]);
+      if(result == "exact") continue;
+      roundtrip = result;
+      if(result == "ERROR") break;
+    }
+    if(!setting.zeroSuppression && (roundtrip != "exact")) roundtrip = "ERROR";
+
+    double const MB = rawBytes / 1e6;
+    line << compressedBytes << ',' << (double(compressedBytes) / rawBytes)
+      << ',' << (MB / bestEncode) << ',' << (MB / bestDecode)
+      << ',' << roundtrip;
+    std::cout << line.str() << std::endl;
+    return roundtrip != "ERROR";
+  } // benchmark()
+
+
+  /// Returns the shortest time taken by action in repetitions calls [s]
+  template <typename Action>
+  double bestTime(Action action, unsigned int repetitions)
+  {
+    using clock = std::chrono::steady_clock;
+    double best = 0.;
+    for(unsigned int rep = 0; rep < repetitions; ++rep){
+      auto const start = clock::now();
+      action();
+      std::chrono::duration<double> const elapsed = clock::now() - start;
+      if((rep == 0) || (elapsed.count() < best)) best = elapsed.count();
+    } // for repetitions
+    return best;
+  } // bestTime()
+
+
+  /// Prints the speed of alternative decoders of the waveforms of dataSet
+  void benchmarkDecoders(DataSet const& dataSet, unsigned int repetitions)
+  {
+    Waveforms_t const& original = dataSet.waveforms;
+    std::size_t const nTicks = original.front().size();
+    double const MB = original.size() * nTicks * sizeof(short) / 1e6;
+
+    auto const print = [&](std::string const& compression,
+                           std::string const& decoder, double seconds)
+      {
+        std::cout << '"' << dataSet.name << "\"," << compression << ','
+          << decoder << ',' << original.size() << ',' << nTicks << ','
+          << (MB / seconds) << std::endl;
+      };
+
+    // canonical Huffman coding with a fitted model against the plain one
+    Waveforms_t entropy = original, huffman = original;
+    for(auto& adc: entropy) raw::CompressEntropy(adc);
+    for(auto& adc: huffman) raw::CompressHuffman(adc);
+    std::vector<short> decoded(nTicks);
+    print("entropy", "UncompressEntropy", bestTime([&](){
+        for(auto const& adc: entropy) raw::UncompressEntropy(adc, decoded);
+      }, repetitions));
+    print("kHuffman", "UncompressHuffman", bestTime([&](){
+        for(auto const& adc: huffman) raw::UncompressHuffman(adc, decoded);
+      }, repetitions));
+
+    // pedestal subtraction after the uncompression, or fused with it
+    float const pedestal = Pedestal + 0.25f;
+    std::vector<float> subtracted(nTicks);
+    for(Setting const& setting: {
+      Setting{ raw::kNone, "kNone", false },
+      Setting{ raw::kHuffman, "kHuffman", false },
+      Setting{ raw::kZeroSuppression, "kZeroSuppression", true, 10, 3 },
+      Setting{ raw::kZeroHuffman, "kZeroHuffman", true, 10, 3 }
+    }) {
+      Waveforms_t compressed = original;
+      for(auto& adc: compressed){
+        unsigned int threshold = setting.threshold;
+        int nearestNeighbor = setting.nearestNeighbor;
+        raw::Compress
+          (adc, setting.compress, threshold, Pedestal, nearestNeighbor);
+      }
+      print(setting.name, "Uncompress+subtraction", bestTime([&](){
+          for(auto const& adc: compressed){
+            raw::Uncompress(adc, decoded, Pedestal, setting.compress);
+            for(std::size_t tick = 0; tick < nTicks; ++tick)
+              subtracted[tick] = decoded[tick] - pedestal;
+          }
+        }, repetitions));
+      print(setting.name, "UncompressPedestalSubtracted", bestTime([&](){
+          for(auto const& adc: compressed){
+            raw::UncompressPedestalSubtracted
+              (adc, subtracted.data(), nTicks, pedestal, setting.compress);
+          }
+        }, repetitions));
+    } // for settings
+
+  } // benchmarkDecoders()
+
+} // local namespace
+
+
+//------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+
+  bool quick = false;
+  unsigned int repetitions = 5;
+  for(int iArg = 1; iArg < argc; ++iArg){
+    std::string const arg = argv[iArg];
+    if(arg == "--quick") quick = true;
+    else if((arg == "--repetitions") && (iArg + 1 < argc))
+      repetitions = std::max(std::atoi(argv[++iArg]), 1);
+    else{
+      std::cerr << "Usage: " << argv[0] << " [--quick] [--repetitions N]"
+        << std::endl;
+      return 1;
+    }
+  } // for
+  if(quick) repetitions = 1;
+
+  std::vector<DataSet> const dataSets = makeDataSets(quick);
+  std::vector<Setting> const settings = makeSettings();
+
+  std::cout << "dataset,compression,threshold,nearestneighbor,channels,ticks,"
+    "raw_bytes,compressed_bytes,ratio,encode_MBps,decode_MBps,roundtrip"
+    << std::endl;
+  unsigned int nErrors = 0;
+  for(DataSet const& dataSet: dataSets)
+    for(Setting const& setting: settings)
+      if(!benchmark(dataSet, setting, repetitions)) ++nErrors;
+
+  std::cout << "\ndataset,compression,decoder,channels,ticks,decode_MBps"
+    << std::endl;
+  for(DataSet const& dataSet: dataSets) benchmarkDecoders(dataSet, repetitions);
+
+  if(nErrors > 0){
+    std::cerr << nErrors << " round trips failed." << std::endl;
+    return 1;
+  }
+  return 0;
+} // main()
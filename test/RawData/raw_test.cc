@@ -3,17 +3,41 @@
  * @brief   Tests the raw data compression routines
  * @author  Gianluca Petrillo (petrillo@fnal.gov)
  * @date    20140716
- * @version 1.0
+ * @version 1.1
  *
  * This test covers only no compression and Huffman compression.
  * If compresses a data set, uncompresses it back and checks that the result
  * is the same as the original one.
  * As such, it does not support lossy compression (like zero suppression).
  *
+ * The Huffman decoder is also compared with the original bit-by-bit
+ * implementation, and the Huffman encoder with the original one. The reuse of raw::ZeroSuppressor
+ * on different waveforms is also tested, as well as the vectorized
+ * over-threshold mask it uses and the zero suppression of a whole plane.
+ * Zero suppression of waveforms too long for the 16-bit layout is tested too,
+ * and so is the single-pass decoding of zero-suppressed, Huffman-encoded data
+ * and the uncompression of windows of ticks. Chunked Huffman encoding and
+ * parallel decoding are compared with the plain ones, and so is the
+ * compression of many channels at once. Finally, the registration of a new
+ * compression algorithm in the codec registry is tested, and so are the
+ * canonical Huffman coding with a model fitted to the data, the
+ * compression of channels sharing coherent noise and the compression with a
+ * bounded error. The classification of ADC sticky codes of whole waveforms
+ * and via look-up table is compared with the original one, and the streaming
+ * compression of fragments of waveforms with the compression of whole ones.
+ * The uncompression into pedestal-subtracted values is compared with the
+ * uncompression followed by the subtraction.
+ * Views of raw digits are checked to uncompress their data once, also when
+ * accessed from many threads. The compression statistics are compared with
+ * the compressed data, and summed per channel and per plane.
+ *
+ * The speed of these routines is measured by raw_codec_bench instead.
+ *
  * See http://www.boost.org/libs/test for the Boost test library home page.
  *
  * Timing:
  * version 1.0 takes less than 3" on a 3 GHz machine
+ * version 1.1 takes less than 5" on a 3 GHz machine
  */
 
 // C/C++ standard libraries
@@ -23,6 +47,13 @@
 #include <string>
 #include <map>
 #include <iostream>
+#include <bitset>
+#include <cstdint> // std::uint64_t
+#include <numeric> // std::adjacent_difference()
+#include <iterator> // std::back_inserter()
+#include <memory> // std::make_unique()
+#include <deque>
+#include <thread>
 
 // Boost libraries
 /*
@@ -38,10 +69,23 @@
 #include "cetlib/quiet_unit_test.hpp" // BOOST_AUTO_TEST_CASE()
 #include <boost/test/test_tools.hpp> // BOOST_CHECK()
 
+// framework libraries
+#include "cetlib_except/exception.h"
+
 // LArSoft libraries
 #include "larcoreobj/SimpleTypesAndConstants/PhysicalConstants.h" // util::pi()
 #include "larcoreobj/SimpleTypesAndConstants/RawTypes.h" // raw::Compress_t
 #include "lardataobj/RawData/raw.h"
+#include "lardataobj/RawData/ZeroSuppressor.h"
+#include "lardataobj/RawData/BatchCompression.h"
+#include "lardataobj/RawData/CompressionStatistics.h"
+#include "lardataobj/RawData/RawDigit.h"
+#include "lardataobj/RawData/Codec.h"
+#include "lardataobj/RawData/EntropyCodec.h"
+#include "lardataobj/RawData/CoherentCompression.h"
+#include "lardataobj/RawData/LossyCompression.h"
+#include "lardataobj/RawData/StreamingCompressor.h"
+#include "lardataobj/RawData/RawDigitView.h"
 
 
 /// The seed for the default random engine
@@ -173,6 +217,9 @@ class SineWaveCreator: public DataCreatorBase {
 class RandomDataCreator: public DataCreatorBase {
 		public:
 
+	/// Constructor: assigns data set name
+	RandomDataCreator(std::string name): DataCreatorBase(name) {}
+
 	/// Creates and returns the data sample
 	virtual InputData_t create(size_t size) override
 		{
@@ -339,3 +386,2371 @@ BOOST_AUTO_TEST_CASE(HighFrequencySineWaveData) {
 	RunDataCompressionTests(&InputData);
 }
 
+
+
+//------------------------------------------------------------------------------
+//--- Huffman decoder comparison with the original bit-by-bit implementation
+//
+
+/**
+ * @brief Original bit-by-bit Huffman decoder, kept as reference
+ * @param adc Huffman-encoded buffer
+ * @param uncompressed buffer to be filled (its size is the number of ticks)
+ *
+ * This is the implementation of raw::UncompressHuffman() before it was
+ * replaced by the table-driven one, verbatim; the only difference is that
+ * the diagnostic message on encoded words with no set bit is not printed.
+ */
+void ReferenceUncompressHuffman
+	(const std::vector<short>& adc, std::vector<short>& uncompressed)
+{
+	//the first entry in adc is a data value by construction
+	uncompressed[0] = adc[0];
+
+	unsigned int curu = 1;
+	short curADC = uncompressed[0];
+
+	// loop over the entries in adc and uncompress them according to the
+	// encoding scheme above the CompressHuffman method
+	for(unsigned int i = 1; i < adc.size() && curu < uncompressed.size(); ++i){
+
+		std::bitset<16> bset(adc[i]);
+
+		int numu = 0;
+
+		//check the 15 bit to see if this entry is a full data value or not
+		if( !bset.test(15) ){
+			curADC = adc[i];
+			if(bset.test(14)){
+				bset.set(14, false);
+				curADC = -1*bset.to_ulong();
+			}
+			uncompressed[curu] = curADC;
+
+			++curu;
+		}
+		else{
+
+			int  b       = 14;
+			int  lowestb = 0;
+
+			// ignore any padding with zeros in the lower order bits
+			while( !bset.test(lowestb) && lowestb < 15) ++lowestb;
+
+			if(lowestb > 14){
+				// (diagnostic message omitted)
+				continue;
+			}
+
+			while( b >= lowestb){
+
+				// count the zeros between the current bit and the next on bit
+				int zerocnt = 0;
+				while( !bset.test(b-zerocnt) && b-zerocnt > lowestb) ++zerocnt;
+
+				b -= zerocnt;
+
+				if(zerocnt == 0){
+					for(int s = 0; s < 4; ++s){
+						uncompressed[curu] = curADC;
+						++curu;
+						++numu;
+						if(curu > uncompressed.size()-1) break;
+					}
+					--b;
+				}
+				else if(zerocnt == 1){
+					uncompressed[curu] = curADC;
+					++curu;
+					++numu;
+					--b;
+				}
+				else if(zerocnt == 2){
+					curADC += 1;
+					uncompressed[curu] = curADC;
+					++curu;
+					++numu;
+					--b;
+				}
+				else if(zerocnt == 3){
+					curADC -= 1;
+					uncompressed[curu] = curADC;
+					++curu;
+					++numu;
+					--b;
+				}
+				else if(zerocnt == 4){
+					curADC += 2;
+					uncompressed[curu] = curADC;
+					++curu;
+					++numu;
+					--b;
+				}
+				else if(zerocnt == 5){
+					curADC -= 2;
+					uncompressed[curu] = curADC;
+					++curu;
+					++numu;
+					--b;
+				}
+				else if(zerocnt == 6){
+					curADC += 3;
+					uncompressed[curu] = curADC;
+					++curu;
+					++numu;
+					--b;
+				}
+				else if(zerocnt == 7){
+					curADC -= 3;
+					uncompressed[curu] = curADC;
+					++curu;
+					++numu;
+					--b;
+				}
+
+				if(curu > uncompressed.size() - 1) break;
+
+			}// end loop over bits
+
+			if(curu > uncompressed.size() - 1) break;
+
+		}// end if this entry in the vector is encoded
+
+	}// end loop over entries in adc
+
+} // ReferenceUncompressHuffman()
+
+
+/**
+ * @brief Compares raw::UncompressHuffman() with the reference decoder
+ * @param pDataCreator an object to create the input data set
+ *
+ * The data is encoded with raw::CompressHuffman() and decoded by both the
+ * table-driven and the reference bit-by-bit decoders; results must match,
+ * also when the output buffer is shorter than the encoded data.
+ */
+void RunHuffmanDecoderComparison(DataCreatorBase* pDataCreator) {
+
+	constexpr size_t size = 1048576;
+	const std::vector<short> data(pDataCreator->create(size));
+
+	std::vector<short> encoded(data);
+	raw::CompressHuffman(encoded);
+
+	// a longer buffer is left untouched past the decoded data
+	for (size_t const nTicks
+		: { size, size - 1, size - 2, size - 3, size / 3, size + 5 })
+	{
+		std::vector<short> decoded(nTicks, -1), expected(nTicks, -1);
+		raw::UncompressHuffman(encoded, decoded);
+		ReferenceUncompressHuffman(encoded, expected);
+		BOOST_CHECK_EQUAL_COLLECTIONS
+			(decoded.begin(), decoded.end(), expected.begin(), expected.end());
+	} // for
+
+} // RunHuffmanDecoderComparison()
+
+
+BOOST_AUTO_TEST_CASE(HuffmanDecoderComparison) {
+
+	UniformNoiseCreator ConstantData("constant input data", 0., 41.);
+	RunHuffmanDecoderComparison(&ConstantData);
+
+	GaussianNoiseCreator SmallNoiseData("Gaussian small noise", 1.5, 400.);
+	RunHuffmanDecoderComparison(&SmallNoiseData);
+
+	GaussianNoiseCreator LargeNoiseData("Gaussian large noise", 5., 400.);
+	RunHuffmanDecoderComparison(&LargeNoiseData);
+
+	SineWaveCreator SineData("Low frequency pure sine wave", 128., 100.);
+	RunHuffmanDecoderComparison(&SineData);
+
+} // BOOST_AUTO_TEST_CASE(HuffmanDecoderComparison)
+
+
+BOOST_AUTO_TEST_CASE(HuffmanDecoderArbitraryWords) {
+
+	// all the possible encoded words, including the ones the encoder would
+	// never write (but empty ones), each preceded by a raw value
+	std::vector<short> encoded { 100 };
+	for (unsigned int payload = 1; payload < (1U << 15); ++payload) {
+		encoded.push_back(short(payload));
+		encoded.push_back(short(0x8000 | payload));
+	} // for
+
+	std::vector<short> decoded(4 * encoded.size() * 15), expected(decoded.size());
+	raw::UncompressHuffman(encoded, decoded);
+	ReferenceUncompressHuffman(encoded, expected);
+	BOOST_CHECK_EQUAL_COLLECTIONS
+		(decoded.begin(), decoded.end(), expected.begin(), expected.end());
+
+	// each word alone, as the last of the data: nothing is written past it
+	for (unsigned int payload = 1; payload < (1U << 15); ++payload) {
+		std::vector<short> const word { 100, short(0x8000 | payload) };
+		std::vector<short> decoded(64, -1), expected(decoded.size(), -1);
+		raw::UncompressHuffman(word, decoded);
+		ReferenceUncompressHuffman(word, expected);
+		if (decoded != expected) {
+			BOOST_CHECK_EQUAL_COLLECTIONS
+				(decoded.begin(), decoded.end(), expected.begin(), expected.end());
+		}
+	} // for
+
+} // BOOST_AUTO_TEST_CASE(HuffmanDecoderArbitraryWords)
+
+
+//------------------------------------------------------------------------------
+//--- Huffman encoder comparison with the original implementation
+//
+
+/**
+ * @brief Original Huffman encoder, kept as reference
+ * @param adc data to be encoded (replaced by the encoded data)
+ *
+ * This is a verbatim copy of raw::CompressHuffman() before it was replaced
+ * by the one writing into a caller-provided buffer (only the name changed).
+ * It requires at least three samples.
+ */
+  void ReferenceCompressHuffman(std::vector<short> &adc)
+  {
+    std::vector<short> const orig_adc(std::move(adc));
+
+    // diffs contains the difference between an element of adc and the previous
+    // one; the first entry is never used.
+    std::vector<short> diffs;
+    diffs.reserve(orig_adc.size());
+    std::adjacent_difference
+      (orig_adc.begin(), orig_adc.end(), std::back_inserter(diffs));
+
+    // prepare adc for the new data; we kind-of-expect the size,
+    // so we pre-allocate it; we might want to shrink-to-fit at the end
+    adc.clear();
+    adc.reserve(orig_adc.size());
+    // now loop over the diffs and do the Huffman encoding
+    adc.push_back(orig_adc.front());
+    unsigned int curb = 15U;
+
+    std::bitset<16> bset;
+    bset.set(15);
+
+    for(size_t i = 1U; i < diffs.size(); ++i){
+
+      switch (diffs[i]) {
+	// if the difference is 0, check to see what the next 3 differences are
+        case 0 : {
+	  if(i < diffs.size() - 3){
+	    // if next 3 are also 0, set the next bit to be 1
+	    if(diffs[i+1] == 0 && diffs[i+2] == 0 && diffs[i+3] == 0){
+	      if(curb > 0){
+		--curb;
+		bset.set(curb);
+		i += 3;
+		continue;
+	      }
+	      else{
+		adc.push_back(bset.to_ulong());
+
+		// reset the bitset to be ready for the next word
+		bset.reset();
+		bset.set(15);
+		bset.set(14); // account for the fact that this is a zero diff
+		curb = 14;
+		i += 3;
+		continue;
+	      } // end if curb is not big enough to put current difference in bset
+	    } // end if next 3 are also zero
+	    else{
+	      // 0 diff is encoded as 01, so move the current bit one to the right
+	      if(curb > 1){
+		curb -= 2;
+		bset.set(curb);
+		continue;
+	      } // end if the current bit is large enough to set this one
+	      else{
+		adc.push_back(bset.to_ulong());
+		// reset the bitset to be ready for the next word
+		bset.reset();
+		bset.set(15);
+		bset.set(13); // account for the fact that this is a zero diff
+		curb = 13;
+		continue;
+	      } // end if curb is not big enough to put current difference in bset
+	    } // end if next 3 are not also 0
+	  }// end if able to check next 3
+	  else{
+	    // 0 diff is encoded as 01, so move the current bit one to the right
+	    if(curb > 1){
+	      curb -= 2;
+	      bset.set(curb);
+		continue;
+	    } // end if the current bit is large enough to set this one
+	    else{
+	      adc.push_back(bset.to_ulong());
+	      // reset the bitset to be ready for the next word
+	      bset.reset();
+	      bset.set(15);
+	      bset.set(13); // account for the fact that this is a zero diff
+	      curb = 13;
+		continue;
+	    } // end if curb is not big enough to put current difference in bset
+	  }// end if not able to check the next 3
+	  break;
+	}// end if current difference is zero
+	case 1: {
+	  if(curb > 2){
+	    curb -= 3;
+	    bset.set(curb);
+	  }
+	  else{
+	    adc.push_back(bset.to_ulong());
+	    // reset the bitset to be ready for the next word
+	    bset.reset();
+	    bset.set(15);
+	    bset.set(12); // account for the fact that this is a +1 diff
+	    curb = 12;
+	  } // end if curb is not big enough to put current difference in bset
+	  break;
+	} // end if difference = 1
+        case -1: {
+	  if(curb > 3){
+	    curb -= 4;
+	    bset.set(curb);
+	  }
+	  else{
+	    adc.push_back(bset.to_ulong());
+	    // reset the bitset to be ready for the next word
+	    bset.reset();
+	    bset.set(15);
+	    bset.set(11); // account for the fact that this is a -1 diff
+	    curb = 11;
+	  } // end if curb is not big enough to put current difference in bset
+	  break;
+	}// end if difference = -1
+        case 2: {
+	  if(curb > 4){
+	    curb -= 5;
+	    bset.set(curb);
+	  }
+	  else{
+	    adc.push_back(bset.to_ulong());
+	    // reset the bitset to be ready for the next word
+	    bset.reset();
+	    bset.set(15);
+	    bset.set(10); // account for the fact that this is a +2 diff
+	    curb = 10;
+	  } // end if curb is not big enough to put current difference in bset
+	  break;
+	}// end if difference = 2
+        case -2: {
+	  if(curb > 5){
+	    curb -= 6;
+	    bset.set(curb);
+	  }
+	  else{
+	    adc.push_back(bset.to_ulong());
+	    // reset the bitset to be ready for the next word
+	    bset.reset();
+	    bset.set(15);
+	    bset.set(9); // account for the fact that this is a -2 diff
+	    curb = 9;
+	  } // end if curb is not big enough to put current difference in bset
+	  break;
+	}// end if difference = -2
+        case 3: {
+	  if(curb > 6){
+	    curb -= 7;
+	    bset.set(curb);
+	  }
+	  else{
+	    adc.push_back(bset.to_ulong());
+	    // reset the bitset to be ready for the next word
+	    bset.reset();
+	    bset.set(15);
+	    bset.set(8); // account for the fact that this is a +3 diff
+	    curb = 8;
+	  } // end if curb is not big enough to put current difference in bset
+	  break;
+	}// end if difference = 3
+        case -3: {
+	  if(curb > 7){
+	    curb -= 8;
+	    bset.set(curb);
+	  }
+	  else{
+	    adc.push_back(bset.to_ulong());
+	    // reset the bitset to be ready for the next word
+	    bset.reset();
+	    bset.set(15);
+	    bset.set(7); // account for the fact that this is a -3 diff
+	    curb = 7;
+	  } // end if curb is not big enough to put current difference in bset
+	  break;
+	}// end if difference = -3
+        default: {
+	  // if the difference is too large that we have to put the entire adc value in:
+	  // put the current value into the adc vec unless the current bit is 15, then there
+	  // were multiple large difference values in a row
+	  if(curb != 15){
+	    adc.push_back(bset.to_ulong());
+	  }
+
+	  bset.reset();
+	  bset.set(15);
+	  curb = 15;
+
+	  // put the current adcvalue in adc, with its bit 15 set to 0
+	  if(orig_adc[i] > 0) adc.push_back(orig_adc[i]);
+	  else{
+	    std::bitset<16> tbit(-orig_adc[i]);
+	    tbit.set(14);
+	    adc.push_back(tbit.to_ulong());
+	  }
+	  break;
+        } // if |difference| > 3
+      }// switch diff[i]
+    }// end loop over differences
+
+    //write out the last bitset
+    adc.push_back(bset.to_ulong());
+
+    // this would reduce global memory usage,
+    // at the cost of a new allocation and copy
+  //  adc.shrink_to_fit();
+
+  } // ReferenceCompressHuffman()
+
+
+/// Checks that raw::CompressHuffman() matches the reference encoder
+void RunHuffmanEncoderComparison(DataCreatorBase* pDataCreator) {
+
+	for (size_t const size: { 3, 4, 5, 64, 9600, 1048576 }) {
+		const std::vector<short> data(pDataCreator->create(size));
+
+		std::vector<short> expected(data);
+		ReferenceCompressHuffman(expected);
+
+		std::vector<short> encoded(data);
+		raw::CompressHuffman(encoded);
+		BOOST_CHECK_EQUAL_COLLECTIONS
+			(encoded.begin(), encoded.end(), expected.begin(), expected.end());
+
+		// caller-provided buffer, with some extra room
+		std::vector<short> buffer(raw::HuffmanMaxCompressedSize(size) + 10, 0);
+		size_t const nWords
+			= raw::CompressHuffman(data.data(), data.size(), buffer.data());
+		BOOST_CHECK_LE(nWords, raw::HuffmanMaxCompressedSize(size));
+		BOOST_CHECK_EQUAL_COLLECTIONS(buffer.begin(), buffer.begin() + nWords,
+			expected.begin(), expected.end());
+	} // for sizes
+
+} // RunHuffmanEncoderComparison()
+
+
+BOOST_AUTO_TEST_CASE(HuffmanEncoderComparison) {
+
+	UniformNoiseCreator ConstantData("constant input data", 0., 41.);
+	RunHuffmanEncoderComparison(&ConstantData);
+
+	GaussianNoiseCreator SmallNoiseData("Gaussian small noise", 1.5, 400.);
+	RunHuffmanEncoderComparison(&SmallNoiseData);
+
+	GaussianNoiseCreator NegativeNoiseData("Gaussian negative noise", 5., -10.);
+	RunHuffmanEncoderComparison(&NegativeNoiseData);
+
+	SineWaveCreator SineData("High frequency pure sine wave", 16., 100.);
+	RunHuffmanEncoderComparison(&SineData);
+
+	RandomDataCreator RandomData("full range random data");
+	RunHuffmanEncoderComparison(&RandomData);
+
+} // BOOST_AUTO_TEST_CASE(HuffmanEncoderComparison)
+
+
+//------------------------------------------------------------------------------
+//--- zero suppression work space reuse
+//
+
+BOOST_AUTO_TEST_CASE(ZeroSuppressorReuse) {
+
+	GaussianNoiseCreator NoiseData("Gaussian noise", 3., 0.);
+
+	// the same suppressor is used on waveforms of different sizes
+	raw::ZeroSuppressor suppressor;
+	for (size_t const size: { 9600, 64, 30000, 9600, 3 }) {
+		const std::vector<short> data(NoiseData.create(size));
+
+		std::vector<short> reused(data);
+		suppressor.Suppress(reused, 5U, 2);
+
+		std::vector<short> fresh(data);
+		raw::ZeroSuppressor().Suppress(fresh, 5U, 2);
+		BOOST_CHECK_EQUAL_COLLECTIONS
+			(reused.begin(), reused.end(), fresh.begin(), fresh.end());
+
+		// samples are either preserved or suppressed
+		std::vector<short> data_again(size);
+		raw::Uncompress(reused, data_again, raw::kZeroSuppression);
+		BOOST_CHECK_EQUAL(data_again.size(), size);
+		for (size_t i = 0; i < size; ++i) {
+			if (data_again[i] != 0) BOOST_CHECK_EQUAL(data_again[i], data[i]);
+		} // for
+	} // for sizes
+
+} // BOOST_AUTO_TEST_CASE(ZeroSuppressorReuse)
+
+
+//------------------------------------------------------------------------------
+//--- over-threshold mask
+//
+
+BOOST_AUTO_TEST_CASE(OverThresholdMask) {
+
+	GaussianNoiseCreator NoiseData("Gaussian noise", 20., 400.);
+	const std::vector<short> data(NoiseData.create(1001));
+
+	for (int const pedestal: { 0, 400, 32760 }) {
+		for (unsigned int const threshold: { 0U, 5U, 30U, 100U, 40000U }) {
+			for (bool const sticky: { false, true }) {
+				for (bool const vectorized: { true, false }) {
+					std::vector<std::uint64_t> mask((data.size() + 63) / 64, 0U);
+					raw::AddOverThresholdMask(data.data(), data.size(),
+						pedestal, threshold, sticky, mask.data(), vectorized);
+					for (size_t i = 0; i < data.size(); ++i) {
+						bool const expected = raw::ADCStickyCodeCheck
+							(data[i], pedestal, sticky) > int(threshold);
+						bool const marked = (mask[i / 64] >> (i % 64)) & 1U;
+						BOOST_CHECK_EQUAL(marked, expected);
+					} // for samples
+				} // for vectorized
+			} // for sticky
+		} // for thresholds
+	} // for pedestals
+
+} // BOOST_AUTO_TEST_CASE(OverThresholdMask)
+
+
+//------------------------------------------------------------------------------
+//--- plane zero suppression
+//
+
+/// Checks SuppressPlane() against zero suppression of one channel at a time
+void RunPlaneZeroSuppressionTest(int pedestal, bool sticky) {
+
+	constexpr size_t nChannels = 20;
+	constexpr size_t nTicks = 2000;
+	constexpr int neighboringchannels = 2;
+	int nearestneighbor = 3;
+	unsigned int zerothreshold = 5;
+
+	GaussianNoiseCreator NoiseData("Gaussian noise", 2.5, pedestal);
+	std::vector<short> plane;
+	for (size_t c = 0; c < nChannels; ++c) {
+		const std::vector<short> channel(NoiseData.create(nTicks));
+		plane.insert(plane.end(), channel.begin(), channel.end());
+	} // for
+
+	std::vector<std::vector<short>> suppressed;
+	raw::ZeroSuppressor suppressor;
+	if (sticky) {
+		suppressor.SuppressPlane(plane.data(), nChannels, nTicks, zerothreshold,
+			pedestal, neighboringchannels, nearestneighbor, suppressed, true);
+	}
+	else {
+		suppressor.SuppressPlane(plane.data(), nChannels, nTicks, zerothreshold,
+			neighboringchannels, nearestneighbor, suppressed);
+	}
+	BOOST_CHECK_EQUAL(suppressed.size(), nChannels);
+
+	for (size_t c = 0; c < nChannels; ++c) {
+		boost::circular_buffer<std::vector<short>> neighbors(2*neighboringchannels+1);
+		for (int n = -neighboringchannels; n <= neighboringchannels; ++n) {
+			int const neighbor = int(c) + n;
+			if ((neighbor < 0) || (neighbor >= int(nChannels))) continue;
+			neighbors.push_back(std::vector<short>(plane.begin() + neighbor * nTicks,
+				plane.begin() + (neighbor + 1) * nTicks));
+		} // for neighbors
+
+		std::vector<short> expected
+			(plane.begin() + c * nTicks, plane.begin() + (c + 1) * nTicks);
+		if (sticky) {
+			raw::ZeroSuppression(neighbors, expected, zerothreshold, pedestal,
+				nearestneighbor, true);
+		}
+		else {
+			raw::ZeroSuppression
+				(neighbors, expected, zerothreshold, nearestneighbor);
+		}
+		BOOST_CHECK_EQUAL_COLLECTIONS(suppressed[c].begin(), suppressed[c].end(),
+			expected.begin(), expected.end());
+	} // for channels
+
+} // RunPlaneZeroSuppressionTest()
+
+
+BOOST_AUTO_TEST_CASE(PlaneZeroSuppression) {
+	RunPlaneZeroSuppressionTest(0, false);
+	RunPlaneZeroSuppressionTest(400, true);
+}
+
+
+//------------------------------------------------------------------------------
+//--- zero suppression of long waveforms
+//
+
+/// Checks the zero suppression of data with the specified mode
+void RunLongZeroSuppressionTest
+	(std::vector<short> const& data, raw::Compress_t mode)
+{
+	unsigned int zerothreshold = 5;
+
+	std::vector<short> buffer(data);
+	raw::Compress(buffer, mode, zerothreshold);
+	// the first word of Huffman-coded data is not encoded
+	if (mode == raw::kZeroSuppression) {
+		BOOST_CHECK_EQUAL(buffer[0] == raw::ZeroSuppressionLongMarker,
+			data.size() > raw::ZeroSuppressionMaxShortTicks);
+	}
+	else if (mode == raw::kZeroHuffman) {
+		BOOST_CHECK_EQUAL(buffer[0] == raw::ZeroSuppressionLongMarker,
+			data.size() > raw::ZeroHuffmanMaxShortTicks);
+	}
+
+	std::vector<short> data_again(data.size());
+	raw::Uncompress(buffer, data_again, mode);
+	BOOST_CHECK_EQUAL(data_again.size(), data.size());
+
+	// all samples above threshold are preserved, the others may be suppressed
+	for (size_t i = 0; i < data.size(); ++i) {
+		if (std::abs(data[i]) > int(zerothreshold))
+			BOOST_CHECK_EQUAL(data_again[i], data[i]);
+		else if (data_again[i] != 0)
+			BOOST_CHECK_EQUAL(data_again[i], data[i]);
+	} // for
+
+} // RunLongZeroSuppressionTest()
+
+
+BOOST_AUTO_TEST_CASE(LongZeroSuppression) {
+
+	GaussianNoiseCreator NoiseData("Gaussian noise", 2.5, 0.);
+
+	for (size_t const size
+		: { 9600, 16383, 16384, 20000, 32767, 32768, 100000, 1048576 })
+	{
+		const std::vector<short> data(NoiseData.create(size));
+		RunLongZeroSuppressionTest(data, raw::kZeroSuppression);
+		RunLongZeroSuppressionTest(data, raw::kZeroHuffman);
+	} // for
+
+} // BOOST_AUTO_TEST_CASE(LongZeroSuppression)
+
+
+//------------------------------------------------------------------------------
+//--- single-pass decoding of zero-suppressed, Huffman-encoded data
+//
+
+/// Checks that kZeroHuffman decoding matches Huffman decoding followed by
+/// zero unsuppression
+void RunZeroHuffmanDecodingTest
+	(std::vector<short> const& data, int pedestal, int nearestneighbor)
+{
+	unsigned int zerothreshold = 5;
+
+	std::vector<short> zs(data);
+	raw::ZeroSuppression(zs, zerothreshold, pedestal, nearestneighbor, false);
+	std::vector<short> buffer(zs);
+	raw::CompressHuffman(buffer);
+
+	// two steps, through the zero-suppressed data
+	std::vector<short> zs_again(zs.size());
+	raw::UncompressHuffman(buffer, zs_again);
+	BOOST_CHECK(zs_again == zs);
+	std::vector<short> expected;
+	raw::ZeroUnsuppression(zs_again, expected, pedestal);
+
+	// single pass, into a buffer of unrelated size and content
+	std::vector<short> data_again(7, -1);
+	raw::Uncompress(buffer, data_again, pedestal, raw::kZeroHuffman);
+	BOOST_CHECK_EQUAL_COLLECTIONS
+		(data_again.begin(), data_again.end(), expected.begin(), expected.end());
+
+} // RunZeroHuffmanDecodingTest()
+
+
+BOOST_AUTO_TEST_CASE(ZeroHuffmanDecoding) {
+
+	for (int const pedestal: { 0, 400 }) {
+		GaussianNoiseCreator NoiseData("Gaussian noise", 3., pedestal);
+		for (size_t const size: { 1, 9, 9600, 40000 }) {
+			const std::vector<short> data(NoiseData.create(size));
+			for (int const nearestneighbor: { 0, 3 })
+				RunZeroHuffmanDecodingTest(data, pedestal, nearestneighbor);
+		} // for sizes
+	} // for pedestals
+
+} // BOOST_AUTO_TEST_CASE(ZeroHuffmanDecoding)
+
+
+//------------------------------------------------------------------------------
+//--- uncompression of windows of ticks
+//
+
+/// Checks that windows of the data match the fully uncompressed waveform
+void RunWindowUncompressionTest
+	(std::vector<short> const& data, raw::Compress_t mode, int pedestal)
+{
+	unsigned int zerothreshold = 5;
+	int nearestneighbor = 2;
+
+	std::vector<short> buffer(data);
+	raw::Compress(buffer, mode, zerothreshold, pedestal, nearestneighbor);
+	raw::HuffmanIndex const index = raw::MakeHuffmanIndex(buffer, 16);
+
+	std::vector<short> full(data.size());
+	raw::Uncompress(buffer, full, pedestal, mode);
+
+	size_t const size = data.size();
+	std::vector<std::pair<size_t, size_t>> const windows {
+		{ 0, size }, { 0, 1 }, { size / 3, size / 2 }, { size - 1, size },
+		{ size / 2, size + 100 }, { size + 5, size + 10 }, { 7, 7 }, { 9, 3 },
+		// open windows: the end of the data is found while decoding
+		{ 0, std::numeric_limits<size_t>::max() },
+		{ size / 2, std::numeric_limits<size_t>::max() },
+		{ std::numeric_limits<size_t>::max() - 1, std::numeric_limits<size_t>::max() }
+	};
+
+	for (auto const& window: windows) {
+		size_t const end = std::min(window.second, size);
+		size_t const begin = std::min(window.first, end);
+		for (raw::HuffmanIndex const* pIndex: { (raw::HuffmanIndex const*) nullptr, &index }) {
+			std::vector<short> part(3, -1);
+			raw::Uncompress
+				(buffer, part, pedestal, mode, window.first, window.second, pIndex);
+			BOOST_CHECK_EQUAL_COLLECTIONS(part.begin(), part.end(),
+				full.begin() + begin, full.begin() + end);
+		} // for index
+	} // for windows
+
+} // RunWindowUncompressionTest()
+
+
+BOOST_AUTO_TEST_CASE(WindowUncompression) {
+
+	for (int const pedestal: { 0, 400 }) {
+		GaussianNoiseCreator NoiseData("Gaussian noise", 3., pedestal);
+		for (size_t const size: { 3, 9600, 40000 }) {
+			const std::vector<short> data(NoiseData.create(size));
+			for (raw::Compress_t const mode: { raw::kNone, raw::kHuffman,
+				raw::kZeroSuppression, raw::kZeroHuffman })
+				RunWindowUncompressionTest(data, mode, pedestal);
+		} // for sizes
+	} // for pedestals
+
+} // BOOST_AUTO_TEST_CASE(WindowUncompression)
+
+
+//------------------------------------------------------------------------------
+//--- chunked Huffman encoding and parallel decoding
+//
+
+/// Checks chunked encoding and parallel decoding against the plain ones
+void RunChunkedHuffmanTest(std::vector<short> const& data, size_t chunkTicks) {
+
+	std::vector<short> plain(data);
+	raw::CompressHuffman(plain);
+
+	std::vector<short> chunked(data);
+	raw::HuffmanIndex chunkIndex;
+	raw::CompressHuffmanChunked(chunked, chunkTicks, chunkIndex);
+	BOOST_CHECK_EQUAL
+		(chunkIndex.size(), (data.size() + chunkTicks - 1) / chunkTicks - 1);
+	BOOST_CHECK_LE(chunked.size(), data.size() + 1);
+
+	// chunked data is plain Huffman-encoded data
+	std::vector<short> decoded(data.size());
+	raw::UncompressHuffman(chunked, decoded);
+	BOOST_CHECK_EQUAL_COLLECTIONS
+		(decoded.begin(), decoded.end(), data.begin(), data.end());
+
+	// by default, only the calling thread decodes
+	std::vector<short> serial(data.size(), -1);
+	raw::UncompressHuffman(chunked, serial, chunkIndex);
+	BOOST_CHECK_EQUAL_COLLECTIONS
+		(serial.begin(), serial.end(), data.begin(), data.end());
+
+	for (unsigned int const nThreads: { 0U, 1U, 3U, 8U }) {
+		std::vector<short> parallel(data.size(), -1);
+		raw::UncompressHuffman(chunked, parallel, chunkIndex, nThreads);
+		BOOST_CHECK_EQUAL_COLLECTIONS
+			(parallel.begin(), parallel.end(), data.begin(), data.end());
+
+		// any index works, including one of plain Huffman-encoded data
+		std::fill(parallel.begin(), parallel.end(), -1);
+		raw::UncompressHuffman
+			(plain, parallel, raw::MakeHuffmanIndex(plain, 100), nThreads);
+		BOOST_CHECK_EQUAL_COLLECTIONS
+			(parallel.begin(), parallel.end(), data.begin(), data.end());
+	} // for threads
+
+} // RunChunkedHuffmanTest()
+
+
+BOOST_AUTO_TEST_CASE(ChunkedHuffman) {
+
+	GaussianNoiseCreator NoiseData("Gaussian noise", 3., 400.);
+	SineWaveCreator SineData("Low frequency pure sine wave", 128., 100.);
+
+	for (size_t const size: { 1, 5, 9600, 100000 }) {
+		for (size_t const chunkTicks: { 1, 4, 1000, 4096 }) {
+			RunChunkedHuffmanTest(NoiseData.create(size), chunkTicks);
+			RunChunkedHuffmanTest(SineData.create(size), chunkTicks);
+		} // for chunk sizes
+	} // for sizes
+
+} // BOOST_AUTO_TEST_CASE(ChunkedHuffman)
+
+
+//------------------------------------------------------------------------------
+//--- compression of many channels at once
+//
+
+BOOST_AUTO_TEST_CASE(BatchCompression) {
+
+	unsigned int zerothreshold = 5;
+	int nearestneighbor = 2;
+	constexpr float pedestal = 400.;
+
+	GaussianNoiseCreator NoiseData("Gaussian noise", 3., pedestal);
+	std::vector<std::vector<short>> channels;
+	std::vector<raw::RawDigit> digits;
+	for (size_t i = 0; i < 50; ++i) {
+		channels.push_back(NoiseData.create(100 + 97 * i));
+		digits.emplace_back(raw::ChannelID_t(i), channels.back().size(), channels.back());
+		digits.back().SetPedestal(pedestal, 3.);
+	} // for
+
+	for (raw::Compress_t const mode: { raw::kNone, raw::kHuffman,
+		raw::kZeroSuppression, raw::kZeroHuffman })
+	{
+		// expected results, one channel at a time
+		std::vector<std::vector<short>> expected(channels), expectedPed(channels);
+		for (size_t i = 0; i < channels.size(); ++i) {
+			raw::Compress(expected[i], mode, zerothreshold, nearestneighbor);
+			raw::Compress(expectedPed[i], mode, zerothreshold, int(pedestal), nearestneighbor);
+		}
+
+		for (unsigned int const nThreads: { 0U, 1U, 4U }) {
+			std::vector<std::vector<short>> compressed(channels);
+			raw::CompressAll(compressed, mode, zerothreshold, nearestneighbor, nThreads);
+			BOOST_CHECK(compressed == expected);
+
+			std::vector<std::vector<short>> uncompressed;
+			for (auto const& channel: channels)
+				uncompressed.emplace_back(channel.size());
+			raw::UncompressAll(compressed, uncompressed, mode, nThreads);
+			for (size_t i = 0; i < channels.size(); ++i) {
+				std::vector<short> expectedADC(channels[i].size());
+				raw::Uncompress(expected[i], expectedADC, mode);
+				BOOST_CHECK(uncompressed[i] == expectedADC);
+			}
+
+			std::vector<raw::RawDigit> const compressedDigits
+				= raw::CompressAll(digits, mode, zerothreshold, nearestneighbor, nThreads);
+			BOOST_CHECK_EQUAL(compressedDigits.size(), digits.size());
+			for (size_t i = 0; i < digits.size(); ++i) {
+				BOOST_CHECK_EQUAL(compressedDigits[i].Channel(), digits[i].Channel());
+				BOOST_CHECK_EQUAL(compressedDigits[i].Samples(), digits[i].Samples());
+				BOOST_CHECK_EQUAL(compressedDigits[i].GetPedestal(), pedestal);
+				BOOST_CHECK_EQUAL(compressedDigits[i].Compression(), mode);
+				BOOST_CHECK(compressedDigits[i].ADCs() == expectedPed[i]);
+			}
+
+			std::vector<std::vector<short>> const digitADCs
+				= raw::UncompressAll(compressedDigits, nThreads);
+			for (size_t i = 0; i < digits.size(); ++i) {
+				std::vector<short> expectedADC(channels[i].size());
+				raw::Uncompress(expectedPed[i], expectedADC, int(pedestal), mode);
+				BOOST_CHECK(digitADCs[i] == expectedADC);
+			}
+
+			// compressing again starts from the uncompressed waveforms
+			std::vector<raw::RawDigit> const recompressedDigits = raw::CompressAll
+				(compressedDigits, mode, zerothreshold, nearestneighbor, nThreads);
+			for (size_t i = 0; i < digits.size(); ++i) {
+				std::vector<short> expectedADC(digitADCs[i]);
+				raw::Compress
+					(expectedADC, mode, zerothreshold, int(pedestal), nearestneighbor);
+				BOOST_CHECK(recompressedDigits[i].ADCs() == expectedADC);
+			}
+		} // for threads
+	} // for modes
+
+	// many callers at the same time share the worker threads
+	std::vector<std::vector<short>> expected(channels);
+	raw::CompressAll(expected, raw::kZeroHuffman, zerothreshold, nearestneighbor);
+	std::vector<std::vector<std::vector<short>>> results(4, channels);
+	std::vector<std::thread> callers;
+	for (auto& result: results) {
+		callers.emplace_back([&result, zerothreshold, nearestneighbor]()
+			{
+				for (unsigned int i = 0; i < 5; ++i) {
+					std::vector<std::vector<short>> compressed(result);
+					raw::CompressAll
+						(compressed, raw::kZeroHuffman, zerothreshold, nearestneighbor, 3);
+					if (i == 4) result = std::move(compressed);
+				}
+			});
+	} // for
+	for (std::thread& caller: callers) caller.join();
+	for (auto const& result: results) BOOST_CHECK(result == expected);
+
+	// mismatching buffers
+	std::vector<std::vector<short>> uncompressed(3);
+	BOOST_CHECK_THROW(raw::UncompressAll(channels, uncompressed, raw::kNone), cet::exception);
+
+} // BOOST_AUTO_TEST_CASE(BatchCompression)
+
+
+//------------------------------------------------------------------------------
+//--- registration of compression algorithms
+//
+
+/// Stores each sample as its difference from the previous one
+class DifferenceCodec: public raw::Codec {
+		public:
+	void Encode(std::vector<short>& adc, raw::CodecParameters const&) const override
+		{ std::adjacent_difference(adc.begin(), adc.end(), adc.begin()); }
+
+	void Decode(std::vector<short> const& adc, std::vector<short>& uncompressed, int) const override
+		{
+			std::partial_sum(adc.begin(), adc.end(), uncompressed.begin(),
+				[](short a, short b){ return short(a + b); });
+		}
+
+	void DecodeRange(std::vector<short> const& adc, std::vector<short>& uncompressed,
+		int pedestal, size_t tickBegin, size_t tickEnd, raw::HuffmanIndex const*) const override
+		{
+			std::vector<short> all(adc.size());
+			Decode(adc, all, pedestal);
+			tickEnd = std::min(tickEnd, all.size());
+			tickBegin = std::min(tickBegin, tickEnd);
+			uncompressed.assign(all.begin() + tickBegin, all.begin() + tickEnd);
+		}
+}; // class DifferenceCodec
+
+
+BOOST_AUTO_TEST_CASE(CodecRegistry) {
+
+	raw::CodecRegistry& registry = raw::CodecRegistry::Instance();
+
+	// the built-in codecs give the same results as raw::Compress()
+	GaussianNoiseCreator NoiseData("Gaussian noise", 2., 400.);
+	std::vector<short> data = NoiseData.create(4096);
+	for (size_t pulse = 300; pulse < data.size(); pulse += 700)
+		for (size_t i = 0; i < 20; ++i) data[pulse + i] += 50;
+	for (raw::Compress_t mode: { raw::kNone, raw::kHuffman,
+		raw::kZeroSuppression, raw::kZeroHuffman })
+	{
+		raw::Codec const* codec = registry.Find(mode);
+		BOOST_REQUIRE(codec);
+		BOOST_CHECK_EQUAL(&registry.Get(mode), codec);
+
+		unsigned int zerothreshold = 10;
+		int nearestneighbor = 2;
+		raw::CodecParameters params;
+		params.zerothreshold = zerothreshold;
+		params.pedestal = 400;
+		params.nearestneighbor = nearestneighbor;
+
+		std::vector<short> expected(data), encoded(data);
+		raw::Compress(expected, mode, zerothreshold, 400, nearestneighbor);
+		codec->Encode(encoded, params);
+		BOOST_CHECK(encoded == expected);
+
+		std::vector<short> expectedADC(data.size()), decoded(data.size());
+		raw::Uncompress(expected, expectedADC, 400, mode);
+		codec->Decode(encoded, decoded, 400);
+		BOOST_CHECK(decoded == expectedADC);
+	} // for modes
+
+	BOOST_CHECK_THROW
+		(registry.Register(raw::kHuffman, std::make_unique<DifferenceCodec>()), cet::exception);
+
+	// a new compression type
+	BOOST_CHECK(!registry.Find(raw::kDynamicDec));
+	BOOST_CHECK_THROW(registry.Get(raw::kDynamicDec), cet::exception);
+	std::vector<short> unknown(data), unknownADC(data.size());
+	raw::Compress(unknown, raw::kDynamicDec);
+	BOOST_CHECK(unknown == data);
+	BOOST_CHECK_THROW(raw::Uncompress(unknown, unknownADC, raw::kDynamicDec), cet::exception);
+
+	BOOST_CHECK_THROW(registry.Register(raw::kDynamicDec, nullptr), cet::exception);
+	registry.Register(raw::kDynamicDec, std::make_unique<DifferenceCodec>());
+	BOOST_CHECK(registry.Find(raw::kDynamicDec));
+
+	std::vector<short> compressed(data);
+	raw::Compress(compressed, raw::kDynamicDec);
+	BOOST_CHECK(compressed != data);
+	std::vector<short> uncompressed(data.size());
+	raw::Uncompress(compressed, uncompressed, raw::kDynamicDec);
+	BOOST_CHECK(uncompressed == data);
+
+	std::vector<short> window;
+	raw::Uncompress(compressed, window, raw::kDynamicDec, 100, 200);
+	BOOST_CHECK(std::equal(window.begin(), window.end(), data.begin() + 100, data.begin() + 200));
+	BOOST_CHECK_EQUAL(window.size(), 100U);
+
+	std::vector<std::vector<short>> channels(3, data);
+	raw::CompressAll(channels, raw::kDynamicDec, 5, 0, 2);
+	BOOST_CHECK(channels[2] == compressed);
+
+} // BOOST_AUTO_TEST_CASE(CodecRegistry)
+
+
+//------------------------------------------------------------------------------
+//--- canonical Huffman coding with fitted model
+//
+
+/**
+ * @brief Compresses with raw::CompressEntropy() and uncompresses back
+ * @param pDataCreator an object to create the input data set
+ * @return the number of words of the compressed data
+ *
+ * The size of the data is printed, together with the one from
+ * raw::CompressHuffman().
+ */
+size_t RunEntropyCodingTest(DataCreatorBase* pDataCreator) {
+
+	constexpr size_t size = 1048576;
+	const std::vector<short> data(pDataCreator->create(size));
+
+	std::vector<short> encoded(data);
+	raw::CompressEntropy(encoded);
+
+	std::vector<short> decoded;
+	raw::UncompressEntropy(encoded, decoded);
+	BOOST_CHECK_EQUAL_COLLECTIONS
+		(decoded.begin(), decoded.end(), data.begin(), data.end());
+
+	std::vector<short> huffman(data);
+	raw::CompressHuffman(huffman);
+	std::cout << pDataCreator->name() << ": " << encoded.size()
+		<< " words (Huffman: " << huffman.size() << " words)" << std::endl;
+
+	return encoded.size();
+} // RunEntropyCodingTest()
+
+
+BOOST_AUTO_TEST_CASE(EntropyCoding) {
+
+	UniformNoiseCreator ConstantData("constant input data", 0., 41.);
+	RunEntropyCodingTest(&ConstantData);
+
+	GaussianNoiseCreator SmallNoiseData("Gaussian small noise", 1.5, 400.);
+	size_t const smallNoiseSize = RunEntropyCodingTest(&SmallNoiseData);
+	std::vector<short> smallNoise(SmallNoiseData.create(1048576));
+	raw::CompressHuffman(smallNoise);
+	BOOST_CHECK_LT(smallNoiseSize, smallNoise.size());
+
+	GaussianNoiseCreator LargeNoiseData("Gaussian large noise", 5., 400.);
+	RunEntropyCodingTest(&LargeNoiseData);
+
+	GaussianNoiseCreator VeryLargeNoiseData("Gaussian very large noise", 50., 2000.);
+	RunEntropyCodingTest(&VeryLargeNoiseData);
+
+	SineWaveCreator SineData("Low frequency pure sine wave", 128., 100.);
+	RunEntropyCodingTest(&SineData);
+
+	RandomDataCreator RandomData("random data");
+	RunEntropyCodingTest(&RandomData);
+
+	// short waveforms
+	for (size_t size: { 0, 1, 2, 3 }) {
+		std::vector<short> const data(RandomData.create(size));
+		std::vector<short> encoded(data), decoded;
+		raw::CompressEntropy(encoded);
+		raw::UncompressEntropy(encoded, decoded);
+		BOOST_CHECK(decoded == data);
+	} // for
+
+	// a model shared by many waveforms; differences it has no code for are escaped
+	std::vector<std::vector<short>> plane;
+	for (size_t i = 0; i < 20; ++i) plane.push_back(SmallNoiseData.create(1000));
+	raw::EntropyModel const planeModel(plane);
+	plane.push_back(LargeNoiseData.create(1000));
+	for (auto const& data: plane) {
+		std::vector<short> encoded(data), decoded;
+		raw::CompressEntropy(encoded, planeModel);
+		raw::UncompressEntropy(encoded, decoded);
+		BOOST_CHECK(decoded == data);
+	} // for
+
+	// a model with only the escape code
+	raw::EntropyModel::CodeLengths_t lengths;
+	lengths.fill(0);
+	lengths[raw::EntropyModel::EscapeSymbol] = 1;
+	std::vector<short> escaped(plane.front()), decoded;
+	raw::CompressEntropy(escaped, raw::EntropyModel(lengths));
+	raw::UncompressEntropy(escaped, decoded);
+	BOOST_CHECK(decoded == plane.front());
+
+	// invalid models and data
+	lengths.fill(1);
+	BOOST_CHECK_THROW(raw::EntropyModel{ lengths }, cet::exception);
+	lengths.fill(0);
+	lengths[raw::EntropyModel::Symbol(0)] = 1;
+	BOOST_CHECK_THROW(raw::EntropyModel{ lengths }, cet::exception);
+
+	std::vector<short> truncated(plane.front());
+	raw::CompressEntropy(truncated);
+	truncated.resize(truncated.size() / 2);
+	BOOST_CHECK_THROW(raw::UncompressEntropy(truncated, decoded), cet::exception);
+
+	// the codec, which is not registered by default
+	raw::EntropyCodec const codec;
+	std::vector<short> encoded(plane.front()), window;
+	codec.Encode(encoded, raw::CodecParameters{});
+	codec.Decode(encoded, decoded, 0);
+	BOOST_CHECK(decoded == plane.front());
+	codec.DecodeRange(encoded, window, 0, 900, 1100, nullptr);
+	BOOST_CHECK_EQUAL(window.size(), 100U);
+	BOOST_CHECK(std::equal(window.begin(), window.end(), plane.front().begin() + 900));
+
+} // BOOST_AUTO_TEST_CASE(EntropyCoding)
+
+
+//------------------------------------------------------------------------------
+//--- compression of channels with coherent noise
+//
+
+BOOST_AUTO_TEST_CASE(CoherentCompression) {
+
+	constexpr size_t nChannels = 100;
+	constexpr size_t nTicks = 6000;
+	constexpr unsigned int groupSize = 16;
+
+	// each group of channels shares a slowly changing noise
+	std::normal_distribution<float> whiteNoise(0., 2.);
+	std::normal_distribution<float> coherentStep(0., 5.);
+	std::vector<raw::ChannelID_t> channels;
+	std::vector<std::vector<short>> adcs(nChannels, std::vector<short>(nTicks));
+	for (size_t first = 0; first < nChannels; first += groupSize) {
+		float coherent = 0.;
+		for (size_t tick = 0; tick < nTicks; ++tick) {
+			coherent = 0.95 * coherent + coherentStep(DataCreatorBase::random_engine);
+			for (size_t i = first; i < std::min<size_t>(first + groupSize, nChannels); ++i) {
+				adcs[i][tick] = short(std::round
+					(400. + i % 7 + coherent + whiteNoise(DataCreatorBase::random_engine)));
+			}
+		} // for ticks
+	} // for groups
+	for (size_t i = 0; i < nChannels; ++i) channels.push_back(raw::ChannelID_t(1000 + i));
+	adcs[3][100] = std::numeric_limits<short>::min(); // differences wrap around
+	adcs[4][100] = std::numeric_limits<short>::max();
+
+	raw::CompressedDigitBlock const block
+		= raw::CompressCoherent(channels, adcs, groupSize);
+	BOOST_CHECK(block.Channels() == channels);
+	BOOST_CHECK_EQUAL(block.Samples(), nTicks);
+	BOOST_CHECK_EQUAL(block.NGroups(), (nChannels + groupSize - 1) / groupSize);
+	BOOST_CHECK(raw::UncompressCoherent(block) == adcs);
+	for (size_t i: { size_t(0), size_t(3), size_t(17), nChannels - 1 }) {
+		std::vector<short> adc;
+		raw::UncompressCoherent(block, i, adc);
+		BOOST_CHECK(adc == adcs[i]);
+	}
+
+	size_t entropySize = 0;
+	for (auto const& adc: adcs) {
+		std::vector<short> encoded(adc);
+		raw::CompressEntropy(encoded);
+		entropySize += encoded.size();
+	}
+	std::cout << "Coherent noise: " << block.Data().size() << " words ("
+		<< entropySize << " compressing each channel)" << std::endl;
+	BOOST_CHECK_LT(block.Data().size(), entropySize);
+
+	// from raw digits, also compressed
+	std::vector<raw::RawDigit> digits;
+	for (size_t i = 0; i < nChannels; ++i) {
+		// the extreme values can't be Huffman-encoded
+		raw::Compress_t const compress = (i < 5)? raw::kNone: raw::kHuffman;
+		std::vector<short> adc(adcs[i]);
+		raw::Compress(adc, compress);
+		digits.emplace_back(channels[i], nTicks, std::move(adc), compress);
+	}
+	BOOST_CHECK(raw::UncompressCoherent(raw::CompressCoherent(digits, 7)) == adcs);
+
+	// special cases
+	raw::CompressedDigitBlock const empty = raw::CompressCoherent({}, {}, groupSize);
+	BOOST_CHECK_EQUAL(empty.NChannels(), 0U);
+	BOOST_CHECK(raw::UncompressCoherent(empty).empty());
+	BOOST_CHECK_THROW(raw::CompressCoherent(channels, adcs, 0), cet::exception);
+	channels.pop_back();
+	BOOST_CHECK_THROW(raw::CompressCoherent(channels, adcs, groupSize), cet::exception);
+	channels.push_back(0);
+	adcs.back().pop_back();
+	BOOST_CHECK_THROW(raw::CompressCoherent(channels, adcs, groupSize), cet::exception);
+	std::vector<short> adc;
+	BOOST_CHECK_THROW(raw::UncompressCoherent(block, nChannels, adc), cet::exception);
+	std::vector<ULong64_t> offsets(block.Offsets());
+	offsets.pop_back();
+	BOOST_CHECK_THROW(raw::CompressedDigitBlock
+		(block.Channels(), nTicks, groupSize, block.Data(), offsets), cet::exception);
+
+} // BOOST_AUTO_TEST_CASE(CoherentCompression)
+
+
+//------------------------------------------------------------------------------
+//--- compression with bounded error
+//
+
+BOOST_AUTO_TEST_CASE(BoundedErrorCompression) {
+
+	constexpr size_t nTicks = 6400;
+	constexpr int pedestal = 400;
+	GaussianNoiseCreator NoiseData("Gaussian noise", 2.5, pedestal);
+	std::vector<short> data = NoiseData.create(nTicks);
+	for (size_t tick = 2000; tick < 2040; ++tick) data[tick] += 200 - 10 * std::abs(int(tick) - 2020);
+	data[5000] = std::numeric_limits<short>::min();
+	data[5001] = std::numeric_limits<short>::max();
+
+	raw::CodecParameters params;
+	params.zerothreshold = 10;
+	params.pedestal = pedestal;
+	params.nearestneighbor = 3;
+
+	std::vector<short> lossless(data);
+	raw::CompressEntropy(lossless);
+
+	for (unsigned int maxError: { 0U, 1U, 2U, 4U }) {
+		std::vector<short> compressed(data);
+		raw::LossyErrorReport const report
+			= raw::CompressBoundedError(compressed, maxError, params);
+		std::vector<short> uncompressed;
+		raw::UncompressBoundedError(compressed, uncompressed);
+		BOOST_REQUIRE_EQUAL(uncompressed.size(), data.size());
+
+		raw::LossyErrorReport const check = raw::CompareWaveforms(data, uncompressed);
+		BOOST_CHECK_LE(check.maxAbsError, maxError);
+		BOOST_CHECK_EQUAL(check.maxAbsError, report.maxAbsError);
+		BOOST_CHECK_EQUAL(check.nChanged, report.nChanged);
+		BOOST_CHECK_CLOSE(check.rmsError, report.rmsError, 1e-6);
+		BOOST_CHECK_EQUAL(report.nSamples, nTicks);
+		BOOST_CHECK_GE(report.nExact, 40U + 2 * 3 + 2);
+
+		// the signal and its neighbourhood are exact
+		for (size_t tick = 1990; tick < 2050; ++tick) {
+			if (std::abs(data[tick] - pedestal) > 10)
+				for (size_t i = tick - 3; i <= tick + 3; ++i) BOOST_CHECK_EQUAL(uncompressed[i], data[i]);
+		}
+		BOOST_CHECK_EQUAL(uncompressed[5000], data[5000]);
+		BOOST_CHECK_EQUAL(uncompressed[5001], data[5001]);
+
+		if (maxError == 0) BOOST_CHECK(uncompressed == data);
+		else BOOST_CHECK_LT(compressed.size(), lossless.size());
+		std::cout << "Maximum error " << maxError << ": " << compressed.size()
+			<< " words (lossless: " << lossless.size() << "), RMS error "
+			<< report.rmsError << std::endl;
+	} // for
+
+	// pedestal from the data, no neighbours
+	std::vector<short> compressed(data), uncompressed;
+	raw::CompressBoundedError(compressed, 1, raw::CodecParameters{});
+	raw::UncompressBoundedError(compressed, uncompressed);
+	BOOST_CHECK_LE(raw::CompareWaveforms(data, uncompressed).maxAbsError, 1U);
+
+	// through the codec
+	raw::BoundedErrorCodec const codec(2);
+	compressed = data;
+	codec.Encode(compressed, params);
+	codec.Decode(compressed, uncompressed, 0);
+	BOOST_CHECK_LE(raw::CompareWaveforms(data, uncompressed).maxAbsError, 2U);
+	std::vector<short> window;
+	codec.DecodeRange(compressed, window, 0, 100, 200, nullptr);
+	BOOST_CHECK(std::equal(window.begin(), window.end(), uncompressed.begin() + 100));
+
+	// special cases
+	for (size_t size: { 0, 1, 2 }) {
+		std::vector<short> const shortData(data.begin(), data.begin() + size);
+		compressed = shortData;
+		raw::CompressBoundedError(compressed, 3, params);
+		raw::UncompressBoundedError(compressed, uncompressed);
+		BOOST_CHECK_EQUAL(uncompressed.size(), size);
+		if (size > 0) BOOST_CHECK_EQUAL(uncompressed[0], shortData[0]);
+	}
+	compressed = data;
+	BOOST_CHECK_THROW(raw::CompressBoundedError(compressed, 20000, params), cet::exception);
+	BOOST_CHECK_THROW(raw::BoundedErrorCodec(20000), cet::exception);
+	BOOST_CHECK_THROW(raw::CompareWaveforms(data, window), cet::exception);
+
+} // BOOST_AUTO_TEST_CASE(BoundedErrorCompression)
+
+
+//------------------------------------------------------------------------------
+//--- ADC sticky codes
+//
+
+/// The original implementation of raw::ADCStickyCodeCheck()
+int ReferenceADCStickyCodeCheck(short adc_value, int pedestal, bool fADCStickyCodeFeature) {
+	int adc_return_value = std::abs(adc_value - pedestal);
+	if (!fADCStickyCodeFeature) return adc_return_value;
+	unsigned int sixlsbs = adc_value & raw::onemask;
+	if ((sixlsbs == raw::onemask || sixlsbs == 0) && std::abs(adc_value - pedestal) < 64)
+		adc_return_value = 0;
+	return adc_return_value;
+} // ReferenceADCStickyCodeCheck()
+
+
+BOOST_AUTO_TEST_CASE(ADCStickyCodes) {
+
+	std::vector<short> allValues;
+	for (int value = std::numeric_limits<short>::min(); value <= std::numeric_limits<short>::max(); ++value)
+		allValues.push_back(short(value));
+
+	for (int pedestal: { -100, 0, 30, 400, 2048, 4095, 4150, 32700 }) {
+		for (bool sticky: { false, true }) {
+			raw::ADCStickyCodeTable const table(pedestal, sticky);
+			BOOST_CHECK_EQUAL(table.Pedestal(), pedestal);
+			BOOST_CHECK_EQUAL(table.StickyCodeFeature(), sticky);
+
+			std::vector<int> const magnitudes
+				= raw::ADCStickyCodeMagnitudes(allValues, pedestal, sticky);
+			std::vector<int> tableMagnitudes(allValues.size());
+			table.Magnitudes(allValues.data(), allValues.size(), tableMagnitudes.data());
+
+			size_t nErrors = 0;
+			for (size_t i = 0; i < allValues.size(); ++i) {
+				int const expected = ReferenceADCStickyCodeCheck(allValues[i], pedestal, sticky);
+				if ((raw::ADCStickyCodeCheck(allValues[i], pedestal, sticky) != expected)
+					|| (magnitudes[i] != expected) || (tableMagnitudes[i] != expected)
+					|| (table(allValues[i]) != expected)
+				) ++nErrors;
+			} // for
+			BOOST_CHECK_EQUAL(nErrors, 0U);
+		} // for sticky
+	} // for pedestals
+
+} // BOOST_AUTO_TEST_CASE(ADCStickyCodes)
+
+
+//------------------------------------------------------------------------------
+//--- zero suppression comparison with the original implementation
+//
+
+/**
+ * @brief Original zero suppression, kept as reference
+ *
+ * These are verbatim copies of raw::ADCStickyCodeCheck() and of the five
+ * raw::ZeroSuppression() overloads before they were replaced by the ones
+ * based on raw::ZeroSuppressor (only the namespace changed).
+ * They support waveforms up to 32767 ticks.
+ */
+namespace reference {
+
+  using raw::onemask;
+
+  int ADCStickyCodeCheck(const short adc_value,
+			 const int pedestal,
+			 bool fADCStickyCodeFeature){
+
+    int adc_return_value = std::abs(adc_value - pedestal);
+
+      if(!fADCStickyCodeFeature){
+	return adc_return_value;
+      }
+     // if DUNE 35t ADC sticky code feature is enabled in simulation, skip over ADC codes with LSBs of 0x00 or 0x3f
+      unsigned int sixlsbs = adc_value & onemask;
+
+      if((sixlsbs==onemask || sixlsbs==0) && std::abs(adc_value - pedestal) < 64){
+	adc_return_value = 0; //set current adc value to zero if its LSBs are at sticky values and if it is within one MSB cell (64 ADC counts) of the pedestal value
+      }
+      return adc_return_value;
+  }
+
+  //----------------------------------------------------------
+  // Zero suppression function
+  void ZeroSuppression(std::vector<short> &adc,
+		       unsigned int       &zerothreshold)
+  {
+    const int adcsize = adc.size();
+    const int zerothresholdsigned = zerothreshold;
+
+    std::vector<short> zerosuppressed(adc.size());
+    int maxblocks = adcsize/2 + 1;
+    std::vector<short> blockbegin(maxblocks);
+    std::vector<short> blocksize(maxblocks);
+
+    unsigned int nblocks = 0;
+    unsigned int zerosuppressedsize = 0;
+
+    int blockcheck = 0;
+
+    for(int i = 0; i < adcsize; ++i){
+      int adc_current_value = std::abs(adc[i]);
+
+      if(adc_current_value > zerothresholdsigned){
+
+	if(blockcheck == 0){
+
+	  blockbegin[nblocks] = i;
+	  blocksize[nblocks] = 0;
+	  blockcheck=1;
+	}
+
+	zerosuppressed[zerosuppressedsize] = adc[i];
+	zerosuppressedsize++;
+	blocksize[nblocks]++;
+
+	if(i == adcsize-1) nblocks++;
+      }
+
+      if(adc_current_value <= zerothresholdsigned && blockcheck == 1){
+	  zerosuppressed[zerosuppressedsize] = adc[i];
+	  zerosuppressedsize++;
+	  blocksize[nblocks]++;
+	  nblocks++;
+	  blockcheck = 0;
+      }
+    }
+
+
+
+    adc.resize(2+nblocks+nblocks+zerosuppressedsize);
+
+    adc[0] = adcsize; //fill first entry in adc with length of uncompressed vector
+    adc[1] = nblocks;
+
+
+
+    for(unsigned int i = 0; i < nblocks; ++i)
+      adc[i+2] = blockbegin[i];
+
+    for(unsigned int i = 0; i < nblocks; ++i)
+      adc[i+nblocks+2] = blocksize[i];
+
+    for(unsigned int i = 0; i < zerosuppressedsize; ++i)
+      adc[i+nblocks+nblocks+2] = zerosuppressed[i];
+
+
+  }
+
+
+
+  //----------------------------------------------------------
+  // Zero suppression function which merges blocks if they are
+  // within parameter nearestneighbor of each other
+  void ZeroSuppression(std::vector<short> &adc,
+		       unsigned int       &zerothreshold,
+		       int                &nearestneighbor)
+  {
+
+    const int adcsize = adc.size();
+    const int zerothresholdsigned = zerothreshold;
+
+    std::vector<short> zerosuppressed(adcsize);
+    int maxblocks = adcsize/2 + 1;
+    std::vector<short> blockbegin(maxblocks);
+    std::vector<short> blocksize(maxblocks);
+
+    int nblocks = 0;
+    int zerosuppressedsize = 0;
+
+    int blockstartcheck = 0;
+    int endofblockcheck = 0;
+
+    for(int i = 0; i < adcsize; ++i){
+      int adc_current_value = std::abs(adc[i]);
+
+      if(blockstartcheck==0){
+	if(adc_current_value>zerothresholdsigned){
+	  if(nblocks>0){
+	    if((i-nearestneighbor)<=(blockbegin[nblocks-1]+blocksize[nblocks-1]+1)){
+
+	      nblocks--;
+	      blocksize[nblocks] = i - blockbegin[nblocks] + 1;
+	      blockstartcheck = 1;
+	    }
+	    else{
+	      blockbegin[nblocks] = (i - nearestneighbor > 0) ? i - nearestneighbor : 0;
+	      blocksize[nblocks] = i - blockbegin[nblocks] + 1;
+	      blockstartcheck = 1;
+	    }
+	  }
+	  else{
+	    blockbegin[nblocks] = (i - nearestneighbor > 0) ? i - nearestneighbor : 0;
+	    blocksize[nblocks] = i - blockbegin[nblocks] + 1;
+	    blockstartcheck = 1;
+	  }
+	}
+      }
+      else if(blockstartcheck==1){
+	if(adc_current_value>zerothresholdsigned){
+	  blocksize[nblocks]++;
+	  endofblockcheck = 0;
+	}
+	else{
+	  if(endofblockcheck<nearestneighbor){
+	    endofblockcheck++;
+	    blocksize[nblocks]++;
+	  }
+	  //block has ended
+	  else if(i+2<adcsize){ //check if end of adc vector is near
+	    if(std::abs(adc[i+1]) <= zerothresholdsigned && std::abs(adc[i+2]) <= zerothresholdsigned){
+	      endofblockcheck = 0;
+	      blockstartcheck = 0;
+	      nblocks++;
+	    }
+	  }
+
+
+	} // end else
+      } // end if blockstartcheck == 1
+    }// end loop over adc size
+
+    if(blockstartcheck==1){ // we reached the end of the adc vector with the block still going
+      ++nblocks;
+    }
+
+    for(int i = 0; i < nblocks; ++i)
+      zerosuppressedsize += blocksize[i];
+
+
+    adc.resize(2+nblocks+nblocks+zerosuppressedsize);
+    zerosuppressed.resize(2+nblocks+nblocks+zerosuppressedsize);
+
+
+    int zerosuppressedcount = 0;
+    for(int i = 0; i < nblocks; ++i){
+      //zerosuppressedsize += blocksize[i];
+      for(int j = 0; j < blocksize[i]; ++j){
+	zerosuppressed[zerosuppressedcount] = adc[blockbegin[i] + j];
+	zerosuppressedcount++;
+      }
+    }
+
+    adc[0] = adcsize; //fill first entry in adc with length of uncompressed vector
+    adc[1] = nblocks;
+    for(int i = 0; i < nblocks; ++i){
+      adc[i+2] = blockbegin[i];
+      adc[i+nblocks+2] = blocksize[i];
+    }
+
+
+
+    for(int i = 0; i < zerosuppressedsize; ++i)
+      adc[i+nblocks+nblocks+2] = zerosuppressed[i];
+
+
+    // for(int i = 0; i < 2 + 2*nblocks + zerosuppressedsize; ++i)
+    //   std::cout << adc[i] << std::endl;
+    //adc.resize(2+nblocks+nblocks+zerosuppressedsize);
+  }
+
+  //----------------------------------------------------------
+  // Zero suppression function which merges blocks if they are
+  // within parameter nearestneighbor of each other
+  // after subtracting pedestal value
+  void ZeroSuppression(std::vector<short> &adc,
+		       unsigned int       &zerothreshold,
+		       int               pedestal,
+		       int                &nearestneighbor,
+		       bool              fADCStickyCodeFeature)
+  {
+
+    const int adcsize = adc.size();
+    const int zerothresholdsigned = zerothreshold;
+
+    std::vector<short> zerosuppressed(adcsize);
+    int maxblocks = adcsize/2 + 1;
+    std::vector<short> blockbegin(maxblocks);
+    std::vector<short> blocksize(maxblocks);
+
+    int nblocks = 0;
+    int zerosuppressedsize = 0;
+
+    int blockstartcheck = 0;
+    int endofblockcheck = 0;
+
+    for(int i = 0; i < adcsize; ++i){
+      int adc_current_value = ADCStickyCodeCheck(adc[i],pedestal,fADCStickyCodeFeature);
+
+      if(blockstartcheck==0){
+	if(adc_current_value>zerothresholdsigned){
+	  if(nblocks>0){
+	    if(i-nearestneighbor<=blockbegin[nblocks-1]+blocksize[nblocks-1]+1){
+	      nblocks--;
+	      blocksize[nblocks] = i - blockbegin[nblocks] + 1;
+	      blockstartcheck = 1;
+	    }
+	    else{
+	      blockbegin[nblocks] = (i - nearestneighbor > 0) ? i - nearestneighbor : 0;
+	      blocksize[nblocks] = i - blockbegin[nblocks] + 1;
+	      blockstartcheck = 1;
+	    }
+	  }
+	  else{
+	    blockbegin[nblocks] = (i - nearestneighbor > 0) ? i - nearestneighbor : 0;
+	    blocksize[nblocks] = i - blockbegin[nblocks] + 1;
+	    blockstartcheck = 1;
+	  }
+	}
+      }
+      else if(blockstartcheck==1){
+	if(adc_current_value>zerothresholdsigned){
+	  blocksize[nblocks]++;
+	  endofblockcheck = 0;
+	}
+	else{
+	  if(endofblockcheck<nearestneighbor){
+	    endofblockcheck++;
+	    blocksize[nblocks]++;
+	  }
+	  //block has ended
+	  else if(i+2<adcsize){ //check if end of adc vector is near
+	    if(ADCStickyCodeCheck(adc[i+1],pedestal,fADCStickyCodeFeature) <= zerothresholdsigned && ADCStickyCodeCheck(adc[i+2],pedestal,fADCStickyCodeFeature) <= zerothresholdsigned){
+	      endofblockcheck = 0;
+	      blockstartcheck = 0;
+	      nblocks++;
+	    }
+	  }
+	} // end else
+      } // end if blockstartcheck == 1
+    }// end loop over adc size
+
+    if(blockstartcheck==1){ // we reached the end of the adc vector with the block still going
+      ++nblocks;
+    }
+
+
+    for(int i = 0; i < nblocks; ++i)
+      zerosuppressedsize += blocksize[i];
+
+
+    adc.resize(2+nblocks+nblocks+zerosuppressedsize);
+    zerosuppressed.resize(2+nblocks+nblocks+zerosuppressedsize);
+
+
+    int zerosuppressedcount = 0;
+    for(int i = 0; i < nblocks; ++i){
+      //zerosuppressedsize += blocksize[i];
+      for(int j = 0; j < blocksize[i]; ++j){
+	zerosuppressed[zerosuppressedcount] = adc[blockbegin[i] + j];
+	zerosuppressedcount++;
+      }
+    }
+
+    adc[0] = adcsize; //fill first entry in adc with length of uncompressed vector
+    adc[1] = nblocks;
+    for(int i = 0; i < nblocks; ++i){
+      adc[i+2] = blockbegin[i];
+      adc[i+nblocks+2] = blocksize[i];
+    }
+
+
+
+    for(int i = 0; i < zerosuppressedsize; ++i)
+      adc[i+nblocks+nblocks+2] = zerosuppressed[i];
+
+
+    // for(int i = 0; i < 2 + 2*nblocks + zerosuppressedsize; ++i)
+    //   std::cout << adc[i] << std::endl;
+    //adc.resize(2+nblocks+nblocks+zerosuppressedsize);
+  }
+
+  //----------------------------------------------------------
+  // Zero suppression function which merges blocks if they are
+  // within parameter nearest neighbor of each other and makes
+  // blocks if neighboring wires have nonzero blocks there
+  void ZeroSuppression(const boost::circular_buffer<std::vector<short>> &adcvec_neighbors,
+		       std::vector<short> &adc,
+		       unsigned int       &zerothreshold,
+		       int                &nearestneighbor)
+  {
+
+    const int adcsize = adc.size();
+    const int zerothresholdsigned = zerothreshold;
+
+    std::vector<short> zerosuppressed(adcsize);
+    const int maxblocks = adcsize/2 + 1;
+    std::vector<short> blockbegin(maxblocks);
+    std::vector<short> blocksize(maxblocks);
+
+    int nblocks = 0;
+    int zerosuppressedsize = 0;
+
+    int blockstartcheck = 0;
+    int endofblockcheck = 0;
+
+    for(int i = 0; i < adcsize; ++i){
+
+      //find maximum adc value among all neighboring channels within the nearest neighbor channel distance
+
+      int adc_current_value = 0;
+
+      for(boost::circular_buffer<std::vector<short>>::const_iterator adcveciter = adcvec_neighbors.begin(); adcveciter!=adcvec_neighbors.end();++adcveciter){
+	const std::vector<short> &adcvec_current = *adcveciter;
+	const int adcvec_current_single = std::abs(adcvec_current[i]);
+
+	if(adc_current_value < adcvec_current_single){
+	  adc_current_value = adcvec_current_single;
+	}
+
+      }
+      if(blockstartcheck==0){
+	if(adc_current_value>zerothresholdsigned){
+	  if(nblocks>0){
+	    if(i-nearestneighbor<=blockbegin[nblocks-1]+blocksize[nblocks-1]+1){
+	      nblocks--;
+	      blocksize[nblocks] = i - blockbegin[nblocks] + 1;
+	      blockstartcheck = 1;
+	    }
+	    else{
+	      blockbegin[nblocks] = (i - nearestneighbor > 0) ? i - nearestneighbor : 0;
+	      blocksize[nblocks] = i - blockbegin[nblocks] + 1;
+	      blockstartcheck = 1;
+	    }
+	  }
+	  else{
+	    blockbegin[nblocks] = (i - nearestneighbor > 0) ? i - nearestneighbor : 0;
+	    blocksize[nblocks] = i - blockbegin[nblocks] + 1;
+	    blockstartcheck = 1;
+	  }
+	}
+      }
+      else if(blockstartcheck==1){
+	if(adc_current_value>zerothresholdsigned){
+	  blocksize[nblocks]++;
+	  endofblockcheck = 0;
+	}
+	else{
+	  if(endofblockcheck<nearestneighbor){
+	    endofblockcheck++;
+	    blocksize[nblocks]++;
+	  }
+	  //block has ended
+	  else  if(i+2<adcsize){ //check if end of adc vector is near
+	    if(std::abs(adc[i+1]) <= zerothresholdsigned && std::abs(adc[i+2]) <= zerothresholdsigned){
+	      endofblockcheck = 0;
+	      blockstartcheck = 0;
+	      nblocks++;
+	    }
+	  }
+
+	} // end else
+      } // end if blockstartcheck == 1
+    }// end loop over adc size
+
+    if(blockstartcheck==1){ // we reached the end of the adc vector with the block still going
+      ++nblocks;
+    }
+
+
+
+    for(int i = 0; i < nblocks; ++i)
+      zerosuppressedsize += blocksize[i];
+
+
+    adc.resize(2+nblocks+nblocks+zerosuppressedsize);
+    zerosuppressed.resize(2+nblocks+nblocks+zerosuppressedsize);
+
+
+    int zerosuppressedcount = 0;
+    for(int i = 0; i < nblocks; ++i){
+      //zerosuppressedsize += blocksize[i];
+      for(int j = 0; j < blocksize[i]; ++j){
+	zerosuppressed[zerosuppressedcount] = adc[blockbegin[i] + j];
+	zerosuppressedcount++;
+      }
+    }
+
+    adc[0] = adcsize; //fill first entry in adc with length of uncompressed vector
+    adc[1] = nblocks;
+    for(int i = 0; i < nblocks; ++i){
+      adc[i+2] = blockbegin[i];
+      adc[i+nblocks+2] = blocksize[i];
+    }
+
+
+
+    for(int i = 0; i < zerosuppressedsize; ++i)
+      adc[i+nblocks+nblocks+2] = zerosuppressed[i];
+
+
+    // for(int i = 0; i < 2 + 2*nblocks + zerosuppressedsize; ++i)
+    //   std::cout << adc[i] << std::endl;
+    //adc.resize(2+nblocks+nblocks+zerosuppressedsize);
+  }
+
+  //----------------------------------------------------------
+  // Zero suppression function which merges blocks if they are
+  // within parameter nearest neighbor of each other and makes
+  // blocks if neighboring wires have nonzero blocks there
+  // after subtracting pedestal values
+  void ZeroSuppression(const boost::circular_buffer<std::vector<short>> &adcvec_neighbors,
+		       std::vector<short> &adc,
+		       unsigned int       &zerothreshold,
+		       int               pedestal,
+		       int                &nearestneighbor,
+		       bool              fADCStickyCodeFeature)
+  {
+
+    const int adcsize = adc.size();
+    const int zerothresholdsigned = zerothreshold;
+
+    std::vector<short> zerosuppressed(adcsize);
+    const int maxblocks = adcsize/2 + 1;
+    std::vector<short> blockbegin(maxblocks);
+    std::vector<short> blocksize(maxblocks);
+
+    int nblocks = 0;
+    int zerosuppressedsize = 0;
+
+    int blockstartcheck = 0;
+    int endofblockcheck = 0;
+
+    for(int i = 0; i < adcsize; ++i){
+
+      //find maximum adc value among all neighboring channels within the nearest neighbor channel distance
+
+      int adc_current_value = ADCStickyCodeCheck(adc[i],pedestal,fADCStickyCodeFeature);
+
+      for(boost::circular_buffer<std::vector<short>>::const_iterator adcveciter = adcvec_neighbors.begin(); adcveciter!=adcvec_neighbors.end();++adcveciter){
+	const std::vector<short> &adcvec_current = *adcveciter;
+	const int adcvec_current_single = std::abs(adcvec_current[i] - pedestal);
+
+	if(adc_current_value < adcvec_current_single){
+	  adc_current_value = adcvec_current_single;
+	}
+
+      }
+      if(blockstartcheck==0){
+	if(adc_current_value>zerothresholdsigned){
+	  if(nblocks>0){
+	    if(i-nearestneighbor<=blockbegin[nblocks-1]+blocksize[nblocks-1]+1){
+	      nblocks--;
+	      blocksize[nblocks] = i - blockbegin[nblocks] + 1;
+	      blockstartcheck = 1;
+	    }
+	    else{
+	      blockbegin[nblocks] = (i - nearestneighbor > 0) ? i - nearestneighbor : 0;
+	      blocksize[nblocks] = i - blockbegin[nblocks] + 1;
+	      blockstartcheck = 1;
+	    }
+	  }
+	  else{
+	    blockbegin[nblocks] = (i - nearestneighbor > 0) ? i - nearestneighbor : 0;
+	    blocksize[nblocks] = i - blockbegin[nblocks] + 1;
+	    blockstartcheck = 1;
+	  }
+	}
+      }
+      else if(blockstartcheck==1){
+	if(adc_current_value>zerothresholdsigned){
+	  blocksize[nblocks]++;
+	  endofblockcheck = 0;
+	}
+	else{
+	  if(endofblockcheck<nearestneighbor){
+	    endofblockcheck++;
+	    blocksize[nblocks]++;
+	  }
+	  //block has ended
+
+	  else  if(i+2<adcsize){ //check if end of adc vector is near
+	    if(ADCStickyCodeCheck(adc[i+1],pedestal,fADCStickyCodeFeature) <= zerothresholdsigned && ADCStickyCodeCheck(adc[i+2],pedestal,fADCStickyCodeFeature) <= zerothresholdsigned){
+	      endofblockcheck = 0;
+	      blockstartcheck = 0;
+	      nblocks++;
+	    }
+	  }
+
+	} // end else
+      } // end if blockstartcheck == 1
+    }// end loop over adc size
+
+    if(blockstartcheck==1){ // we reached the end of the adc vector with the block still going
+      ++nblocks;
+    }
+
+
+
+    for(int i = 0; i < nblocks; ++i)
+      zerosuppressedsize += blocksize[i];
+
+
+    adc.resize(2+nblocks+nblocks+zerosuppressedsize);
+    zerosuppressed.resize(2+nblocks+nblocks+zerosuppressedsize);
+
+
+    int zerosuppressedcount = 0;
+    for(int i = 0; i < nblocks; ++i){
+      //zerosuppressedsize += blocksize[i];
+      for(int j = 0; j < blocksize[i]; ++j){
+	zerosuppressed[zerosuppressedcount] = adc[blockbegin[i] + j];
+	zerosuppressedcount++;
+      }
+    }
+
+    adc[0] = adcsize; //fill first entry in adc with length of uncompressed vector
+    adc[1] = nblocks;
+    for(int i = 0; i < nblocks; ++i){
+      adc[i+2] = blockbegin[i];
+      adc[i+nblocks+2] = blocksize[i];
+    }
+
+
+
+    for(int i = 0; i < zerosuppressedsize; ++i)
+      adc[i+nblocks+nblocks+2] = zerosuppressed[i];
+
+
+    // for(int i = 0; i < 2 + 2*nblocks + zerosuppressedsize; ++i)
+    //   std::cout << adc[i] << std::endl;
+    //adc.resize(2+nblocks+nblocks+zerosuppressedsize);
+  }
+
+} // namespace reference
+
+
+/**
+ * @brief Returns a waveform with noise, pulses and sticky codes
+ * @param size number of ticks
+ * @param pedestal level of the noise
+ *
+ * The noise is Gaussian, with some ticks starting a pulse a few ticks long
+ * or holding a sticky code (lowest six bits all 0 or all 1) close to the
+ * pedestal.
+ */
+std::vector<short> ZeroSuppressionTestWaveform(size_t size, int pedestal) {
+
+	std::default_random_engine& engine = DataCreatorBase::random_engine;
+	std::normal_distribution<double> noise(pedestal, 3.);
+	std::uniform_real_distribution<double> uniform;
+	std::uniform_int_distribution<int> pulseHeight(-60, 60);
+	std::uniform_int_distribution<int> pulseLength(1, 8);
+	std::uniform_int_distribution<int> stickyOffset(-63, 63);
+
+	std::vector<short> data;
+	data.reserve(size);
+	while (data.size() < size) {
+		double const what = uniform(engine);
+		if (what < 0.02) { // pulse
+			int const height = pulseHeight(engine);
+			for (int i = pulseLength(engine); i > 0 && data.size() < size; --i)
+				data.push_back(std::lround(noise(engine)) + height);
+		}
+		else if (what < 0.05) { // sticky code
+			short const value = pedestal + stickyOffset(engine);
+			data.push_back((what < 0.035)? (value | raw::onemask): (value & ~raw::onemask));
+		}
+		else data.push_back(std::lround(noise(engine)));
+	} // while
+	return data;
+
+} // ZeroSuppressionTestWaveform()
+
+
+/// Checks all raw::ZeroSuppression() overloads against the reference ones
+void RunZeroSuppressionComparison(bool vectorized) {
+
+	raw::ThreadLocalZeroSuppressor().SetVectorized(vectorized);
+	BOOST_CHECK_EQUAL(raw::ThreadLocalZeroSuppressor().Vectorized(), vectorized);
+
+	for (size_t const size: { 1, 3, 5, 16, 33, 64, 65, 1000, 9600, 32767 }) {
+		for (int const pedestal: { 0, 400, 2048 }) {
+			const std::vector<short> data(ZeroSuppressionTestWaveform(size, pedestal));
+			const std::vector<short> zeroData(ZeroSuppressionTestWaveform(size, 0));
+
+			boost::circular_buffer<std::vector<short>> neighbors(3);
+			neighbors.push_back(ZeroSuppressionTestWaveform(size, pedestal));
+			neighbors.push_back(data);
+			neighbors.push_back(ZeroSuppressionTestWaveform(size, pedestal));
+			boost::circular_buffer<std::vector<short>> zeroNeighbors(3);
+			zeroNeighbors.push_back(ZeroSuppressionTestWaveform(size, 0));
+			zeroNeighbors.push_back(zeroData);
+			zeroNeighbors.push_back(ZeroSuppressionTestWaveform(size, 0));
+
+			for (unsigned int zerothreshold: { 0U, 3U, 5U, 20U, 100U }) {
+
+				std::vector<short> expected(zeroData), suppressed(zeroData);
+				reference::ZeroSuppression(expected, zerothreshold);
+				raw::ZeroSuppression(suppressed, zerothreshold);
+				BOOST_CHECK_EQUAL_COLLECTIONS(suppressed.begin(), suppressed.end(),
+					expected.begin(), expected.end());
+
+				for (int nearestneighbor: { 0, 1, 2, 4, 9 }) {
+
+					expected = suppressed = zeroData;
+					reference::ZeroSuppression(expected, zerothreshold, nearestneighbor);
+					raw::ZeroSuppression(suppressed, zerothreshold, nearestneighbor);
+					BOOST_CHECK_EQUAL_COLLECTIONS(suppressed.begin(), suppressed.end(),
+						expected.begin(), expected.end());
+
+					expected = suppressed = zeroData;
+					reference::ZeroSuppression
+						(zeroNeighbors, expected, zerothreshold, nearestneighbor);
+					raw::ZeroSuppression
+						(zeroNeighbors, suppressed, zerothreshold, nearestneighbor);
+					BOOST_CHECK_EQUAL_COLLECTIONS(suppressed.begin(), suppressed.end(),
+						expected.begin(), expected.end());
+
+					for (bool const sticky: { false, true }) {
+						expected = suppressed = data;
+						reference::ZeroSuppression
+							(expected, zerothreshold, pedestal, nearestneighbor, sticky);
+						raw::ZeroSuppression
+							(suppressed, zerothreshold, pedestal, nearestneighbor, sticky);
+						BOOST_CHECK_EQUAL_COLLECTIONS(suppressed.begin(), suppressed.end(),
+							expected.begin(), expected.end());
+
+						expected = suppressed = data;
+						reference::ZeroSuppression(neighbors, expected,
+							zerothreshold, pedestal, nearestneighbor, sticky);
+						raw::ZeroSuppression(neighbors, suppressed,
+							zerothreshold, pedestal, nearestneighbor, sticky);
+						BOOST_CHECK_EQUAL_COLLECTIONS(suppressed.begin(), suppressed.end(),
+							expected.begin(), expected.end());
+					} // for sticky
+				} // for nearest neighbours
+			} // for thresholds
+		} // for pedestals
+	} // for sizes
+
+	raw::ThreadLocalZeroSuppressor().SetVectorized(true);
+
+} // RunZeroSuppressionComparison()
+
+
+BOOST_AUTO_TEST_CASE(ZeroSuppressionComparison) {
+	RunZeroSuppressionComparison(true);  // vectorized comparisons
+	RunZeroSuppressionComparison(false); // scalar comparisons
+}
+
+
+//------------------------------------------------------------------------------
+//--- streaming compression
+//
+
+/// Compresses data pushing fragments of random size (up to maxFragment)
+std::vector<short> StreamCompress(raw::StreamingCompressor& compressor,
+	std::vector<short> const& data, size_t maxFragment, std::default_random_engine& engine)
+{
+	std::uniform_int_distribution<size_t> fragmentSize(0, maxFragment);
+	std::vector<short> compressed;
+	size_t maxBuffered = 0;
+	size_t tick = 0;
+	while (tick < data.size()) {
+		size_t const n = std::min(fragmentSize(engine), data.size() - tick);
+		compressor.Push(data.data() + tick, n);
+		tick += n;
+		BOOST_CHECK_EQUAL(compressor.NTicks(), tick);
+		maxBuffered = std::max(maxBuffered, compressor.NBuffered());
+		compressor.TakeOutput(compressed);
+	} // while
+	compressor.Finish(compressed);
+	BOOST_CHECK_EQUAL(compressor.NTicks(), 0U);
+	if ((compressor.Compression() == raw::kHuffman) && (data.size() > 4 * maxFragment))
+		BOOST_CHECK_LT(maxBuffered, data.size() / 2);
+	return compressed;
+} // StreamCompress()
+
+
+BOOST_AUTO_TEST_CASE(StreamingCompression) {
+
+	std::default_random_engine engine(20240517);
+
+	// noise with pulses, flat regions and large jumps
+	GaussianNoiseCreator NoiseData("Gaussian noise", 2.5);
+	auto const makeData = [&NoiseData](size_t nTicks, int pedestal) {
+		std::vector<short> data = NoiseData.create(nTicks);
+		for (size_t tick = 0; tick < nTicks; ++tick) {
+			if (tick % 1000 < 40) data[tick] += 100 - 5 * std::abs(int(tick % 1000) - 20);
+			else if (tick % 1000 < 60) data[tick] = 1;
+			else if (tick % 1000 == 500) data[tick] = -3000;
+			data[tick] += pedestal;
+		}
+		return data;
+	};
+	std::vector<short> const data = makeData(6000, 0);
+	std::vector<short> const pedestalData = makeData(6000, 400);
+	std::vector<short> const longData = makeData(40000, 0);
+
+	raw::CodecParameters simple;
+	raw::CodecParameters neighbors;
+	neighbors.nearestneighbor = 4;
+	raw::CodecParameters sticky;
+	sticky.zerothreshold = 3;
+	sticky.pedestal = 400;
+	sticky.nearestneighbor = 2;
+	sticky.fADCStickyCodeFeature = true;
+	raw::CodecParameters noNeighbors;
+	noNeighbors.pedestal = 400;
+	noNeighbors.nearestneighbor = 0;
+
+	struct TestCase_t {
+		std::vector<short> const* data;
+		raw::CodecParameters params;
+	};
+	for (TestCase_t const& test: {
+		TestCase_t{ &data, simple }, TestCase_t{ &data, neighbors },
+		TestCase_t{ &pedestalData, sticky }, TestCase_t{ &pedestalData, noNeighbors },
+		TestCase_t{ &longData, simple }, TestCase_t{ &longData, neighbors }
+	}) {
+		for (raw::Compress_t compress: { raw::kNone, raw::kHuffman, raw::kZeroSuppression, raw::kZeroHuffman }) {
+			std::vector<short> expected(*test.data);
+			raw::CodecRegistry::Instance().Get(compress).Encode(expected, test.params);
+
+			raw::StreamingCompressor compressor(compress, test.params);
+			for (size_t maxFragment: { 1, 3, 100, 5000 }) {
+				std::vector<short> const compressed
+					= StreamCompress(compressor, *test.data, maxFragment, engine);
+				BOOST_CHECK(compressed == expected);
+			} // for fragment sizes
+
+			// the whole waveform at once
+			compressor.Push(*test.data);
+			BOOST_CHECK(compressor.Finish() == expected);
+		} // for compression types
+	} // for test cases
+
+	// short waveforms
+	for (size_t size: { 0, 1, 2, 3, 4, 5 }) {
+		std::vector<short> const shortData(data.begin() + 50, data.begin() + 50 + size);
+		for (raw::Compress_t compress: { raw::kHuffman, raw::kZeroSuppression }) {
+			std::vector<short> expected(shortData);
+			raw::CodecRegistry::Instance().Get(compress).Encode(expected, neighbors);
+			raw::StreamingCompressor compressor(compress, neighbors);
+			compressor.Push(shortData);
+			BOOST_CHECK(compressor.Finish() == expected);
+		}
+	} // for sizes
+
+	boost::circular_buffer<std::vector<short>> channels(1);
+	raw::CodecParameters withChannels;
+	withChannels.neighbors = &channels;
+	BOOST_CHECK_THROW(raw::StreamingCompressor(raw::kZeroSuppression, withChannels), cet::exception);
+	BOOST_CHECK_THROW(raw::StreamingCompressor(raw::kDynamicDec), cet::exception);
+
+} // BOOST_AUTO_TEST_CASE(StreamingCompression)
+
+
+//------------------------------------------------------------------------------
+//--- uncompression with pedestal subtraction
+//
+
+BOOST_AUTO_TEST_CASE(PedestalSubtraction) {
+
+	constexpr size_t nTicks = 9600;
+	constexpr float pedestal = 400.25;
+	constexpr short suppressed = -30000; // value no sample has
+	GaussianNoiseCreator NoiseData("Gaussian noise", 2.5, 400);
+	std::vector<short> data = NoiseData.create(nTicks);
+	for (size_t tick = 0; tick < nTicks; ++tick) {
+		if (tick % 800 < 30) data[tick] += 150 - 10 * std::abs(int(tick % 800) - 15);
+	}
+
+	for (raw::Compress_t compress: { raw::kNone, raw::kHuffman, raw::kZeroSuppression, raw::kZeroHuffman }) {
+		unsigned int threshold = 10;
+		int nearestNeighbor = 3;
+		std::vector<short> compressed(data);
+		raw::Compress(compressed, compress, threshold, 400, nearestNeighbor);
+		raw::RawDigit digit(1, nTicks, compressed, compress);
+		digit.SetPedestal(pedestal, 2.5);
+
+		std::vector<short> uncompressed(nTicks);
+		raw::Uncompress(compressed, uncompressed, suppressed, compress);
+		std::vector<float> expected(nTicks);
+		for (size_t tick = 0; tick < nTicks; ++tick)
+			expected[tick] = (uncompressed[tick] == suppressed)? 0.f: uncompressed[tick] - pedestal;
+
+		std::vector<float> subtracted;
+		raw::UncompressPedestalSubtracted(digit, subtracted);
+		BOOST_CHECK(subtracted == expected);
+
+		// fewer ticks than the data, and more
+		for (size_t n: { size_t(0), size_t(1), size_t(4321), nTicks + 100 }) {
+			std::vector<float> buffer(n + 1, -1.f);
+			raw::UncompressPedestalSubtracted(compressed, buffer.data(), n, pedestal, compress);
+			size_t const nData = std::min(n, nTicks);
+			BOOST_CHECK(std::equal(buffer.begin(), buffer.begin() + nData, expected.begin()));
+			BOOST_CHECK(std::all_of(buffer.begin() + nData, buffer.begin() + n, [](float v){ return v == 0.f; }));
+			BOOST_CHECK_EQUAL(buffer[n], -1.f); // nothing written past the end
+		}
+
+		// the overload filling a buffer of the size of the digit
+		std::vector<float> buffer(nTicks, -1.f);
+		raw::UncompressPedestalSubtracted(digit, buffer.data());
+		BOOST_CHECK(buffer == expected);
+	} // for compression types
+
+} // BOOST_AUTO_TEST_CASE(PedestalSubtraction)
+
+
+//------------------------------------------------------------------------------
+//--- views of raw digits uncompressed on demand
+//
+
+BOOST_AUTO_TEST_CASE(RawDigitViews) {
+
+	constexpr size_t nTicks = 4000;
+	GaussianNoiseCreator NoiseData("Gaussian noise", 2.5, 400);
+	std::vector<short> const data = NoiseData.create(nTicks);
+
+	std::vector<raw::RawDigit> digits;
+	for (raw::Compress_t compress: { raw::kNone, raw::kHuffman, raw::kZeroSuppression, raw::kZeroHuffman }) {
+		unsigned int threshold = 5;
+		int nearestNeighbor = 2;
+		std::vector<short> compressed(data);
+		raw::Compress(compressed, compress, threshold, 400, nearestNeighbor);
+		digits.emplace_back(digits.size(), nTicks, compressed, compress);
+		digits.back().SetPedestal(400.2, 2.5);
+	}
+
+	std::deque<raw::RawDigitView> const views(digits.begin(), digits.end());
+	for (size_t i = 0; i < digits.size(); ++i) {
+		raw::RawDigitView const& view = views[i];
+		BOOST_CHECK_EQUAL(&view.Digit(), &digits[i]);
+		BOOST_CHECK_EQUAL(view.IsUncompressed(), digits[i].Compression() == raw::kNone);
+
+		std::vector<short> expected(nTicks);
+		raw::Uncompress(digits[i].ADCs(), expected, 400, digits[i].Compression());
+
+		// many threads asking at the same time get the same samples
+		std::vector<raw::SampleSpan> spans(8);
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < spans.size(); ++t)
+			threads.emplace_back([&view, &spans, t](){ spans[t] = view.Uncompressed(); });
+		for (std::thread& thread: threads) thread.join();
+		BOOST_CHECK(view.IsUncompressed());
+		for (raw::SampleSpan const& span: spans) {
+			BOOST_CHECK_EQUAL(span.data(), spans.front().data());
+			BOOST_CHECK_EQUAL(span.size(), nTicks);
+		}
+		raw::SampleSpan const samples = view.Uncompressed();
+		BOOST_CHECK_EQUAL(samples.data(), spans.front().data());
+		BOOST_CHECK(std::equal(samples.begin(), samples.end(), expected.begin(), expected.end()));
+		if (digits[i].Compression() == raw::kNone)
+			BOOST_CHECK_EQUAL(samples.data(), digits[i].ADCs().data()); // no copy
+	} // for
+
+	// unsupported compression
+	raw::RawDigit const unknown(0, nTicks, data, raw::kDynamicDec);
+	raw::RawDigitView const unknownView(unknown);
+	if (!raw::CodecRegistry::Instance().Find(raw::kDynamicDec))
+		BOOST_CHECK_THROW(unknownView.Uncompressed(), cet::exception);
+
+} // BOOST_AUTO_TEST_CASE(RawDigitViews)
+
+
+//------------------------------------------------------------------------------
+//--- compression statistics
+//
+
+BOOST_AUTO_TEST_CASE(CompressionStatistics) {
+
+	constexpr size_t nTicks = 6000;
+	constexpr int pedestal = 400;
+	GaussianNoiseCreator NoiseData("Gaussian noise", 2.5, pedestal);
+
+	// pulses, with a jump too large for a Huffman code every 1000 ticks
+	std::vector<short> data = NoiseData.create(nTicks);
+	for (size_t tick = 0; tick < nTicks; ++tick) {
+		if (tick % 1000 < 40) data[tick] += 100 - 5 * std::abs(int(tick % 1000) - 20);
+		else if (tick % 1000 == 500) data[tick] = 3000;
+	}
+	size_t expectedEscapes = 0;
+	for (size_t tick = 1; tick < nTicks; ++tick)
+		if (std::abs(data[tick] - data[tick - 1]) > 3) ++expectedEscapes;
+
+	raw::CompressionRecord record;
+	raw::CodecParameters params;
+	params.zerothreshold = 5;
+	params.pedestal = pedestal;
+	params.nearestneighbor = 2;
+	params.statistics = &record;
+
+	std::map<raw::Compress_t, raw::CompressionRecord> records;
+	for (raw::Compress_t compress: { raw::kNone, raw::kHuffman, raw::kZeroSuppression, raw::kZeroHuffman }) {
+		record.huffmanEscapes = 1234; // must be reset
+		std::vector<short> compressed(data);
+		raw::Compress(compressed, compress, params);
+		BOOST_CHECK_EQUAL(record.ticks, nTicks);
+		BOOST_CHECK_EQUAL(record.words, compressed.size());
+		BOOST_CHECK_CLOSE(record.Ratio(), double(compressed.size()) / nTicks, 1e-9);
+		records[compress] = record;
+
+		// same result as without statistics
+		unsigned int threshold = params.zerothreshold;
+		int nearestNeighbor = *params.nearestneighbor;
+		std::vector<short> expected(data);
+		raw::Compress(expected, compress, threshold, pedestal, nearestNeighbor);
+		BOOST_CHECK(compressed == expected);
+	} // for
+
+	BOOST_CHECK_EQUAL(records[raw::kNone].huffmanEscapes, 0U);
+	BOOST_CHECK_EQUAL(records[raw::kNone].zsBlocks, 0U);
+	BOOST_CHECK_EQUAL(records[raw::kHuffman].huffmanEscapes, expectedEscapes);
+	BOOST_CHECK_EQUAL(records[raw::kHuffman].zsBlocks, 0U);
+
+	std::vector<short> suppressed(data);
+	unsigned int threshold = params.zerothreshold;
+	int nearestNeighbor = *params.nearestneighbor;
+	raw::ZeroSuppression(suppressed, threshold, pedestal, nearestNeighbor);
+	size_t const nBlocks = suppressed[1];
+	BOOST_CHECK_GT(nBlocks, 0U);
+	for (raw::Compress_t compress: { raw::kZeroSuppression, raw::kZeroHuffman }) {
+		BOOST_CHECK_EQUAL(records[compress].zsBlocks, nBlocks);
+		BOOST_CHECK_EQUAL(records[compress].zsKeptTicks, suppressed.size() - 2 - 2 * nBlocks);
+	}
+	BOOST_CHECK_EQUAL(records[raw::kZeroSuppression].huffmanEscapes, 0U);
+	BOOST_CHECK_GT(records[raw::kZeroHuffman].huffmanEscapes, 0U);
+
+	// accumulation per channel and per plane (four channels per plane)
+	raw::CompressionStatistics stats;
+	BOOST_CHECK(stats.empty());
+	for (raw::ChannelID_t channel = 0; channel < 8; ++channel)
+		stats.Add(channel, records[raw::kZeroHuffman]);
+	stats.Add(3, records[raw::kHuffman]);
+	BOOST_CHECK_EQUAL(stats.Channels().size(), 8U);
+	BOOST_CHECK_EQUAL(stats.Channel(3).waveforms, 2U);
+	BOOST_CHECK_EQUAL(stats.Channel(3).words,
+		records[raw::kZeroHuffman].words + records[raw::kHuffman].words);
+	BOOST_CHECK_EQUAL(stats.Channel(20).waveforms, 0U);
+	BOOST_CHECK_EQUAL(stats.Total().waveforms, 9U);
+
+	auto const planes = stats.ByPlane([](raw::ChannelID_t channel){ return channel / 4; });
+	BOOST_CHECK_EQUAL(planes.size(), 2U);
+	BOOST_CHECK_EQUAL(planes.at(0).waveforms, 5U);
+	BOOST_CHECK_EQUAL(planes.at(1).waveforms, 4U);
+	BOOST_CHECK_EQUAL(planes.at(1).zsBlocks, 4 * nBlocks);
+	BOOST_CHECK_EQUAL(planes.at(0).huffmanEscapes,
+		4 * records[raw::kZeroHuffman].huffmanEscapes + expectedEscapes);
+
+	raw::CompressionStatistics other;
+	other.Add(3, records[raw::kNone]);
+	other.Add(9, records[raw::kNone]);
+	stats.Merge(other);
+	BOOST_CHECK_EQUAL(stats.Channels().size(), 9U);
+	BOOST_CHECK_EQUAL(stats.Channel(3).waveforms, 3U);
+	stats.Clear();
+	BOOST_CHECK(stats.empty());
+
+	// statistics of many digits compressed at once
+	std::vector<raw::RawDigit> digits;
+	for (raw::ChannelID_t channel = 0; channel < 6; ++channel) {
+		digits.emplace_back(channel, nTicks, data, raw::kNone);
+		digits.back().SetPedestal(pedestal, 2.5);
+	}
+	raw::CompressionStatistics batchStats;
+	std::vector<raw::RawDigit> const compressedDigits
+		= raw::CompressAll(digits, raw::kZeroHuffman, 5, 2, 3, &batchStats);
+	BOOST_CHECK_EQUAL(batchStats.Channels().size(), digits.size());
+	for (raw::RawDigit const& digit: compressedDigits) {
+		raw::CompressionTotals const totals = batchStats.Channel(digit.Channel());
+		BOOST_CHECK_EQUAL(totals.words, digit.NADC());
+		BOOST_CHECK_EQUAL(totals.zsBlocks, nBlocks);
+		BOOST_CHECK_EQUAL(totals.huffmanEscapes, records[raw::kZeroHuffman].huffmanEscapes);
+	}
+
+} // BOOST_AUTO_TEST_CASE(CompressionStatistics)
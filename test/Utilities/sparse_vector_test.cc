@@ -178,7 +178,7 @@ class TestManagerClass {
 
   void run(const Action_t& action)
     {
-      action(v);
+      action(v, sv); // sv is not changed yet
       action(sv);
     } // run()
 
@@ -304,6 +304,11 @@ namespace actions {
     /// Action performed on a STL vector.
     void operator() (Vector_t& v) const { actionOnVector(v); }
 
+    /// Action performed on a STL vector, mirroring the sparse vector sv
+    /// (which has not been acted on yet).
+    void operator() (Vector_t& v, SparseVector_t const& sv) const
+      { mirrorActionOnVector(v, sv); }
+
     /// Action performed on a sparse vector.
     void operator() (SparseVector_t& v) const { actionOnSparseVector(v); }
 
@@ -314,6 +319,10 @@ namespace actions {
       { out << "no action"; }
 
     virtual void actionOnVector(Vector_t&) const {}
+    /// The STL vector can't tell void elements from zero ones:
+    /// actions which need that may ask the sparse vector
+    virtual void mirrorActionOnVector(Vector_t& v, SparseVector_t const&) const
+      { actionOnVector(v); }
     virtual void actionOnSparseVector(SparseVector_t&) const {}
 
     template <typename ITER>
@@ -675,15 +684,18 @@ namespace actions {
       : position(pos), data(new_data), baseline(baseline) {}
 
       protected:
-    virtual void actionOnVector(Vector_t& v) const override
+    virtual void mirrorActionOnVector
+      (Vector_t& v, SparseVector_t const& sv) const override
       {
         size_t max_size = std::max(v.size(), position + data.size());
         v.resize(max_size, 0);
-        // buggy: we have no way to recognise a void element from a 0 one
-        std::transform(data.cbegin(), data.cend(), v.cbegin() + position,
-          v.begin() + position,
-          [this](auto a, auto b){ return a + ((b == 0)? baseline: b); }
-          );
+        // void elements are replaced by the baseline; zero elements are not
+        // necessarily void (e.g. after optimize()), so we ask the sparse vector
+        for (size_t i = 0; i < data.size(); ++i) {
+          size_t const index = position + i;
+          bool const isVoid = (index >= sv.size()) || sv.is_void(index);
+          v[index] = data[i] + (isVoid? baseline: v[index]);
+        } // for
       }
     virtual void actionOnSparseVector(SparseVector_t& v) const override
       { v.combine_range(position, data, std::plus<Data_t>(), baseline); }
@@ -1097,6 +1109,96 @@ ITER actions::BaseAction<T>::findVoidStart
 } // actions::BaseAction::findVoidStart()
 
 
+//------------------------------------------------------------------------------
+/// Checks which ranges optimize() merges; returns the number of errors
+unsigned int OptimizeTest() {
+
+  typedef float Data_t;
+  typedef lar::sparse_vector<Data_t> SparseVector_t;
+
+  unsigned int nErrors = 0;
+
+  // (40) { 0 0 [ 2 3 ] 0 [ 5 6 ] 0 0 [ 9 ] 0 ... 0 [ 20 21 ] 0 ... 0 [ 30 ] ... }
+  SparseVector_t sv(40);
+  sv.add_range(2, std::vector<Data_t>{ 2, 3 });
+  sv.add_range(5, std::vector<Data_t>{ 5, 6 });
+  sv.add_range(9, std::vector<Data_t>{ 9 });
+  sv.add_range(20, std::vector<Data_t>{ 20, 21 });
+  sv.add_range(30, std::vector<Data_t>{ 30 });
+  std::vector<Data_t> const expected(sv.begin(), sv.end());
+
+  auto check = [&sv, &expected, &nErrors]
+    (size_t threshold, bool expected_change, size_t expected_ranges)
+    {
+      std::cout << "optimize(" << threshold << "): ";
+      bool const changed = sv.optimize(threshold);
+      PrintVectorRanges(sv) << std::endl;
+      if (changed != expected_change) {
+        std::cout << "  *** optimize() returned " << std::boolalpha << changed
+          << ", expected " << expected_change << std::endl;
+        ++nErrors;
+      }
+      if (sv.n_ranges() != expected_ranges) {
+        std::cout << "  *** " << sv.n_ranges() << " ranges, expected "
+          << expected_ranges << std::endl;
+        ++nErrors;
+      }
+      if (!sv.is_valid()) {
+        std::cout << "  *** sparse vector is not valid" << std::endl;
+        ++nErrors;
+      }
+      if ((sv.size() != expected.size())
+        || !std::equal(expected.begin(), expected.end(), sv.begin()))
+      {
+        std::cout << "  *** content changed" << std::endl;
+        ++nErrors;
+      }
+    }; // check()
+
+  check(0, false, 5U); // gaps are never empty
+  check(1, false, 5U);
+  check(3, true, 3U);  // [ 2 - 10 ] [ 20 - 22 ] [ 30 - 31 ]
+  check(3, false, 3U);
+  check(9, true, 2U);  // [ 2 - 10 ] [ 20 - 31 ]
+  check(100, true, 1U);
+
+  // the default optimization merges the ranges closer than min_gap();
+  // the elements of the merged gap are not void any more
+  size_t const gap = SparseVector_t::min_gap();
+  size_t const second = 4 + gap - 1, third = second + 1 + gap;
+  SparseVector_t sv2(third + 10);
+  sv2.add_range(2, std::vector<Data_t>{ 2, 3 });
+  sv2.add_range(second, std::vector<Data_t>{ 5 });
+  sv2.add_range(third, std::vector<Data_t>{ 6 });
+  std::vector<Data_t> const expected2(sv2.begin(), sv2.end());
+  std::cout << "optimize(): ";
+  bool const changed = sv2.optimize();
+  PrintVectorRanges(sv2) << std::endl;
+  if (!changed) ++nErrors;
+  if (sv2.n_ranges() != 2U) ++nErrors;
+  if ((sv2.range(0).begin_index() != 2U) || (sv2.range(0).end_index() != second + 1))
+    ++nErrors;
+  if (!std::equal(expected2.begin(), expected2.end(), sv2.begin())) ++nErrors;
+  if (sv2.is_void(4) || sv2.is_void(second - 1)) ++nErrors;
+  if (!sv2.is_void(second + 1)) ++nErrors; // the last gap is as large as min_gap()
+  if (sv2.count() != second - 2 + 1 + 1) ++nErrors;
+
+  // combining with a baseline: it applies to void elements only
+  sv2.combine_range(second - 1, std::vector<Data_t>{ 1, 1, 1 },
+    std::plus<Data_t>(), Data_t(10));
+  if ((sv2[second - 1] != 1) || (sv2[second] != 6) || (sv2[second + 1] != 11))
+    ++nErrors;
+
+  // an empty vector has nothing to optimize
+  SparseVector_t empty;
+  if (empty.optimize(100) || !empty.empty()) ++nErrors;
+
+  if (nErrors != 0)
+    std::cout << nErrors << " errors in optimization tests." << std::endl;
+  return nErrors;
+} // OptimizeTest()
+
+
 //------------------------------------------------------------------------------
 
 /// A simple test suite
@@ -1201,41 +1303,43 @@ int main() {
 
   Test(actions::PrintNonVoid<Data_t>());
 
+  // the two ranges are 9 elements apart, closer than min_gap(): they are
+  // merged, and the elements in between become zero instead of void, so that
+  // the baseline of the following increments does not apply to them
   Test(actions::Optimize<Data_t>(-1));
-
   // at this point:
-  // (31) [2] {
-  //      0     0    0 [  3    4    5    6 ]  0     0     0
-  //      0     0    0    0    0    0 [ 16   17    18    19
-  //     20    21   22   23   -1 ]  0    0    0     0     0
+  // (31) [1] {
+  //      0    0    0 [  3    4    5    6    0    0    0
+  //      0    0    0    0    0    0   16   17   18   19
+  //     20   21   22   23   -1 ]    0    0    0    0    0
   //      0
   //   }
 
   Test(actions::Add<Data_t>(5, { 7, 8, 7, 8 }, 10));
   // at this point:
-  // (31) [2] {
-  //      0     0    0 [  3    4   12   13   17    18 ]   0
-  //      0     0    0    0    0    0 [ 16   17    18    19
-  //     20    21   22   23   -1 ]  0    0    0     0     0
+  // (31) [1] {
+  //      0    0    0 [  3    4   12   14    7    8    0
+  //      0    0    0    0    0    0   16   17   18   19
+  //     20   21   22   23   -1 ]    0    0    0    0    0
   //      0
   //   }
 
   Test(actions::Add<Data_t>
     (5, { 20, 20, 20, 20, 8, 7, 8, 7, 8, 7, 8, 7 }, 30));
   // at this point:
-  // (31) [2] {
-  //      0     0    0 [  3    4   32   33   37    38    38
-  //     37    38   37   38   37   38   23   17    18    19
-  //     20    21   22   23   -1 ]  0    0    0     0     0
+  // (31) [1] {
+  //      0    0    0 [  3    4   32   34   27   28    8
+  //      7    8    7    8    7    8   23   17   18   19
+  //     20   21   22   23   -1 ]    0    0    0    0    0
   //      0
   //   }
 
   Test(actions::Add<Data_t>(27, { 7, 8, }, 20));
   // at this point:
   // (31) [2] {
-  //      0     0    0 [  3    4   32   33   37    38    38
-  //     37    38   37   38   37   38   23   17    18    19
-  //     20    21   22   23   -1 ]  0    0 [ 27    28 ]   0
+  //      0    0    0 [  3    4   32   34   27   28    8
+  //      7    8    7    8    7    8   23   17   18   19
+  //     20   21   22   23   -1 ]    0    0 [ 27   28 ]    0
   //      0
   //   }
 
@@ -1243,9 +1347,9 @@ int main() {
     (4, TestManagerClass<Data_t>::Vector_t(22, 10.0), 15.0));
   // at this point:
   // (31) [2] {
-  //      0     0    0 [  3   14   42   43   47    48    48
-  //     47    48   47   48   47   48   33   27    28    29
-  //     30    31   32   33    9   25 ]  0 [ 27    28 ]   0
+  //      0    0    0 [  3   14   42   44   37   38   18
+  //     17   18   17   18   17   18   33   27   28   29
+  //     30   31   32   33    9   25 ]    0 [ 27   28 ]    0
   //      0
   //   }
 
@@ -1253,18 +1357,18 @@ int main() {
     (2, TestManagerClass<Data_t>::Vector_t(22, -10.0), 12.0));
   // at this point:
   // (31) [2] {
-  //      0     0 [  2    3    4   32   33   37    38    38
-  //     37    38   37   38   37   38   23   17    18    19
-  //     20    21   22   23   -1   25 ]  0 [ 27    28 ]   0
+  //      0    0 [  2   -7    4   32   34   27   28    8
+  //      7    8    7    8    7    8   23   17   18   19
+  //     20   21   22   23    9   25 ]    0 [ 27   28 ]    0
   //      0
   //   }
 
   Test(actions::Add<Data_t>(26, { 16, 0 }, 10.0));
   // at this point:
-  // (31) [2] {
-  //      0     0 [  2    3    4   32   33   37    38    38
-  //     37    38   37   38   37   38   23   17    18    19
-  //     20    21   22   23   -1   25   26   27    28 ]   0
+  // (31) [1] {
+  //      0    0 [  2   -7    4   32   34   27   28    8
+  //      7    8    7    8    7    8   23   17   18   19
+  //     20   21   22   23    9   25   26   27   28 ]    0
   //      0
   //   }
 
@@ -1288,5 +1392,5 @@ int main() {
   Test.recover();
 #endif // SPARSE_VECTOR_TEST_FAIL
 
-  return Test.summary();
+  return Test.summary() + OptimizeTest();
 } // main()